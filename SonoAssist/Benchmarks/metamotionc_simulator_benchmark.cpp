@@ -0,0 +1,194 @@
+#include "MetaMotionCSimulator.h"
+
+#include <map>
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <condition_variable>
+
+#define BENCHMARK_DEFAULT_DURATION_S 5
+#define BENCHMARK_CONNECT_TIMEOUT_S 5
+#define BENCHMARK_FUSION_HZ 100
+#define BENCHMARK_PACKED_N_SAMPLES 3
+
+/**
+* Handler queue standing in for the BLE thread of (MetaWearBluetoothClient) : the transport queues the SDK handlers,
+* the benchmark thread runs them. The queueing time of every handler is recorded.
+*/
+class HandlerQueue {
+
+	public:
+
+		void push(std::function<void(void)> handler) {
+			{
+				std::lock_guard<std::mutex> queue_guard(m_queue_mtx);
+				m_handlers.push_back({std::chrono::steady_clock::now(), std::move(handler)});
+			}
+			m_queue_cv.notify_one();
+		}
+
+		/**
+		* Runs the queued handlers until the end time.
+		*/
+		void run_until(std::chrono::steady_clock::time_point end_time, const std::function<bool(void)>& done = nullptr) {
+
+			std::unique_lock<std::mutex> queue_lock(m_queue_mtx);
+			while (std::chrono::steady_clock::now() < end_time && !(done && done())) {
+
+				if (!m_queue_cv.wait_until(queue_lock, end_time, [this] { return !m_handlers.empty(); })) break;
+				auto queued_handler = std::move(m_handlers.front());
+				m_handlers.pop_front();
+				queue_lock.unlock();
+
+				m_queue_latencies_us.push_back(std::chrono::duration_cast<std::chrono::microseconds>(
+					std::chrono::steady_clock::now() - queued_handler.first).count());
+				queued_handler.second();
+
+				queue_lock.lock();
+
+			}
+
+		}
+
+		std::vector<int64_t> m_queue_latencies_us;
+
+	private:
+
+		std::mutex m_queue_mtx;
+		std::condition_variable m_queue_cv;
+		std::deque<std::pair<std::chrono::steady_clock::time_point, std::function<void(void)>>> m_handlers;
+
+};
+
+/**
+* Notifications received by the SDK notification handler, per (module, register)
+*/
+struct NotificationStats {
+	bool connected = false;
+	std::map<uint16_t, uint64_t> n_notifications;
+};
+
+int32_t notification_handler(const void* caller, const uint8_t* value, uint8_t length) {
+	NotificationStats* stats = static_cast<NotificationStats*>(const_cast<void*>(caller));
+	if (length >= 2) stats->n_notifications[(value[0] << 8) | value[1]]++;
+	return 0;
+}
+
+void notifications_ready(const void* caller, int32_t status) {}
+
+/**
+* Connects to the simulator of the url, subscribes to and starts the sensor fusion (euler angles, linear acceleration)
+* and the packed accelerometer / gyroscope signals (the writes of the SDK), then receives the notifications for the duration.
+*/
+bool run_simulator(const std::string& url, double duration_s, NotificationStats& stats, HandlerQueue& handler_queue, std::string& simulator_stats) {
+
+	auto simulator_p = std::make_shared<MetaMotionCSimulator>(url);
+	simulator_p->set_dispatcher([&handler_queue](std::function<void(void)> handler) { handler_queue.push(std::move(handler)); });
+
+	simulator_p->connect_transport([&stats](bool connected) { stats.connected = connected; });
+	handler_queue.run_until(std::chrono::steady_clock::now() + std::chrono::seconds(BENCHMARK_CONNECT_TIMEOUT_S),
+		[&stats] { return stats.connected; });
+	if (!stats.connected) return false;
+
+	MblMwGattChar notify_char = {};
+	simulator_p->enable_notifications(&stats, &notify_char, notification_handler, notifications_ready);
+
+	// (module, register, enable) commands : subscriptions first, then the module power
+	const std::vector<std::vector<uint8_t>> start_commands = {
+		{0x19, 0x08, 0x01}, {0x19, 0x0A, 0x01}, {0x19, 0x01, 0x01},
+		{0x03, 0x1C, 0x01}, {0x03, 0x01, 0x01},
+		{0x13, 0x07, 0x01}, {0x13, 0x01, 0x01}
+	};
+	for (const auto& command : start_commands) {
+		simulator_p->write_gatt_char(MBL_MW_GATT_CHAR_WRITE_WITHOUT_RESPONSE, &notify_char, command.data(), static_cast<uint8_t>(command.size()));
+	}
+
+	handler_queue.m_queue_latencies_us.clear();
+	handler_queue.run_until(std::chrono::steady_clock::now() + std::chrono::microseconds(static_cast<int64_t>(duration_s * 1e6)));
+
+	simulator_p->disconnect_transport();
+	simulator_stats = simulator_p->get_stats();
+	return true;
+
+}
+
+void print_stream(const std::string& stream_name, const NotificationStats& stats, uint16_t key, int samples_per_notification,
+	double expected_hz, double duration_s) {
+
+	auto notifications_it = stats.n_notifications.find(key);
+	uint64_t n_notifications = (notifications_it == stats.n_notifications.end()) ? 0 : notifications_it->second;
+	double sample_rate = n_notifications * samples_per_notification / duration_s;
+
+	std::printf("%s : %llu notifications, %.1f samples / s (%.1f %% of %.0f Hz)\n", stream_name.c_str(), (unsigned long long)n_notifications,
+		sample_rate, 100.0 * sample_rate / expected_hz, expected_hz);
+
+}
+
+/**
+* Throughput of the MetaMotionC simulator path (MetaMotionCSimulator through the MetaWearTransport interface), without
+* a board, the Qt BLE stack or the MetaWear SDK : the delivered sample rates of every stream and the queueing time of the
+* handlers on the receiving thread. Without url, the raw rate is swept from 100 Hz to 1.6 kHz, then run with losses.
+*
+* usage : metamotionc_simulator_benchmark [duration (s)] [simulator url]
+*/
+int main(int argc, char* argv[]) {
+
+	double duration_s = (argc > 1) ? std::atof(argv[1]) : BENCHMARK_DEFAULT_DURATION_S;
+	if (duration_s <= 0) duration_s = BENCHMARK_DEFAULT_DURATION_S;
+
+	std::vector<std::string> urls;
+	if (argc > 2) {
+		urls.push_back(argv[2]);
+	} else {
+		std::string fusion_param = "fusion_hz=" + std::to_string(BENCHMARK_FUSION_HZ);
+		for (int raw_hz : {100, 400, 800, 1600}) {
+			urls.push_back(std::string(SIMULATOR_URL_PREFIX) + "?" + fusion_param + "&raw_hz=" + std::to_string(raw_hz));
+		}
+		urls.push_back(std::string(SIMULATOR_URL_PREFIX) + "?" + fusion_param + "&raw_hz=800&loss=0.1&burst_every=1000&burst_ms=100");
+	}
+
+	for (const std::string& url : urls) {
+
+		NotificationStats stats;
+		HandlerQueue handler_queue;
+		std::string simulator_stats;
+
+		std::printf("%s\n", url.c_str());
+		if (!run_simulator(url, duration_s, stats, handler_queue, simulator_stats)) {
+			std::printf("connection failed\n");
+			continue;
+		}
+
+		// the expected rates (defaults of the simulator when missing from the url)
+		double fusion_hz = SIMULATOR_DEFAULT_FUSION_RATE, raw_hz = SIMULATOR_DEFAULT_RAW_RATE;
+		size_t raw_param = url.find("raw_hz=");
+		if (raw_param != std::string::npos) raw_hz = std::atof(url.c_str() + raw_param + 7);
+		size_t fusion_param = url.find("fusion_hz=");
+		if (fusion_param != std::string::npos) fusion_hz = std::atof(url.c_str() + fusion_param + 10);
+
+		print_stream("euler angles", stats, 0x1908, 1, fusion_hz, duration_s);
+		print_stream("linear acceleration", stats, 0x190A, 1, fusion_hz, duration_s);
+		print_stream("packed accelerometer", stats, 0x031C, BENCHMARK_PACKED_N_SAMPLES, raw_hz, duration_s);
+		print_stream("packed gyroscope", stats, 0x1307, BENCHMARK_PACKED_N_SAMPLES, raw_hz, duration_s);
+
+		std::vector<int64_t>& latencies = handler_queue.m_queue_latencies_us;
+		if (!latencies.empty()) {
+			std::sort(latencies.begin(), latencies.end());
+			std::printf("handler queueing (us) : p50 %lld, p99 %lld, max %lld (%.0f handlers / s)\n", (long long)latencies[latencies.size() / 2],
+				(long long)latencies[latencies.size() * 99 / 100], (long long)latencies.back(), latencies.size() / duration_s);
+		}
+		std::printf("%s\n", simulator_stats.c_str());
+
+	}
+
+	return 0;
+
+}
\ No newline at end of file
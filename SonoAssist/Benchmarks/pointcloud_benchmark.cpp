@@ -0,0 +1,101 @@
+#include "PointCloudGenerator.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+
+#include <librealsense2/rs.hpp>
+
+// maximum wait for the next playback frameset (ms), the end of the file is assumed past it
+#define PLAYBACK_FRAME_TIMEOUT 1000
+
+/**
+* Point cloud generation statistics of one pass over the recording
+*/
+struct PassStats {
+	size_t n_frames = 0;
+	size_t n_points = 0;
+	double generation_time = 0;
+};
+
+/**
+* Plays the recording back as fast as it is consumed (no real time) and generates the point cloud of every depth frame.
+*/
+PassStats run_pass(const std::string& bag_file_path, float voxel_size) {
+
+	rs2::config playback_cfg;
+	playback_cfg.enable_device_from_file(bag_file_path, false);
+	playback_cfg.enable_stream(RS2_STREAM_DEPTH);
+
+	rs2::pipeline playback_pipe;
+	playback_pipe.start(playback_cfg);
+	playback_pipe.get_active_profile().get_device().as<rs2::playback>().set_real_time(false);
+
+	PassStats stats;
+	PointCloudGenerator pointcloud_generator;
+	std::vector<float> xyz;
+	rs2::frameset frameset;
+
+	while (playback_pipe.try_wait_for_frames(&frameset, PLAYBACK_FRAME_TIMEOUT)) {
+
+		rs2::depth_frame depth_frame = frameset.get_depth_frame();
+		if (!depth_frame) continue;
+
+		// timing the generation only (the intrinsics lookup table is built once)
+		pointcloud_generator.set_intrinsics(depth_frame.get_profile().as<rs2::video_stream_profile>().get_intrinsics());
+		auto start = std::chrono::steady_clock::now();
+		stats.n_points += pointcloud_generator.generate(static_cast<const uint16_t*>(depth_frame.get_data()), depth_frame.get_stride_in_bytes(),
+			depth_frame.get_units(), voxel_size, xyz);
+		stats.generation_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		stats.n_frames++;
+
+	}
+
+	playback_pipe.stop();
+	return stats;
+
+}
+
+/**
+* Measures the point cloud generation throughput (PointCloudGenerator) on the depth stream of a recorded .bag file,
+* without downsampling and for each of the provided voxel sizes.
+*
+* usage : pointcloud_benchmark <bag file> [voxel size (m)] ...
+*/
+int main(int argc, char* argv[]) {
+
+	if (argc < 2) {
+		std::printf("usage : pointcloud_benchmark <bag file> [voxel size (m)] ...\n");
+		return 1;
+	}
+
+	std::string bag_file_path = argv[1];
+	std::vector<float> voxel_sizes = {0};
+	for (int i = 2; i < argc; i++) voxel_sizes.push_back(static_cast<float>(std::atof(argv[i])));
+
+	std::printf("voxel size (m), frames, points per frame, generation time per frame (ms), frames per second, million points per second\n");
+
+	try {
+		for (float voxel_size : voxel_sizes) {
+
+			PassStats stats = run_pass(bag_file_path, voxel_size);
+			if (stats.n_frames == 0 || stats.generation_time <= 0) {
+				std::printf("%.4f, no depth frames\n", voxel_size);
+				continue;
+			}
+
+			std::printf("%.4f, %zu, %.0f, %.3f, %.1f, %.2f\n", voxel_size, stats.n_frames, double(stats.n_points) / stats.n_frames,
+				1000 * stats.generation_time / stats.n_frames, stats.n_frames / stats.generation_time, stats.n_points / stats.generation_time / 1e6);
+
+		}
+	} catch (const std::exception& e) {
+		std::printf("playback error : %s\n", e.what());
+		return 1;
+	}
+
+	return 0;
+
+}
\ No newline at end of file
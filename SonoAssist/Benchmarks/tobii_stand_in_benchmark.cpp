@@ -0,0 +1,119 @@
+#include <tobii/tobii.h>
+#include <tobii/tobii_streams.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+
+#define BENCHMARK_DEFAULT_DURATION_S 5
+#define BENCHMARK_HEAD_HZ 30
+
+/**
+* Delivery statistics of a stream (latency : reception time - sample timestamp, system clock domain)
+*/
+struct StreamStats {
+	int64_t callbacks_time_us = 0;
+	std::vector<int64_t> latencies_us;
+};
+
+void gaze_point_callback(tobii_gaze_point_t const* gaze_point, void* user_data) {
+	StreamStats* stats = static_cast<StreamStats*>(user_data);
+	if (gaze_point->validity == TOBII_VALIDITY_VALID) stats->latencies_us.push_back(stats->callbacks_time_us - gaze_point->timestamp_us);
+}
+
+void head_pose_callback(tobii_head_pose_t const* head_pose, void* user_data) {
+	StreamStats* stats = static_cast<StreamStats*>(user_data);
+	if (head_pose->position_validity == TOBII_VALIDITY_VALID) stats->latencies_us.push_back(stats->callbacks_time_us - head_pose->timestamp_us);
+}
+
+/**
+* Streams from the device of the url for the duration, with the collection loop of the GazeTracker
+* (wait for callbacks, sample the reception time, process the callbacks).
+*/
+bool run_device(tobii_api_t* api, const std::string& url, double duration_s, StreamStats& gaze_stats, StreamStats& head_stats) {
+
+	tobii_device_t* device = nullptr;
+	if (tobii_device_create(api, url.c_str(), TOBII_FIELD_OF_USE_INTERACTIVE, &device) != TOBII_ERROR_NO_ERROR) return false;
+	tobii_gaze_point_subscribe(device, gaze_point_callback, &gaze_stats);
+	tobii_head_pose_subscribe(device, head_pose_callback, &head_stats);
+
+	auto end_time = std::chrono::steady_clock::now() + std::chrono::duration<double>(duration_s);
+	while (std::chrono::steady_clock::now() < end_time) {
+		tobii_wait_for_callbacks(1, &device);
+		int64_t callbacks_time_us = 0;
+		tobii_system_clock(api, &callbacks_time_us);
+		gaze_stats.callbacks_time_us = callbacks_time_us;
+		head_stats.callbacks_time_us = callbacks_time_us;
+		tobii_device_process_callbacks(device);
+	}
+
+	tobii_head_pose_unsubscribe(device);
+	tobii_gaze_point_unsubscribe(device);
+	tobii_device_destroy(device);
+	return true;
+
+}
+
+void print_stats(const std::string& stream_name, StreamStats& stats, double duration_s) {
+
+	if (stats.latencies_us.empty()) {
+		std::printf("%s : no samples\n", stream_name.c_str());
+		return;
+	}
+
+	std::sort(stats.latencies_us.begin(), stats.latencies_us.end());
+	double mean_latency = 0;
+	for (int64_t latency : stats.latencies_us) mean_latency += latency;
+	mean_latency /= stats.latencies_us.size();
+
+	std::printf("%s : %zu samples (%.1f Hz), latency (us) mean %.0f, p99 %lld, max %lld\n", stream_name.c_str(), stats.latencies_us.size(),
+		stats.latencies_us.size() / duration_s, mean_latency, (long long)stats.latencies_us[stats.latencies_us.size() * 99 / 100],
+		(long long)stats.latencies_us.back());
+
+}
+
+/**
+* Load test of the gaze ingestion loop against the Tobii Stream Engine stand-in (TobiiStandIn), reporting the delivered
+* sample rates and the delivery latencies. Without url, synthetic streams are swept from 90 Hz to 2 kHz of gaze points.
+*
+* usage : tobii_stand_in_benchmark [duration (s)] [stand-in url]
+*/
+int main(int argc, char* argv[]) {
+
+	double duration_s = (argc > 1) ? std::atof(argv[1]) : BENCHMARK_DEFAULT_DURATION_S;
+	if (duration_s <= 0) duration_s = BENCHMARK_DEFAULT_DURATION_S;
+
+	std::vector<std::string> urls;
+	if (argc > 2) {
+		urls.push_back(argv[2]);
+	} else {
+		for (int gaze_hz : {90, 250, 500, 1000, 2000}) {
+			urls.push_back("tobii-stand-in://synthetic?gaze_hz=" + std::to_string(gaze_hz) + "&head_hz=" + std::to_string(BENCHMARK_HEAD_HZ));
+		}
+	}
+
+	tobii_api_t* api = nullptr;
+	if (tobii_api_create(&api, NULL, NULL) != TOBII_ERROR_NO_ERROR) return 1;
+
+	for (const std::string& url : urls) {
+
+		StreamStats gaze_stats, head_stats;
+		std::printf("%s\n", url.c_str());
+		if (!run_device(api, url, duration_s, gaze_stats, head_stats)) {
+			std::printf("device creation failed\n");
+			continue;
+		}
+
+		print_stats("gaze points", gaze_stats, duration_s);
+		print_stats("head poses", head_stats, duration_s);
+
+	}
+
+	tobii_api_destroy(api);
+	return 0;
+
+}
\ No newline at end of file
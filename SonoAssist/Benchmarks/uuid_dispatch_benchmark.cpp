@@ -0,0 +1,79 @@
+#include "UuidHashTable.h"
+
+#include <map>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+
+#include <QString>
+#include <QtBluetooth/QBluetoothUuid>
+
+#define BENCHMARK_DEFAULT_N_NOTIFICATIONS 1000000
+
+// characteristics registered by the MetaWear SDK (notifications, command, battery and device information)
+#define METAWEAR_NOTIFY_CHAR "{326a9006-85cb-9195-d9dd-464cfbbae75a}"
+const char* REGISTERED_CHARS[] = {
+	METAWEAR_NOTIFY_CHAR,
+	"{326a9001-85cb-9195-d9dd-464cfbbae75a}",
+	"{00002a19-0000-1000-8000-00805f9b34fb}",
+	"{00002a24-0000-1000-8000-00805f9b34fb}",
+	"{00002a26-0000-1000-8000-00805f9b34fb}",
+	"{00002a27-0000-1000-8000-00805f9b34fb}"
+};
+
+using notification_handler = void (*)(void* context, const uint8_t* value, int length);
+
+void count_notification(void* context, const uint8_t* value, int length) {
+	(void)value;
+	*static_cast<uint64_t*>(context) += length;
+}
+
+/**
+* Measures the cost of dispatching a characteristic notification to its handler (lookup + call), with the
+* characteristic uuid as a key of the UuidHashTable (MetaWearBluetoothClient::service_characteristic_changed)
+* and as a QString key of a std::map (previous implementation).
+*
+* usage : uuid_dispatch_benchmark [n_notifications]
+*/
+int main(int argc, char* argv[]) {
+
+	int n_notifications = (argc > 1) ? std::max(1, std::atoi(argv[1])) : BENCHMARK_DEFAULT_N_NOTIFICATIONS;
+
+	// registering the handlers
+	uint64_t map_bytes = 0, table_bytes = 0;
+	std::map<QString, notification_handler> handler_map;
+	UuidHashTable<notification_handler> handler_table;
+	for (const char* char_uuid_str : REGISTERED_CHARS) {
+		QBluetoothUuid char_uuid = QBluetoothUuid(QString(char_uuid_str));
+		handler_map[char_uuid.toString()] = count_notification;
+		handler_table.insert(Uuid128::from_bytes(char_uuid.toUInt128().data), count_notification);
+	}
+
+	// the notifications come from the notify characteristic (fusion packets)
+	QBluetoothUuid notify_uuid = QBluetoothUuid(QString(METAWEAR_NOTIFY_CHAR));
+	uint8_t packet[20] = {0};
+
+	auto map_start = std::chrono::steady_clock::now();
+	for (int i = 0; i < n_notifications; i++) {
+		auto map_entry = handler_map.find(notify_uuid.toString());
+		if (map_entry != handler_map.end()) map_entry->second(&map_bytes, packet, sizeof(packet));
+	}
+	double map_time = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - map_start).count();
+
+	auto table_start = std::chrono::steady_clock::now();
+	for (int i = 0; i < n_notifications; i++) {
+		const notification_handler* handler = handler_table.find(Uuid128::from_bytes(notify_uuid.toUInt128().data));
+		if (handler != nullptr) (*handler)(&table_bytes, packet, sizeof(packet));
+	}
+	double table_time = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - table_start).count();
+
+	std::printf("registered characteristics : %zu, notifications : %d\n", handler_table.size(), n_notifications);
+	std::printf("std::map<QString> dispatch : %.1f ns per notification\n", map_time / n_notifications);
+	std::printf("UuidHashTable dispatch : %.1f ns per notification\n", table_time / n_notifications);
+
+	// both paths must have dispatched every notification
+	return (map_bytes == table_bytes) ? 0 : 1;
+
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include "WorkerPool.h"
+#include "TiledConversion.h"
+
+#include <chrono>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include <opencv2/opencv.hpp>
+
+// screen capture downscaling (redis output of the ScreenRecorder)
+#define BENCHMARK_RESIZE_FACTOR 2
+#define BENCHMARK_DEFAULT_N_FRAMES 50
+
+/**
+* Sweeps the capture resolution and the number of conversion threads of the ScreenRecorder conversion
+* (convert_bgra_tiles : BGRA -> BGR + downscaled gray copy) and reports the conversion time per frame.
+*
+* usage : worker_pool_benchmark [n_frames]
+*/
+int main(int argc, char* argv[]) {
+
+	int n_frames = (argc > 1) ? std::max(1, std::atoi(argv[1])) : BENCHMARK_DEFAULT_N_FRAMES;
+
+	// 1080p, 1440p, 4K and two side by side 4K monitors
+	std::vector<cv::Size> resolutions = {{1920, 1080}, {2560, 1440}, {3840, 2160}, {7680, 2160}};
+
+	// 1, 2, 4 ... threads, up to the number of hardware threads
+	int n_hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<int> thread_counts;
+	for (int n_threads = 1; n_threads < n_hardware_threads; n_threads *= 2) thread_counts.push_back(n_threads);
+	thread_counts.push_back(n_hardware_threads);
+
+	std::printf("resolution, threads, conversion time (ms), speedup\n");
+
+	for (const cv::Size& resolution : resolutions) {
+
+		// random capture content (the conversion cost does not depend on it)
+		cv::Mat capture_mat(resolution, CV_8UC4);
+		cv::randu(capture_mat, cv::Scalar::all(0), cv::Scalar::all(255));
+		cv::Mat cvt_mat(resolution, CV_8UC3);
+		cv::Mat resized_mat(resolution / BENCHMARK_RESIZE_FACTOR, CV_8UC1);
+
+		double single_thread_time = 0;
+		for (int n_threads : thread_counts) {
+
+			WorkerPool worker_pool(n_threads);
+
+			// warm up (page faults of the outputs, worker wake ups)
+			convert_bgra_tiles(worker_pool, capture_mat, cvt_mat, &resized_mat, BENCHMARK_RESIZE_FACTOR);
+
+			auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < n_frames; i++) {
+				convert_bgra_tiles(worker_pool, capture_mat, cvt_mat, &resized_mat, BENCHMARK_RESIZE_FACTOR);
+			}
+			double frame_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / n_frames;
+			if (n_threads == 1) single_thread_time = frame_time;
+
+			std::printf("%dx%d, %d, %.2f, %.2f\n", resolution.width, resolution.height, n_threads, frame_time, single_thread_time / frame_time);
+
+		}
+
+	}
+
+	return 0;
+
+}
\ No newline at end of file
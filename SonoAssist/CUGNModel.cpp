@@ -1,10 +1,12 @@
 #include "CUGNModel.h"
 
 CUGNModel::CUGNModel(int model_id, std::string model_description, std::string model_status_entry,
-	std::string redis_state_entry, std::string model_path_entry, std::string log_file_path, std::shared_ptr<ScreenRecorder> sc_p):
+	std::string redis_state_entry, std::string model_path_entry, std::string log_file_path,
+	std::shared_ptr<ScreenRecorder> sc_p, std::shared_ptr<ClariusProbeClient> us_probe_p):
 	MLModel(model_id, model_description, model_status_entry, redis_state_entry, model_path_entry, log_file_path){
 
 	m_sc_p = sc_p;
+	m_us_probe_p = us_probe_p;
 
 	// model's default movement input
 	m_default_mov_tensor = torch::zeros({1, 1, 3}, torch::TensorOptions().dtype(torch::kFloat32));
@@ -42,9 +44,13 @@ void CUGNModel::start_stream(void) {
 			int cugn_sc_in_w = std::atoi((*m_config_ptr)["cugn_input_w"].c_str());
 			m_cugn_sc_in_dims = cv::Size(cugn_sc_in_w, cugn_sc_in_h);
 
-			// preparing the image handlingmats + automatic usimage detection
+			// preparing the image source, the image input tensors + automatic usimage detection
+			select_input_source();
 			m_us_img_detector = USImgDetector((*m_config_ptr)["cugn_us_template"]);
-			m_sc_masked, m_sc_redim = cv::Mat::zeros(m_cugn_sc_in_dims, 0);
+			for (auto& input_slot : m_input_slots) {
+				input_slot.img_tensor = torch::zeros({1, 1, 1, cugn_sc_in_h, cugn_sc_in_w}, torch::TensorOptions().dtype(torch::kFloat32));
+			}
+			m_preprocess_benchmark = (*m_config_ptr)["cugn_preprocess_benchmark"] == "true";
 
 			// defining the model's starting hidden state input
 			int n_gru_cells = std::atoi((*m_config_ptr)["cugn_n_gru_cells"].c_str());
@@ -56,10 +62,35 @@ void CUGNModel::start_stream(void) {
 			write_debug_output("Invalid model pipeline parameters");
 		}
 
-		// launching the model evaluation
+		// launching the model evaluation, then the preprocessing once the model is warmed up (on the evaluation thread)
 		if (valid_params) {
+
+			// resetting the handoff + pipeline stats
+			m_write_slot = 0, m_pending_slot = 1, m_eval_slot = 2;
+			m_pending_ready = false;
+			m_warmup_done = m_warmup_valid = false;
+			m_n_preprocess_skips = m_n_inference_skips = m_n_stale_skips = m_n_predictions = m_n_deadline_misses = 0;
+			m_preprocess_latencies.clear(), m_handoff_latencies.clear(), m_postprocess_latencies.clear(), m_sample_latencies.clear();
+
 			m_stream_status = true;
 			m_eval_thread = std::thread(&CUGNModel::eval, this);
+			{
+				std::unique_lock<std::mutex> handoff_lock(m_handoff_mtx);
+				m_handoff_cv.wait(handoff_lock, [this] { return m_warmup_done; });
+			}
+
+			// the evaluation thread exits when the warmup failed
+			if (!m_warmup_valid) {
+				m_stream_status = false;
+				m_eval_thread.join();
+				disconnect_from_redis();
+				write_debug_output("The model could not be warmed up, the evaluation is not started");
+				return;
+			}
+
+			m_pipeline_start = std::chrono::steady_clock::now();
+			m_preprocess_thread = std::thread(&CUGNModel::preprocess, this);
+
 		}
 		
 	}
@@ -69,9 +100,21 @@ void CUGNModel::start_stream(void) {
 void CUGNModel::stop_stream(void) {
     
     if (m_stream_status) {
-		m_stream_status = false;
+
+		// the status is changed under the handoff lock so that the inference stage cannot miss the wake up
+		{
+			std::lock_guard<std::mutex> handoff_guard(m_handoff_mtx);
+			m_stream_status = false;
+		}
+		m_handoff_cv.notify_all();
+
+		m_preprocess_thread.join();
 		m_eval_thread.join();
 		disconnect_from_redis();
+
+		report_pipeline_stats();
+		report_inference_latency();
+
     }
 
 }
@@ -80,87 +123,189 @@ void CUGNModel::stop_stream(void) {
 * MODEL INFERANCE AND US IMAGE DETECTION
 ******************************************************************************/
 
-void CUGNModel::eval() {
-
-	cv::Mat sc_input;
-	int input_counter = 0;
-	at::Tensor hx_tensor = m_start_hx_tensor;
+void CUGNModel::preprocess(void) {
 
 	detect_us_image();
+	if (m_preprocess_benchmark) benchmark_preprocessing();
+
+	uint64_t last_frame_id = 0;
+	auto sampling_period = std::chrono::milliseconds(m_sampling_period_ms);
+	auto sample_time = std::chrono::steady_clock::now();
+	m_pipeline_start = sample_time;
+
+	while (m_stream_status) {
+
+		std::this_thread::sleep_until(sample_time);
+		if (!m_stream_status) break;
+
+		// a change of the image geometry invalidates the detected region + mask
+		// (the probe images keep their dimensions when the depth / zoom changes, only their scale changes)
+		cv::Size source_size = m_input_frames_p->get_source_size();
+		bool geometry_changed = source_size.area() > 0 && source_size != m_input_frame_size;
+		if (m_probe_input) geometry_changed |= m_us_probe_p->get_microns_per_pixel() != m_input_microns_per_pixel;
+		if (geometry_changed) {
+			write_debug_output("Image source geometry changed");
+			detect_us_image();
+			sample_time = std::chrono::steady_clock::now();
+			continue;
+		}
 
-    while (m_stream_status) {
-		
 		bool valid_preprocess = false;
-		auto eval_start = std::chrono::high_resolution_clock::now();
+		auto preprocess_start = std::chrono::steady_clock::now();
+		CUGNInputSlot& input_slot = m_input_slots[m_write_slot];
 
-		// preprocessing the screen recorder input
+		// preprocessing the latest image (the same image is never evaluated twice)
 		try {
 
-			// fetching the capture, extracting the AOI and resizing
-			sc_input = m_sc_p->get_lastest_acquisition(m_sc_roi);
-			cv::cvtColor(sc_input, sc_input, CV_BGRA2GRAY);
-			cv::resize(sc_input, m_sc_redim, m_cugn_sc_in_dims, 0, 0, cv::INTER_AREA);
-				
-			// applying the US shape mask
-			m_sc_redim.copyTo(m_sc_masked, m_sc_mask);
+			uint64_t frame_id = m_input_frames_p->get_frame_id();
+			if (frame_id != last_frame_id) {
 
-			valid_preprocess = true;
+				// fetching the AOI of the latest image (no copy) and converting it in to the slot's input tensor
+				cv::Mat roi_img = m_input_frames_p->get_source(m_input_roi);
+				valid_preprocess = m_input_preprocessor.process(roi_img, input_slot.img_tensor.data_ptr<float>());
+				last_frame_id = frame_id;
+
+			} else {
+				m_n_stale_skips++;
+			}
 
 		} catch (...) {
 			valid_preprocess = false;
-			write_debug_output("Failed during screen reocorder input processing");
+			write_debug_output("Failed during input image processing");
 		}
-		
-		// feeding inputs to the model + writing to redis
+
+		// handing the input over to the inference stage
 		if (valid_preprocess) {
+			input_slot.sample_time = sample_time;
+			input_slot.ready_time = std::chrono::steady_clock::now();
+			m_preprocess_latencies.push_back(std::chrono::duration<float, std::milli>(input_slot.ready_time - preprocess_start).count());
+			hand_over_input();
+		}
+
+		// scheduling the next sample, samples overrun by a whole period are skipped (no burst to catch up)
+		sample_time += sampling_period;
+		auto current_time = std::chrono::steady_clock::now();
+		while (sample_time + sampling_period <= current_time) {
+			sample_time += sampling_period;
+			m_n_preprocess_skips++;
+		}
+
+	}
+
+}
+
+void CUGNModel::hand_over_input(void) {
+
+	{
+		std::lock_guard<std::mutex> handoff_guard(m_handoff_mtx);
+		if (m_pending_ready) m_n_inference_skips++;
+		std::swap(m_write_slot, m_pending_slot);
+		m_pending_ready = true;
+	}
+
+	m_handoff_cv.notify_one();
+
+}
+
+void CUGNModel::eval(void) {
+
+	// thread setup + warming up the model on blank inputs (before the first sample is handed over)
+	bool valid_warmup = false;
+	try {
+		init_inference_thread();
+		valid_warmup = warmup({m_input_slots[m_eval_slot].img_tensor, m_start_hx_tensor, m_default_mov_tensor});
+	} catch (...) {
+		write_debug_output("Failed to set up the inference thread");
+	}
+
+	// start_stream is waiting, whatever the outcome
+	{
+		std::lock_guard<std::mutex> handoff_guard(m_handoff_mtx);
+		m_warmup_done = true;
+		m_warmup_valid = valid_warmup;
+	}
+	m_handoff_cv.notify_all();
+	if (!valid_warmup) return;
 
-			try {
-				
-				// converting to tensor, normalizing and feeding the model
-				at::Tensor sc_img_tensor = torch::from_blob(m_sc_masked.data,
-					{1, 1, 1, m_sc_masked.rows, m_sc_masked.cols}, at::kByte).to(torch::kFloat32);
-				sc_img_tensor = sc_img_tensor.sub(m_pix_mean).div(m_pix_std_div);
-				
-				// evaluating the model
-				c10::IValue model_output = m_model.forward(
-					std::vector<torch::jit::IValue>{sc_img_tensor, hx_tensor, m_default_mov_tensor});
-				c10::ivalue::Tuple& model_output_tuple = model_output.toTupleRef();			
-				
-				// defining the next hidden state
-				if (input_counter < m_sequence_len) {
-					hx_tensor = model_output_tuple.elements()[1].toTensor().detach().clone();
-					input_counter ++;
-				} else {
-					hx_tensor = m_start_hx_tensor;
-					input_counter = 0;
-				}
-				
-				// extracting the prediction + writing to redis
-
-				at::Tensor mov_pred_tensor = model_output_tuple.elements()[0].toTensor().detach();
-				float x_rot_pred = mov_pred_tensor[0][0][0].item<float>();
-				float y_rot_pred = mov_pred_tensor[0][0][1].item<float>();
-				float z_rot_pred = mov_pred_tensor[0][0][2].item<float>();
-				
-				if (m_redis_state) {
-					std::string model_rot_pred_str = std::to_string(x_rot_pred) +
-						"," + std::to_string(y_rot_pred) + "," + std::to_string(z_rot_pred);
-					write_str_to_redis(m_redis_pred_entry, model_rot_pred_str);
-				}
-				
-			} catch (std::exception e) {
-				write_debug_output("Failed during model evaluation : " + QString::fromStdString(e.what()));
+	int input_counter = 0;
+	at::Tensor hx_tensor = m_start_hx_tensor;
+	auto sampling_period = std::chrono::milliseconds(m_sampling_period_ms);
+
+	while (true) {
+
+		// waiting for the next input
+		{
+			std::unique_lock<std::mutex> handoff_lock(m_handoff_mtx);
+			m_handoff_cv.wait(handoff_lock, [this] { return m_pending_ready || !m_stream_status; });
+			if (!m_stream_status) break;
+			std::swap(m_eval_slot, m_pending_slot);
+			m_pending_ready = false;
+		}
+
+		CUGNInputSlot& input_slot = m_input_slots[m_eval_slot];
+		auto eval_start = std::chrono::steady_clock::now();
+		m_handoff_latencies.push_back(std::chrono::duration<float, std::milli>(eval_start - input_slot.ready_time).count());
+
+		// feeding inputs to the model + writing to redis
+		try {
+			
+			// evaluating the model
+			c10::IValue model_output = run_inference({input_slot.img_tensor, hx_tensor, m_default_mov_tensor});
+			c10::ivalue::Tuple& model_output_tuple = model_output.toTupleRef();
+			auto inference_end = std::chrono::steady_clock::now();
+			
+			// defining the next hidden state
+			if (input_counter < m_sequence_len) {
+				hx_tensor = model_output_tuple.elements()[1].toTensor().detach().clone();
+				input_counter ++;
+			} else {
+				hx_tensor = m_start_hx_tensor;
+				input_counter = 0;
 			}
 			
+			// extracting the prediction (single read of the contiguous output) + writing to redis
+			at::Tensor mov_pred_tensor = model_output_tuple.elements()[0].toTensor().detach().contiguous();
+			const float* mov_pred = mov_pred_tensor.data_ptr<float>();
+			
+			if (m_redis_state) {
+				std::string model_rot_pred_str = std::to_string(mov_pred[0]) +
+					"," + std::to_string(mov_pred[1]) + "," + std::to_string(mov_pred[2]);
+				write_str_to_redis(m_redis_pred_entry, model_rot_pred_str);
+			}
+
+			// deadline accounting : the prediction must be available before the next sample is due
+			auto sample_end = std::chrono::steady_clock::now();
+			m_postprocess_latencies.push_back(std::chrono::duration<float, std::milli>(sample_end - inference_end).count());
+			m_sample_latencies.push_back(std::chrono::duration<float, std::milli>(sample_end - input_slot.sample_time).count());
+			if (sample_end > input_slot.sample_time + sampling_period) m_n_deadline_misses++;
+			m_n_predictions++;
+			
+		} catch (std::exception e) {
+			write_debug_output("Failed during model evaluation : " + QString::fromStdString(e.what()));
 		}
 
-		auto eval_end = std::chrono::high_resolution_clock::now();
-		auto eval_time = std::chrono::duration_cast<std::chrono::milliseconds>(eval_end - eval_start).count();
-		auto thread_wait_time = m_sampling_period_ms - eval_time;
-		if (thread_wait_time < 0) thread_wait_time = 0;
-		std::this_thread::sleep_for(std::chrono::milliseconds(thread_wait_time));
+	}
+
+}
 
-    }
+void CUGNModel::report_pipeline_stats(void) {
+
+	float elapsed_time = std::chrono::duration<float>(std::chrono::steady_clock::now() - m_pipeline_start).count();
+	float achieved_frequency = (elapsed_time > 0) ? m_n_predictions / elapsed_time : 0;
+
+	write_debug_output("Pipeline : " + QString::number(m_n_predictions) + " predictions, achieved frequency "
+		+ QString::number(achieved_frequency, 'f', 2) + " Hz (target " + QString::number(1000.0 / m_sampling_period_ms, 'f', 2) + " Hz), skipped samples "
+		+ QString::number(m_n_preprocess_skips) + " (preprocessing overrun) + " + QString::number(m_n_inference_skips) + " (inference overrun) + "
+		+ QString::number(m_n_stale_skips) + " (no new image), deadline misses "
+		+ QString::number(m_n_deadline_misses));
+
+	auto format_latencies = [](std::vector<float>& latencies) {
+		return QString::number(get_percentile(latencies, 0.50f), 'f', 2) + " / " + QString::number(get_percentile(latencies, 0.99f), 'f', 2);
+	};
+
+	write_debug_output("Stage latencies p50 / p99 (ms) : preprocessing " + format_latencies(m_preprocess_latencies)
+		+ ", handoff wait " + format_latencies(m_handoff_latencies) + ", postprocessing " + format_latencies(m_postprocess_latencies)
+		+ ", sample to prediction " + format_latencies(m_sample_latencies));
 
 }
 
@@ -171,25 +316,35 @@ void CUGNModel::detect_us_image(void) {
 
 	while (m_stream_status && !us_img_detected) {
 	
-		// trying to detect a US image in the screen recorder stream
-		cv::Mat sc_input = m_sc_p->get_lastest_acquisition();
-		ImgDetectData detection_data = m_us_img_detector.detect(sc_input);
+		// trying to detect a US image in the latest image (the detection + display require a color image)
+		// the probe image scale is read first, a change during the detection triggers an other one
+		double microns_per_pixel = m_probe_input ? m_us_probe_p->get_microns_per_pixel() : 0;
+		cv::Mat detection_input = m_input_frames_p->get_source().clone();
+		if (detection_input.empty()) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(MODEL_DETECTION_DELAY_MS));
+			continue;
+		}
+		if (detection_input.channels() == 1) cv::cvtColor(detection_input, detection_input, CV_GRAY2BGR);
+		ImgDetectData detection_data = m_us_img_detector.detect(detection_input);
 
 		if (detection_data.detected) {
 
 			us_img_detected = true;
-			m_sc_roi = detection_data.bounding_box;
+			m_input_roi = detection_data.bounding_box;
+			m_input_frame_size = detection_input.size();
+			m_input_microns_per_pixel = microns_per_pixel;
 
 			// formating the detected mask
-			m_sc_mask = detection_data.mask;
-			cv::resize(m_sc_mask, m_sc_mask, m_cugn_sc_in_dims, 0, 0, cv::INTER_AREA);
-			cv::threshold(m_sc_mask, m_sc_mask, 0, 255, cv::THRESH_BINARY);
+			m_input_mask = detection_data.mask;
+			cv::resize(m_input_mask, m_input_mask, m_cugn_sc_in_dims, 0, 0, cv::INTER_AREA);
+			cv::threshold(m_input_mask, m_input_mask, 0, 255, cv::THRESH_BINARY);
+			m_input_preprocessor.configure(m_cugn_sc_in_dims, m_input_mask, m_pix_mean, m_pix_std_div);
 
 			// displaying the detection
-			cv::rectangle(sc_input, m_sc_roi, (0, 0, 255), 3);
+			cv::rectangle(detection_input, m_input_roi, (0, 0, 255), 3);
 			QImage display_img = QImage(MODEL_DISPLAY_WIDTH, MODEL_DISPLAY_HEIGHT, QImage::Format_RGB888);
 			cv::Mat display_img_mat = cv::Mat(MODEL_DISPLAY_HEIGHT, MODEL_DISPLAY_WIDTH, CV_8UC3, display_img.bits(), display_img.bytesPerLine());
-			cv::resize(sc_input, display_img_mat, display_img_mat.size(), 0, 0, cv::INTER_AREA);
+			cv::resize(detection_input, display_img_mat, display_img_mat.size(), 0, 0, cv::INTER_AREA);
 			emit new_us_img_detection(std::move(display_img));
 
 			write_debug_output("US image detection : image detected");
@@ -202,4 +357,53 @@ void CUGNModel::detect_us_image(void) {
 
 	write_debug_output("US image detection - end");
 
+}
+
+void CUGNModel::select_input_source(void) {
+
+	// the probe and the screen recorder are never used together (single US image source)
+	m_probe_input = m_us_probe_p != nullptr && m_us_probe_p->get_sensor_used() && (*m_config_ptr)["cugn_input_source"] != "screen";
+	m_input_frames_p = m_probe_input ? m_us_probe_p->get_frame_pyramid() : m_sc_p->get_frame_pyramid();
+
+	write_debug_output(m_probe_input ? "Image source : Clarius probe images" : "Image source : screen recorder captures");
+
+}
+
+void CUGNModel::benchmark_preprocessing(void) {
+
+	cv::Mat roi_img = m_input_frames_p->get_source(m_input_roi);
+	if (roi_img.empty()) return;
+
+	// previous chain : resize -> gray conversion -> masking -> tensor conversion + normalization
+	cv::Mat sc_redim, sc_gray, sc_masked = cv::Mat::zeros(m_cugn_sc_in_dims, CV_8UC1);
+	at::Tensor chain_tensor;
+
+	auto chain_start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < PREPROCESS_BENCHMARK_PASSES; i++) {
+		cv::resize(roi_img, sc_redim, m_cugn_sc_in_dims, 0, 0, cv::INTER_AREA);
+		if (sc_redim.channels() == 4) cv::cvtColor(sc_redim, sc_gray, CV_BGRA2GRAY);
+		else if (sc_redim.channels() == 3) cv::cvtColor(sc_redim, sc_gray, CV_BGR2GRAY);
+		else sc_gray = sc_redim;
+		sc_gray.copyTo(sc_masked, m_input_mask);
+		chain_tensor = torch::from_blob(sc_masked.data, {1, 1, 1, sc_masked.rows, sc_masked.cols}, at::kByte).to(torch::kFloat32);
+		chain_tensor = chain_tensor.sub(m_pix_mean).div(m_pix_std_div);
+	}
+	auto chain_end = std::chrono::high_resolution_clock::now();
+
+	// fused pass
+	auto fused_start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < PREPROCESS_BENCHMARK_PASSES; i++) {
+		m_input_preprocessor.process(roi_img, m_input_slots[m_write_slot].img_tensor.data_ptr<float>());
+	}
+	auto fused_end = std::chrono::high_resolution_clock::now();
+
+	float chain_time = std::chrono::duration<float, std::micro>(chain_end - chain_start).count() / PREPROCESS_BENCHMARK_PASSES;
+	float fused_time = std::chrono::duration<float, std::micro>(fused_end - fused_start).count() / PREPROCESS_BENCHMARK_PASSES;
+	float max_diff = (chain_tensor - m_input_slots[m_write_slot].img_tensor).abs().max().item<float>();
+
+	write_debug_output("Preprocessing benchmark (" + QString::number(roi_img.cols) + "x" + QString::number(roi_img.rows)
+		+ " -> " + QString::number(m_cugn_sc_in_dims.width) + "x" + QString::number(m_cugn_sc_in_dims.height) + ") : chain "
+		+ QString::number(chain_time, 'f', 1) + " us, fused " + QString::number(fused_time, 'f', 1)
+		+ " us, max difference " + QString::number(max_diff, 'f', 4));
+
 }
\ No newline at end of file
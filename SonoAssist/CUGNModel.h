@@ -1,8 +1,10 @@
 #include <math.h> 
 #include <string>
 #include <memory>
+#include <mutex>
 #include <thread>
 #include <chrono>
+#include <condition_variable>
 
 #undef slots
 #include <torch/script.h>
@@ -12,13 +14,33 @@
 #include <QString>
 
 #include "MLModel.h"
+#include "FramePyramid.h"
 #include "ScreenRecorder.h"
+#include "ClariusProbeClient.h"
+#include "ImgTensorPreprocessor.h"
 
 #define PIXEL_MAX_VALUE 255
 #define MODEL_DETECTION_DELAY_MS 500
+#define PREPROCESS_BENCHMARK_PASSES 50
+
+// preprocessing -> inference handoff : one slot being written, one pending, one being evaluated
+#define CUGN_N_INPUT_SLOTS 3
+
+/**
+* Preprocessed model input, handed over from the preprocessing stage to the inference stage
+*/
+struct CUGNInputSlot {
+	at::Tensor img_tensor;
+	std::chrono::steady_clock::time_point sample_time;
+	std::chrono::steady_clock::time_point ready_time;
+};
 
 /*
 * Class for the real time evaluation of the Cardiac Ultrasound GuideNet (CUGN) model
+*
+* The US images are read from the frame pyramid of the Clarius probe (processed images, in process) when the probe is used,
+* or from the screen recorder captures otherwise (fallback, or when cugn_input_source is "screen").
+*
 * Model inputs :
 *	xt: The (t)th captured ultrasound image
 *	ht-1: The previous hidden state (for the GRU)
@@ -32,7 +54,8 @@ class CUGNModel : public MLModel {
 	public:
 
 		CUGNModel(int model_id, std::string model_description, std::string model_status_entry,
-			std::string redis_state_entry, std::string model_path_entry, std::string log_file_path, std::shared_ptr<ScreenRecorder> sc_p);
+			std::string redis_state_entry, std::string model_path_entry, std::string log_file_path,
+			std::shared_ptr<ScreenRecorder> sc_p, std::shared_ptr<ClariusProbeClient> us_probe_p);
 
 		void start_stream(void) override;
 		void stop_stream(void) override;
@@ -40,37 +63,95 @@ class CUGNModel : public MLModel {
 	private:
 
 		/**
-		* Executes the prediction pipeline with the following steps:
-		*	1) US image position detection via (detect_us_image)
-		*	2) Image capture and processing: cropping, color conversion, resizing & masking
-		*	3) Model inferance
-		* This method is meant to run in a seperate thread
+		* Preprocessing stage of the prediction pipeline, meant to run in a seperate thread:
+		*	1) US image position detection via (detect_us_image), re-run when the image geometry changes : probe image scale
+		*	   (depth / zoom change) or source dimensions (screen resolution change)
+		*	2) Image capture and processing, on a fixed schedule (cugn_sample_frequency): cropping, color conversion,
+		*	   resizing, masking & normalization (single pass), then handoff to the inference stage
+		* The preprocessing of a sample overlaps the inference of the previous one. Samples whose time has passed
+		* by a whole period (preprocessing overrun) and samples without a new image since the previous one are skipped.
+		*/
+		void preprocess(void);
+
+		/**
+		* Inference stage of the prediction pipeline, meant to run in a seperate thread:
+		* sets up the thread for inference and warms up the model (start_stream waits for m_warmup_done, the thread
+		* exits when the warmup fails),
+		* then evaluates the latest handed over input, extracts the prediction and writes it to redis.
+		* A sample misses its deadline when its prediction is not available before the next sample is due.
 		*/
 		void eval(void);
 
+		/**
+		* Publishes the input slot written by the preprocessing stage (m_write_slot) as the pending input.
+		* A pending input which was not picked up by the inference stage yet is replaced (inference overrun).
+		*/
+		void hand_over_input(void);
+
+		/**
+		* Writes the achieved frequency, the skipped samples, the deadline misses and the stage latencies to the debug output.
+		*/
+		void report_pipeline_stats(void);
+
 		/**
 		* Deploys automatic US shell shape detection
 		*/
 		void detect_us_image(void);
 
+		/**
+		* Selects the frame pyramid feeding the model : the Clarius probe images when the probe is used (and
+		* cugn_input_source is not "screen"), the screen recorder captures otherwise.
+		*/
+		void select_input_source(void);
+
+		/**
+		* Times the fused preprocessing against the resize -> cvtColor -> copyTo -> tensor chain on the latest capture
+		* and writes the results (+ the max difference between the two outputs) to the debug output.
+		*/
+		void benchmark_preprocessing(void);
+
 		std::thread m_eval_thread;
+		std::thread m_preprocess_thread;
 		int m_sampling_period_ms = 100;
 		std::shared_ptr<ScreenRecorder> m_sc_p = nullptr;
+		std::shared_ptr<ClariusProbeClient> m_us_probe_p = nullptr;
+
+		// image source (frame channel of the selected device)
+		bool m_probe_input = false;
+		std::shared_ptr<FramePyramid> m_input_frames_p = nullptr;
 
 		// screen recorder img preprocessing
 		
 		USImgDetector m_us_img_detector;
 		
-		cv::Rect m_sc_roi;
+		cv::Rect m_input_roi;
+		cv::Mat m_input_mask;
+		cv::Size m_input_frame_size;
+		double m_input_microns_per_pixel = 0;
 		cv::Size m_cugn_sc_in_dims;
-		cv::Mat m_sc_mask, m_sc_masked, m_sc_redim;
+		ImgTensorPreprocessor m_input_preprocessor;
+		bool m_preprocess_benchmark = false;
 		
 		int m_sequence_len = 0;
 		float m_pix_mean, m_pix_std_div = 0;
 		
-		// model inputs
+		// model inputs (the image tensors are persistent, the preprocessing writes in to them)
 		at::Tensor m_start_hx_tensor, m_default_mov_tensor;
 
+		// preprocessing -> inference handoff (slot indices are swapped, the tensors are never copied)
+		std::mutex m_handoff_mtx;
+		std::condition_variable m_handoff_cv;
+		CUGNInputSlot m_input_slots[CUGN_N_INPUT_SLOTS];
+		int m_write_slot = 0, m_pending_slot = 1, m_eval_slot = 2;
+		bool m_pending_ready = false;
+		bool m_warmup_done = false, m_warmup_valid = false;
+
+		// pipeline stats (each stage only updates its own vars, read once both stages are stopped)
+		std::chrono::steady_clock::time_point m_pipeline_start;
+		int m_n_preprocess_skips = 0, m_n_inference_skips = 0, m_n_stale_skips = 0;
+		int m_n_predictions = 0, m_n_deadline_misses = 0;
+		std::vector<float> m_preprocess_latencies, m_handoff_latencies, m_postprocess_latencies, m_sample_latencies;
+
 		// redis vars
 		std::string m_redis_pred_entry;
 
@@ -28,10 +28,16 @@ static ClariusProbeClient* probe_client_p = nullptr;
          }
         
          // mapping the incoming image to a Mat (no copy) + gray scale conversion
+         // the gray scale image is handed over to the frame pyramid (new buffer, consumers may hold the previous one)
+         cv::Mat cvt_mat;
          probe_client_p->m_input_img_mat.data = static_cast<uchar*>(const_cast<void*>(img));
-         cv::cvtColor(probe_client_p->m_input_img_mat, probe_client_p->m_cvt_mat, CV_BGRA2GRAY);
-         cv::resize(probe_client_p->m_cvt_mat, probe_client_p->m_output_img_mat,
-             probe_client_p->m_output_img_mat.size(), 0, 0, cv::INTER_AREA);
+         cv::cvtColor(probe_client_p->m_input_img_mat, cvt_mat, CV_BGRA2GRAY);
+         probe_client_p->m_frame_pyramid_p->set_source(cvt_mat);
+         probe_client_p->m_microns_per_pixel = nfo->micronsPerPixel;
+
+         // filling the display image with the resized variant
+         probe_client_p->m_frame_pyramid_p->get_variant(probe_client_p->m_output_img_mat.size(), CV_8UC1)
+             .copyTo(probe_client_p->m_output_img_mat);
 
          // defining the output data destined for the csv file
          if (probe_client_p->get_stream_status() && !probe_client_p->get_stream_preview_status()) {
@@ -122,8 +128,13 @@ void ClariusProbeClient::start_stream() {
         // preparing the writing of data
         set_output_file(m_output_folder_path);
         m_output_imu_file.open(m_output_imu_file_str, std::fstream::app);
+        m_output_gaze_file.open(m_output_gaze_file_str, std::fstream::app);
         m_video = cv::VideoWriter(m_output_video_file_str, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'),
             CLARIUS_VIDEO_FPS, cv::Size(m_out_img_width, m_out_img_height), true);
+        m_n_video_frames = 0;
+
+        // preparing the gaze mapping
+        configure_gaze_mapping();
 
         // connecting to redis (if redis enabled)
         if (m_redis_state) {
@@ -160,10 +171,15 @@ void ClariusProbeClient::stop_stream() {
             write_debug_output("ClariusProbeClient - failed to disconnect\n");
         }
 
+        // stopping the US shell detection
+        m_detect_us_image = false;
+        if (m_us_detection_thread.joinable()) m_us_detection_thread.join();
+
         // closing the outputs
         while(m_writing_ouput);
         m_video.release();
         m_output_imu_file.close();
+        m_output_gaze_file.close();
         disconnect_from_redis();
 
     }
@@ -179,13 +195,19 @@ void ClariusProbeClient::set_output_file(const std::string& output_folder_path)
         // defining the output file path
         m_output_imu_file_str = output_folder_path + "/clarius_data.csv";
         m_output_video_file_str = output_folder_path + "/clarius_images.avi";
+        m_output_gaze_file_str = output_folder_path + "/clarius_gaze.csv";
         if (m_output_imu_file.is_open()) m_output_imu_file.close();
+        if (m_output_gaze_file.is_open()) m_output_gaze_file.close();
 
         // writing the output file header
         m_output_imu_file.open(m_output_imu_file_str);
         m_output_imu_file << "Reception OS time,Display OS time,Onboard time,gx,gy,gz,ax,ay,az,mx,my,mz,qw,qx,qy,qz" << std::endl;
         m_output_imu_file.close();
 
+        m_output_gaze_file.open(m_output_gaze_file_str);
+        m_output_gaze_file << "Frame index,Display OS time,Gaze OS time,X image,Y image,Gaze status" << std::endl;
+        m_output_gaze_file.close();
+
         m_output_file_loaded = true;
 
     } catch (...) {
@@ -202,6 +224,14 @@ void ClariusProbeClient::set_udp_port(int port) {
     m_udp_port = port;
 }
 
+std::shared_ptr<FramePyramid> ClariusProbeClient::get_frame_pyramid(void) const {
+    return m_frame_pyramid_p;
+}
+
+double ClariusProbeClient::get_microns_per_pixel(void) const {
+    return m_microns_per_pixel;
+}
+
 void ClariusProbeClient::write_output_data() {
 
     try {
@@ -227,8 +257,10 @@ void ClariusProbeClient::write_output_data() {
 
         // writing to the output files, after passthrough check
         if (!m_pass_through) {
+            if (m_gaze_mapping && m_output_gaze_file.is_open()) m_output_gaze_file << format_gaze_mapping();
             if (m_video.isOpened()) m_video.write(m_video_img_mat);
             if (m_output_imu_file.is_open()) m_output_imu_file << imu_str;
+            m_n_video_frames++;
         }
         
         m_writing_ouput = false;
@@ -243,7 +275,7 @@ void ClariusProbeClient::write_output_data() {
 void ClariusProbeClient::initialize_img_handling() {
 
     // initializing the input containers
-    m_cvt_mat = cv::Mat(CLARIUS_DEFAULT_IMG_HEIGHT, CLARIUS_DEFAULT_IMG_WIDTH, CV_8UC1);
+    m_frame_pyramid_p->clear();
     m_input_img_mat = cv::Mat(CLARIUS_DEFAULT_IMG_HEIGHT, CLARIUS_DEFAULT_IMG_WIDTH, CV_8UC4);
    
     // initializing the output containers
@@ -274,4 +306,95 @@ void ClariusProbeClient::configure_img_acquisition(void) {
         m_out_img_height = CLARIUS_PREVIEW_IMG_HEIGHT;
     }
 
+}
+
+/*******************************************************************************
+* GAZE MAPPING
+******************************************************************************/
+
+void ClariusProbeClient::set_display_geometry(int screen_width, int screen_height, int display_x, int display_y, int display_width, int display_height) {
+    std::lock_guard<std::mutex> mapper_lock(m_gaze_mapper_mtx);
+    m_gaze_mapper.set_display_geometry(screen_width, screen_height, display_x, display_y, display_width, display_height);
+}
+
+void ClariusProbeClient::set_gaze_point(long long time_os, float x, float y) {
+    m_gaze_time_os = time_os;
+    m_gaze_x = x;
+    m_gaze_y = y;
+    m_gaze_point_valid = true;
+}
+
+void ClariusProbeClient::configure_gaze_mapping(void) {
+
+    // making sure the previous detection thread is stopped (failed stream start)
+    m_detect_us_image = false;
+    if (m_us_detection_thread.joinable()) m_us_detection_thread.join();
+
+    m_gaze_mapping = (*m_config_ptr)["us_probe_gaze_mapping"] == "true";
+    m_gaze_point_valid = false;
+
+    {
+        std::lock_guard<std::mutex> mapper_lock(m_gaze_mapper_mtx);
+        m_gaze_mapper.set_image_size(m_out_img_width, m_out_img_height);
+        m_gaze_mapper.clear_us_roi();
+    }
+
+    // the US shell is detected in the background (gaze points are only checked against the display until then)
+    if (m_gaze_mapping && !(*m_config_ptr)["us_probe_us_template"].empty()) {
+        m_us_img_detector = USImgDetector((*m_config_ptr)["us_probe_us_template"]);
+        m_detect_us_image = true;
+        m_us_detection_thread = std::thread(&ClariusProbeClient::detect_us_image, this);
+    }
+
+}
+
+void ClariusProbeClient::detect_us_image(void) {
+
+    cv::Mat detection_input;
+    cv::Size image_size(m_out_img_width, m_out_img_height);
+
+    while (m_detect_us_image) {
+
+        // the detection is done on the (BGRA) image as written to the outputs
+        cv::Mat gray_img = m_frame_pyramid_p->get_variant(image_size, CV_8UC1);
+        if (!gray_img.empty()) {
+
+            cv::cvtColor(gray_img, detection_input, CV_GRAY2BGRA);
+            ImgDetectData detection_data = m_us_img_detector.detect(detection_input);
+
+            if (detection_data.detected) {
+                std::lock_guard<std::mutex> mapper_lock(m_gaze_mapper_mtx);
+                m_gaze_mapper.set_us_roi(detection_data.bounding_box, detection_data.mask);
+                write_debug_output("ClariusProbeClient - US image detected (gaze mapping)");
+                break;
+            }
+
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(CLARIUS_US_DETECTION_DELAY_MS));
+
+    }
+
+}
+
+std::string ClariusProbeClient::format_gaze_mapping(void) {
+
+    long long display_time_os = get_micro_timestamp_count();
+
+    // the gaze point must be recent enough to be associated with the image
+    GazeImagePoint point = {GazeImageStatus::NO_GAZE, 0, 0};
+    if (m_gaze_point_valid && (display_time_os - m_gaze_time_os) <= CLARIUS_GAZE_MAX_AGE_US) {
+        std::lock_guard<std::mutex> mapper_lock(m_gaze_mapper_mtx);
+        point = m_gaze_mapper.map(m_gaze_x, m_gaze_y);
+    }
+
+    std::string gaze_str = std::to_string(m_n_video_frames) + "," + m_display_time + ",";
+    if (point.status == GazeImageStatus::NO_GAZE) {
+        gaze_str += " , , ,";
+    } else {
+        gaze_str += std::to_string(m_gaze_time_os) + "," + std::to_string(point.x) + "," + std::to_string(point.y) + ",";
+    }
+
+    return gaze_str + GazeImageMapper::get_status_str(point.status) + "\n";
+
 }
\ No newline at end of file
@@ -20,10 +20,17 @@
 #endif
 
 #include "SensorDevice.h"
+#include "FramePyramid.h"
+#include "USImgDetector.h"
+#include "GazeImageMapper.h"
 
 #include <listen/listen.h>
 
 #include <string>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <memory>
 #include <vector>
 #include <fstream>
 
@@ -42,8 +49,16 @@
 
 #define CLARIUS_VIDEO_FPS 20
 
+// gaze mapping (gaze points older than the max age, at display time, are not mapped)
+#define CLARIUS_GAZE_MAX_AGE_US 100000
+#define CLARIUS_US_DETECTION_DELAY_MS 500
+
 /**
 * Class to enable communication with a Clarius ultrasound probe
+*
+* When (us_probe_gaze_mapping) is "true", the latest gaze point (see set_gaze_point) is mapped to the pixel coordinates of every
+* recorded image and written to (clarius_gaze.csv), one line per video frame. The US shell is detected in the probe images
+* (USImgDetector, template from us_probe_us_template) by a seperate thread, to flag gaze points outside of the US shell.
 */
 class ClariusProbeClient : public SensorDevice {
 
@@ -54,7 +69,8 @@ class ClariusProbeClient : public SensorDevice {
 
 		ClariusProbeClient(int device_id, const std::string& device_description, 
 			const std::string& redis_state_entry, const std::string& log_file_path):
-			SensorDevice(device_id, device_description, redis_state_entry, log_file_path) {};
+			SensorDevice(device_id, device_description, redis_state_entry, log_file_path),
+			m_frame_pyramid_p(std::make_shared<FramePyramid>()) {};
 
         void stop_stream(void) override;
         void start_stream(void) override;
@@ -64,6 +80,37 @@ class ClariusProbeClient : public SensorDevice {
 
 		void set_udp_port(int port);
 
+		/**
+		* Defines the screen and US image display geometry used by the gaze mapping.
+		*
+		* \param screen_width The width (px) of the screen.
+		* \param screen_height The height (px) of the screen.
+		* \param display_x The x position (px) of the US image display on the screen.
+		* \param display_y The y position (px) of the US image display on the screen.
+		* \param display_width The width (px) of the US image display.
+		* \param display_height The height (px) of the US image display.
+		*/
+		void set_display_geometry(int screen_width, int screen_height, int display_x, int display_y, int display_width, int display_height);
+
+		/**
+		* Defines the gaze point to map to the next written image.
+		*
+		* \param time_os The OS acquisition time (us) of the gaze point.
+		* \param x The relative x coordinate on the screen.
+		* \param y The relative y coordinate on the screen.
+		*/
+		void set_gaze_point(long long time_os, float x, float y);
+
+		/**
+		* \return The frame pyramid holding the latest (full resolution, gray scale) probe image and its variants.
+		*/
+		std::shared_ptr<FramePyramid> get_frame_pyramid(void) const;
+
+		/**
+		* \return The scale of the latest probe image (changes with the imaging depth / zoom, the image dimensions do not).
+		*/
+		double get_microns_per_pixel(void) const;
+
 		/**
 		* Writes collected data (imu data + images the appropriate output files)
 		*/
@@ -75,7 +122,6 @@ class ClariusProbeClient : public SensorDevice {
 
 		// image handling vars (accessed from callback)
 		QImage m_output_img;
-		cv::Mat m_cvt_mat;
 		cv::Mat m_input_img_mat;
 		cv::Mat m_output_img_mat;
 		cv::Mat m_video_img_mat; 
@@ -93,6 +139,10 @@ class ClariusProbeClient : public SensorDevice {
 		std::atomic<bool> m_display_locked = true;
 		std::atomic<bool> m_handler_locked = false;
 
+		// latest probe image, its variants and its scale (accessed from callback)
+		std::shared_ptr<FramePyramid> m_frame_pyramid_p;
+		std::atomic<double> m_microns_per_pixel = 0;
+
 	private:
 
 		void initialize_img_handling(void);
@@ -102,15 +152,46 @@ class ClariusProbeClient : public SensorDevice {
 		*/
 		void configure_img_acquisition(void);
 
+		/**
+		* Loads the gaze mapping configurations and launches the US shell detection thread.
+		*/
+		void configure_gaze_mapping(void);
+
+		/**
+		* Attempts to detect the US shell in the latest probe image until it is found or the stream stops.
+		* This method is meant to run in a seperate thread.
+		*/
+		void detect_us_image(void);
+
+		/**
+		* \return The output file line (frame index, display time, gaze time, image coordinates and status) of the written image.
+		*/
+		std::string format_gaze_mapping(void);
+
 		// output vars
 		bool m_output_file_loaded = false;
 		std::string m_output_imu_file_str;
 		std::string m_output_video_file_str;
+		std::string m_output_gaze_file_str;
 
 		// output writing vars (accessed from callback)
 		bool m_writing_ouput = false;
 		std::ofstream m_output_imu_file;
+		std::ofstream m_output_gaze_file;
 		cv::VideoWriter m_video;
+		uint64_t m_n_video_frames = 0;
+
+		// gaze mapping vars
+		bool m_gaze_mapping = false;
+		bool m_gaze_point_valid = false;
+		long long m_gaze_time_os = 0;
+		float m_gaze_x = 0;
+		float m_gaze_y = 0;
+		std::mutex m_gaze_mapper_mtx;
+		GazeImageMapper m_gaze_mapper;
+		USImgDetector m_us_img_detector;
+		std::atomic<bool> m_detect_us_image = false;
+		std::thread m_us_detection_thread;
 
 		// custom redis entry names
 		std::string m_redis_imu_entry;
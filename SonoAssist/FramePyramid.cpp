@@ -0,0 +1,136 @@
+#include "FramePyramid.h"
+
+/*******************************************************************************
+* SOURCE HANDLING
+******************************************************************************/
+
+void FramePyramid::set_source(const cv::Mat& frame) {
+
+	std::lock_guard<std::mutex> pyramid_guard(m_pyramid_mtx);
+
+	m_source = frame;
+	m_variants.clear();
+	m_frame_id++;
+
+}
+
+void FramePyramid::set_variant(cv::Size size, int type, const cv::Mat& variant, cv::Rect roi) {
+
+	std::lock_guard<std::mutex> pyramid_guard(m_pyramid_mtx);
+
+	if (m_source.empty()) return;
+
+	cv::Rect frame_rect(0, 0, m_source.cols, m_source.rows);
+	roi = (roi.area() == 0) ? frame_rect : (roi & frame_rect);
+	m_variants[{roi, size, type}] = variant;
+
+}
+
+void FramePyramid::clear(void) {
+
+	std::lock_guard<std::mutex> pyramid_guard(m_pyramid_mtx);
+
+	m_source = cv::Mat();
+	m_variants.clear();
+
+}
+
+cv::Mat FramePyramid::get_source(cv::Rect roi) {
+
+	std::lock_guard<std::mutex> pyramid_guard(m_pyramid_mtx);
+
+	if (m_source.empty() || roi.area() == 0) return m_source;
+	return m_source(roi & cv::Rect(0, 0, m_source.cols, m_source.rows));
+
+}
+
+cv::Size FramePyramid::get_source_size(void) {
+
+	std::lock_guard<std::mutex> pyramid_guard(m_pyramid_mtx);
+	return m_source.size();
+
+}
+
+uint64_t FramePyramid::get_frame_id(void) {
+
+	std::lock_guard<std::mutex> pyramid_guard(m_pyramid_mtx);
+	return m_frame_id;
+
+}
+
+/*******************************************************************************
+* VARIANT HANDLING
+******************************************************************************/
+
+cv::Mat FramePyramid::get_variant(cv::Size size, int type, cv::Rect roi) {
+
+	std::lock_guard<std::mutex> pyramid_guard(m_pyramid_mtx);
+
+	if (m_source.empty()) return cv::Mat();
+
+	// normalizing the requested region and size (empty values select the whole frame / region)
+	cv::Rect frame_rect(0, 0, m_source.cols, m_source.rows);
+	roi = (roi.area() == 0) ? frame_rect : (roi & frame_rect);
+	if (size.area() == 0) size = roi.size();
+
+	// the source frame is returned as is when it matches the request
+	FrameVariantKey key = {roi, size, type};
+	if (roi == frame_rect && size == frame_rect.size() && type == m_source.type()) {
+		return m_source;
+	}
+
+	// computing missing variants once per frame
+	auto variant_it = m_variants.find(key);
+	if (variant_it == m_variants.end()) {
+		variant_it = m_variants.emplace(key, compute_variant(key)).first;
+	}
+
+	return variant_it->second;
+
+}
+
+cv::Mat FramePyramid::compute_variant(const FrameVariantKey& key) {
+
+	cv::Mat resized, variant;
+	int source_channels = m_source.channels();
+	int target_channels = CV_MAT_CN(key.type);
+
+	// a cached variant with the same region and size only requires a color conversion
+	// (never from fewer channels, a gray variant cannot give back the colors of the source)
+	cv::Mat input = m_source(key.roi);
+	for (auto& cached : m_variants) {
+		if (cached.first.roi == key.roi && cached.first.size == key.size && cached.second.channels() >= target_channels) {
+			input = cached.second;
+			source_channels = input.channels();
+			break;
+		}
+	}
+
+	// resizing before the color conversion (fewer pixels to convert when downscaling)
+	if (input.size() == key.size) {
+		resized = input;
+	} else {
+		int interpolation = (key.size.area() < input.size().area()) ? cv::INTER_AREA : cv::INTER_LINEAR;
+		cv::resize(input, resized, key.size, 0, 0, interpolation);
+	}
+
+	// converting to the requested pixel format
+	if (source_channels == target_channels) {
+		variant = resized;
+	} else if (source_channels == 4 && target_channels == 3) {
+		cv::cvtColor(resized, variant, CV_BGRA2BGR);
+	} else if (source_channels == 4 && target_channels == 1) {
+		cv::cvtColor(resized, variant, CV_BGRA2GRAY);
+	} else if (source_channels == 3 && target_channels == 1) {
+		cv::cvtColor(resized, variant, CV_BGR2GRAY);
+	} else if (source_channels == 3 && target_channels == 4) {
+		cv::cvtColor(resized, variant, CV_BGR2BGRA);
+	} else if (source_channels == 1 && target_channels == 3) {
+		cv::cvtColor(resized, variant, CV_GRAY2BGR);
+	} else if (source_channels == 1 && target_channels == 4) {
+		cv::cvtColor(resized, variant, CV_GRAY2BGRA);
+	}
+
+	return variant;
+
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <cstdint>
+
+#include <opencv2/opencv.hpp>
+
+/**
+* Structure identifying a variant (region, size and pixel format) of a source frame
+*/
+struct FrameVariantKey {
+
+	cv::Rect roi;
+	cv::Size size;
+	int type;
+
+	bool operator<(const FrameVariantKey& other) const {
+		return std::make_tuple(roi.x, roi.y, roi.width, roi.height, size.width, size.height, type) <
+			std::make_tuple(other.roi.x, other.roi.y, other.roi.width, other.roi.height, other.size.width, other.size.height, other.type);
+	}
+
+};
+
+/**
+* Class sharing the resized / converted versions of a single image source between its consumers.
+*
+* The producer hands over each new frame with (set_source). Consumers request the variant they need
+* (region of interest, size and OpenCV type) with (get_variant). Each variant is computed lazily, at most
+* once per source frame, and cached until the next frame is handed over.
+* Supported types are CV_8UC1 (gray), CV_8UC3 (BGR) and CV_8UC4 (BGRA).
+* Returned Mats share their data with the cache and must be treated as read-only by the consumers.
+*/
+class FramePyramid {
+
+	public:
+
+		FramePyramid() {}
+
+		/**
+		* Replaces the source frame and clears the cached variants.
+		* The pyramid keeps a reference to the provided Mat (no copy), the producer must not write into it afterwards.
+		*
+		* \param frame The new source frame.
+		*/
+		void set_source(const cv::Mat& frame);
+
+		/**
+		* Adds a variant of the current source frame that was computed by the producer.
+		* The pyramid keeps a reference to the provided Mat (no copy), the producer must not write into it afterwards.
+		*
+		* \param size The dimensions of the variant.
+		* \param type The OpenCV type of the variant.
+		* \param variant The variant data.
+		* \param roi The region of the source frame used for the variant, an empty rectangle selects the whole frame.
+		*/
+		void set_variant(cv::Size size, int type, const cv::Mat& variant, cv::Rect roi = cv::Rect());
+
+		/**
+		* Clears the source frame and the cached variants.
+		*/
+		void clear(void);
+
+		/**
+		* Returns the requested variant of the current source frame, computing it if it is not cached yet.
+		*
+		* \param size The dimensions of the variant, an empty size keeps the (roi) dimensions.
+		* \param type The OpenCV type of the variant (CV_8UC1, CV_8UC3 or CV_8UC4).
+		* \param roi The region of the source frame to use, an empty rectangle selects the whole frame.
+		* \return The variant or an empty Mat when no source frame is available.
+		*/
+		cv::Mat get_variant(cv::Size size, int type, cv::Rect roi = cv::Rect());
+
+		/**
+		* Returns the current source frame (or a region of it) without any copy.
+		*
+		* \param roi The region of the source frame to return, an empty rectangle selects the whole frame.
+		*/
+		cv::Mat get_source(cv::Rect roi = cv::Rect());
+
+		/**
+		* \return The dimensions of the current source frame (empty when no source frame is available).
+		*/
+		cv::Size get_source_size(void);
+
+		/**
+		* \return The number of source frames handed over since the creation of the pyramid.
+		*/
+		uint64_t get_frame_id(void);
+
+	private:
+
+		/**
+		* Computes the requested variant from the closest cached variant (or from the source frame).
+		* Must be called with (m_pyramid_mtx) locked.
+		*/
+		cv::Mat compute_variant(const FrameVariantKey& key);
+
+		std::mutex m_pyramid_mtx;
+		uint64_t m_frame_id = 0;
+
+		cv::Mat m_source;
+		std::map<FrameVariantKey, cv::Mat> m_variants;
+
+};
\ No newline at end of file
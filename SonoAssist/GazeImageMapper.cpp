@@ -0,0 +1,69 @@
+#include "GazeImageMapper.h"
+
+/*******************************************************************************
+* CONFIGURATION
+******************************************************************************/
+
+void GazeImageMapper::set_display_geometry(int screen_width, int screen_height, int display_x, int display_y, int display_width, int display_height) {
+	m_screen_width = screen_width;
+	m_screen_height = screen_height;
+	m_display_x = display_x;
+	m_display_y = display_y;
+	m_display_width = std::max(1, display_width);
+	m_display_height = std::max(1, display_height);
+}
+
+void GazeImageMapper::set_image_size(int image_width, int image_height) {
+	m_image_width = image_width;
+	m_image_height = image_height;
+}
+
+void GazeImageMapper::set_us_roi(const cv::Rect& roi, const cv::Mat& mask) {
+	m_roi = roi;
+	m_roi_mask = (mask.size() == roi.size() && mask.type() == CV_8UC1) ? mask.clone() : cv::Mat();
+	m_roi_defined = true;
+}
+
+void GazeImageMapper::clear_us_roi(void) {
+	m_roi_defined = false;
+	m_roi_mask.release();
+}
+
+/*******************************************************************************
+* MAPPING
+******************************************************************************/
+
+GazeImagePoint GazeImageMapper::map(float x, float y) const {
+
+	// screen -> display (relative) -> image coordinates
+	float x_display = (x * m_screen_width - m_display_x) / m_display_width;
+	float y_display = (y * m_screen_height - m_display_y) / m_display_height;
+	GazeImagePoint point = {GazeImageStatus::IN_IMAGE, x_display * m_image_width, y_display * m_image_height};
+
+	if (x_display < 0 || x_display >= 1 || y_display < 0 || y_display >= 1) {
+		point.status = GazeImageStatus::OUT_OF_DISPLAY;
+		return point;
+	}
+
+	// US shell check (bounding box, then mask)
+	if (m_roi_defined) {
+		cv::Point pixel(static_cast<int>(point.x), static_cast<int>(point.y));
+		if (!m_roi.contains(pixel) || (!m_roi_mask.empty() && m_roi_mask.at<uchar>(pixel.y - m_roi.y, pixel.x - m_roi.x) == 0)) {
+			point.status = GazeImageStatus::OUT_OF_US_IMAGE;
+		}
+	}
+
+	return point;
+
+}
+
+const char* GazeImageMapper::get_status_str(GazeImageStatus status) {
+
+	switch (status) {
+		case GazeImageStatus::IN_IMAGE: return "in_image";
+		case GazeImageStatus::OUT_OF_US_IMAGE: return "out_of_us_image";
+		case GazeImageStatus::OUT_OF_DISPLAY: return "out_of_display";
+		default: return "no_gaze";
+	}
+
+}
\ No newline at end of file
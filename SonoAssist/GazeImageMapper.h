@@ -0,0 +1,93 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+/**
+* Position of a gaze point relative to the US image
+*/
+enum class GazeImageStatus {
+	IN_IMAGE,
+	OUT_OF_US_IMAGE,
+	OUT_OF_DISPLAY,
+	NO_GAZE
+};
+
+/**
+* Gaze point in US image pixel coordinates (coordinates are defined, possibly outside of the image, unless the status is NO_GAZE)
+*/
+struct GazeImagePoint {
+	GazeImageStatus status;
+	float x;
+	float y;
+};
+
+/**
+* Class mapping gaze points (relative screen coordinates) to the pixel coordinates of the US images, as displayed and recorded.
+*
+* Points are first placed on the US image display (screen geometry) then scaled to the image dimensions. When the US shell
+* (ROI + mask, see USImgDetector) was detected in the image, points outside of the shell are flagged as OUT_OF_US_IMAGE.
+*/
+class GazeImageMapper {
+
+	public:
+
+		GazeImageMapper() {}
+
+		/**
+		* \param screen_width The width (px) of the screen.
+		* \param screen_height The height (px) of the screen.
+		* \param display_x The x position (px) of the US image display on the screen.
+		* \param display_y The y position (px) of the US image display on the screen.
+		* \param display_width The width (px) of the US image display.
+		* \param display_height The height (px) of the US image display.
+		*/
+		void set_display_geometry(int screen_width, int screen_height, int display_x, int display_y, int display_width, int display_height);
+
+		/**
+		* \param image_width The width (px) of the US images.
+		* \param image_height The height (px) of the US images.
+		*/
+		void set_image_size(int image_width, int image_height);
+
+		/**
+		* Defines the US shell of the images, the mask is ignored if its size does not match the ROI.
+		*
+		* \param roi The bounding box of the US shell (image pixel coordinates).
+		* \param mask The mask of the US shell within the ROI (CV_8UC1, non zero inside of the shell).
+		*/
+		void set_us_roi(const cv::Rect& roi, const cv::Mat& mask);
+		void clear_us_roi(void);
+		bool has_us_roi(void) const { return m_roi_defined; }
+
+		/**
+		* \param x The relative x coordinate on the screen.
+		* \param y The relative y coordinate on the screen.
+		* \return The gaze point in image pixel coordinates.
+		*/
+		GazeImagePoint map(float x, float y) const;
+
+		/**
+		* \return The string representation of the status (for the output files).
+		*/
+		static const char* get_status_str(GazeImageStatus status);
+
+	private:
+
+		// screen and display geometry (px)
+		int m_screen_width = 1920;
+		int m_screen_height = 1080;
+		int m_display_x = 0;
+		int m_display_y = 0;
+		int m_display_width = 1920;
+		int m_display_height = 1080;
+
+		// image dimensions (px)
+		int m_image_width = 1920;
+		int m_image_height = 1080;
+
+		// US shell (image coordinates)
+		bool m_roi_defined = false;
+		cv::Rect m_roi;
+		cv::Mat m_roi_mask;
+
+};
\ No newline at end of file
@@ -0,0 +1,168 @@
+#include "GazeProcessor.h"
+
+/*******************************************************************************
+* CONFIGURATION
+******************************************************************************/
+
+void GazeProcessor::configure(const GazeProcessorParams& params) {
+	m_params = params;
+	reset();
+}
+
+void GazeProcessor::reset(void) {
+
+	m_head_distance_valid = false;
+	m_head_distance = m_params.default_head_position;
+
+	m_has_pending = false;
+	m_pending_dropped = false;
+
+	m_n_fixation_points = 0;
+	m_fixation_x_sum = 0;
+	m_fixation_y_sum = 0;
+
+	m_in_saccade = false;
+	m_has_accepted_point = false;
+
+}
+
+/*******************************************************************************
+* SAMPLE PROCESSING
+******************************************************************************/
+
+void GazeProcessor::add_head_pose(float head_z) {
+
+	double head_distance = head_z / 1000.0;
+
+	if (!m_head_distance_valid) {
+		m_head_distance = head_distance;
+		m_head_distance_valid = true;
+	} else {
+		m_head_distance += GAZE_HEAD_DISTANCE_SMOOTHING * (head_distance - m_head_distance);
+	}
+
+}
+
+void GazeProcessor::add_gaze_point(int64_t time_os, float x, float y, std::vector<FilteredGazePoint>& points, std::vector<GazeEvent>& events) {
+
+	// drift correction (relative offsets, clamped to the screen)
+	if (m_params.gaze_x_offset != 0 || m_params.gaze_y_offset != 0) {
+		x = std::min(1.f, std::max(0.f, static_cast<float>(x + m_params.gaze_x_offset / m_params.screen_width)));
+		y = std::min(1.f, std::max(0.f, static_cast<float>(y + m_params.gaze_y_offset / m_params.screen_height)));
+	}
+
+	// position filtering (only points inside of the US image display are kept)
+	double x_screen = std::round(x * m_params.screen_width);
+	double y_screen = std::round(y * m_params.screen_height);
+	double left_border = m_params.display_x;
+	double top_border = m_params.display_y;
+	double right_border = left_border + m_params.display_width;
+	double bottom_border = top_border + m_params.display_height;
+
+	if (!(x_screen > left_border && x_screen < right_border && y_screen > top_border && y_screen < bottom_border)) return;
+
+	FilteredGazePoint point = {time_os, x, y,
+		static_cast<float>((x_screen - left_border) / m_params.display_width),
+		static_cast<float>((y_screen - top_border) / m_params.display_height)};
+
+	// speed filtering (both points of a pair with an excessive speed are dropped)
+	bool point_dropped = false;
+	if (m_has_pending) {
+
+		double x_distance = std::abs(point.x - m_pending_point.x) * m_params.phys_screen_width;
+		double y_distance = std::abs(point.y - m_pending_point.y) * m_params.phys_screen_height;
+		double time_diff = (point.time_os - m_pending_point.time_os) / 1000000.0;
+
+		// distance (m) associated with 1 degree of visual angle at the current head distance
+		double v_distance = 2 * std::tan(GAZE_DEG_TO_RAD / 2) * m_head_distance;
+		double max_speed = m_params.max_gaze_speed * v_distance;
+
+		bool excessive_speed = (time_diff > 0) ?
+			((x_distance / time_diff) >= max_speed || (y_distance / time_diff) >= max_speed) :
+			(x_distance > 0 || y_distance > 0);
+
+		if (excessive_speed) {
+			m_pending_dropped = true;
+			point_dropped = true;
+		}
+
+		release_pending_point(points, events);
+
+	}
+
+	m_has_pending = true;
+	m_pending_point = point;
+	m_pending_dropped = point_dropped;
+
+}
+
+void GazeProcessor::flush(std::vector<FilteredGazePoint>& points, std::vector<GazeEvent>& events) {
+
+	if (m_has_pending) {
+		release_pending_point(points, events);
+		m_has_pending = false;
+	}
+
+	// incomplete saccades are not reported
+	close_fixation(events);
+	m_in_saccade = false;
+
+}
+
+/*******************************************************************************
+* FIXATION & SACCADE DETECTION
+******************************************************************************/
+
+void GazeProcessor::release_pending_point(std::vector<FilteredGazePoint>& points, std::vector<GazeEvent>& events) {
+
+	if (!m_pending_dropped) {
+
+		points.push_back(m_pending_point);
+
+		// the accepted point ends the ongoing saccade and extends the ongoing fixation
+		if (m_in_saccade) close_saccade(events, m_pending_point);
+		if (m_n_fixation_points == 0) m_fixation_start = m_pending_point;
+		m_fixation_end = m_pending_point;
+		m_fixation_x_sum += m_pending_point.x_display;
+		m_fixation_y_sum += m_pending_point.y_display;
+		m_n_fixation_points++;
+
+		m_has_accepted_point = true;
+		m_last_accepted_point = m_pending_point;
+
+	} else {
+
+		// the dropped point ends the ongoing fixation and extends the ongoing saccade
+		close_fixation(events);
+		if (!m_in_saccade) {
+			m_in_saccade = true;
+			m_saccade_start_time = m_has_accepted_point ? m_last_accepted_point.time_os : m_pending_point.time_os;
+		}
+
+	}
+
+}
+
+void GazeProcessor::close_fixation(std::vector<GazeEvent>& events) {
+
+	if (m_n_fixation_points > 0 && (m_fixation_end.time_os - m_fixation_start.time_os) >= m_params.min_fixation_duration) {
+		float mean_x = static_cast<float>(m_fixation_x_sum / m_n_fixation_points);
+		float mean_y = static_cast<float>(m_fixation_y_sum / m_n_fixation_points);
+		events.push_back({GazeEventType::FIXATION, m_fixation_start.time_os, m_fixation_end.time_os, mean_x, mean_y, mean_x, mean_y});
+	}
+
+	m_n_fixation_points = 0;
+	m_fixation_x_sum = 0;
+	m_fixation_y_sum = 0;
+
+}
+
+void GazeProcessor::close_saccade(std::vector<GazeEvent>& events, const FilteredGazePoint& end_point) {
+
+	const FilteredGazePoint& start_point = m_has_accepted_point ? m_last_accepted_point : end_point;
+	events.push_back({GazeEventType::SACCADE, m_saccade_start_time, end_point.time_os,
+		start_point.x_display, start_point.y_display, end_point.x_display, end_point.y_display});
+
+	m_in_saccade = false;
+
+}
\ No newline at end of file
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+// smoothing factor of the head distance (exponential moving average of the head pose Z coordinates)
+#define GAZE_HEAD_DISTANCE_SMOOTHING 0.02
+#define GAZE_DEG_TO_RAD (3.14159265358979323846 / 180.0)
+
+/**
+* Parameters of the online gaze processing (same definitions as the sonopy configuration)
+*/
+struct GazeProcessorParams {
+
+	// screen dimensions (px) and physical dimensions (m)
+	int screen_width = 1920;
+	int screen_height = 1080;
+	double phys_screen_width = 0.345;
+	double phys_screen_height = 0.195;
+
+	// US image display position / dimensions (px, screen coordinates)
+	int display_x = 0;
+	int display_y = 0;
+	int display_width = 1920;
+	int display_height = 1080;
+
+	// drift correction offsets (px)
+	double gaze_x_offset = 0;
+	double gaze_y_offset = 0;
+
+	// speed limit (degrees of visual angle / s), also used as the saccade detection threshold
+	double max_gaze_speed = 30;
+
+	// head distance (m) used until head pose data is available
+	double default_head_position = 0.6;
+
+	// minimum duration (us) of a fixation
+	int64_t min_fixation_duration = 100000;
+
+};
+
+/**
+* Gaze point which passed the position and speed filters
+*/
+struct FilteredGazePoint {
+	int64_t time_os;
+	float x;
+	float y;
+	float x_display;
+	float y_display;
+};
+
+enum class GazeEventType {
+	FIXATION,
+	SACCADE
+};
+
+/**
+* Fixation (mean display position) or saccade (display positions before / after the saccade)
+*/
+struct GazeEvent {
+	GazeEventType type;
+	int64_t start_time_os;
+	int64_t end_time_os;
+	float x_display;
+	float y_display;
+	float end_x_display;
+	float end_y_display;
+};
+
+/**
+* Incremental version of the gaze processing done by sonopy (sonopy/gaze.py), with O(1) work per sample.
+*
+* Gaze points go through the same steps as the offline processing : drift correction, position filtering
+* (points outside of the US image display are dropped) and speed filtering (both points of a pair exceeding
+* the speed limit are dropped). Since a point can be dropped by the following one, filtered points are output
+* with a delay of one sample. The head distance, used to convert the speed limit from degrees to meters, is
+* a moving average of the head pose data (instead of the per-slice averages of the offline processing).
+*
+* Runs of dropped (speed) points are reported as saccades and runs of accepted points lasting at least
+* (min_fixation_duration) are reported as fixations (velocity threshold identification).
+*/
+class GazeProcessor {
+
+	public:
+
+		GazeProcessor() {}
+
+		/**
+		* Defines the processing parameters and resets the processing state.
+		*/
+		void configure(const GazeProcessorParams& params);
+
+		/**
+		* Clears the processing state (pending point, head distance and ongoing fixation / saccade).
+		*/
+		void reset(void);
+
+		/**
+		* Updates the head distance estimate.
+		*
+		* \param head_z The head distance (mm) from the screen (Z coordinate of the head pose).
+		*/
+		void add_head_pose(float head_z);
+
+		/**
+		* Processes a gaze point, the points and events completed by this point are appended to the provided vectors.
+		*
+		* \param time_os The OS acquisition time (us) of the gaze point.
+		* \param x The relative x coordinate on the screen.
+		* \param y The relative y coordinate on the screen.
+		* \param points The filtered points.
+		* \param events The detected fixations and saccades.
+		*/
+		void add_gaze_point(int64_t time_os, float x, float y, std::vector<FilteredGazePoint>& points, std::vector<GazeEvent>& events);
+
+		/**
+		* Outputs the pending point and the ongoing fixation / saccade (end of the stream).
+		*/
+		void flush(std::vector<FilteredGazePoint>& points, std::vector<GazeEvent>& events);
+
+		/**
+		* \return The current head distance estimate (m).
+		*/
+		double get_head_distance(void) const { return m_head_distance; }
+
+	private:
+
+		/**
+		* Releases the pending point (accepted or dropped) and updates the fixation / saccade detection.
+		*/
+		void release_pending_point(std::vector<FilteredGazePoint>& points, std::vector<GazeEvent>& events);
+
+		void close_fixation(std::vector<GazeEvent>& events);
+		void close_saccade(std::vector<GazeEvent>& events, const FilteredGazePoint& end_point);
+
+		GazeProcessorParams m_params;
+
+		// head distance (m)
+		bool m_head_distance_valid = false;
+		double m_head_distance = 0;
+
+		// speed filtering (point waiting for its successor)
+		bool m_has_pending = false;
+		bool m_pending_dropped = false;
+		FilteredGazePoint m_pending_point;
+
+		// fixation detection (running sums of the accepted points)
+		int64_t m_n_fixation_points = 0;
+		double m_fixation_x_sum = 0;
+		double m_fixation_y_sum = 0;
+		FilteredGazePoint m_fixation_start;
+		FilteredGazePoint m_fixation_end;
+
+		// saccade detection (run of dropped points, after the last accepted point)
+		bool m_in_saccade = false;
+		bool m_has_accepted_point = false;
+		int64_t m_saccade_start_time = 0;
+		FilteredGazePoint m_last_accepted_point;
+
+};
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "GazeSaliencyMap.h"
+#include "GazeProcessor.h"
+
+/*******************************************************************************
+* CONFIGURATION
+******************************************************************************/
+
+void GazeSaliencyMap::configure(int map_width, int map_height, int64_t time_window) {
+	m_width = std::max(1, map_width);
+	m_height = std::max(1, map_height);
+	m_time_window = time_window;
+	reset();
+}
+
+void GazeSaliencyMap::reset(void) {
+	m_points.clear();
+	m_map.assign(static_cast<size_t>(m_width) * m_height, 0);
+	m_map_sum = 0;
+}
+
+int GazeSaliencyMap::compute_sigma(double head_distance, int screen_width, double phys_screen_width, int display_width, int map_width) {
+
+	// distance (m) associated with 1 degree of visual angle, converted to saliency map units
+	double v_distance = 2 * std::tan(GAZE_DEG_TO_RAD / 2) * head_distance;
+	double size_factor = static_cast<double>(map_width) / display_width;
+	int sigma = static_cast<int>(std::round(v_distance * (screen_width / phys_screen_width) * size_factor));
+
+	return std::max(1, sigma);
+
+}
+
+/*******************************************************************************
+* MAP UPDATES
+******************************************************************************/
+
+void GazeSaliencyMap::add_point(int64_t time_os, float x_display, float y_display, int sigma) {
+
+	int half_span = static_cast<int>(get_kernel(sigma).size()) / 2;
+	SaliencyPoint point = {time_os,
+		static_cast<int>(std::round(x_display * m_width)) - half_span,
+		static_cast<int>(std::round(y_display * m_height)) - half_span, sigma};
+
+	splat(point, 1);
+	m_points.push_back(point);
+	expire_points(time_os);
+
+}
+
+void GazeSaliencyMap::expire_points(int64_t time_os) {
+
+	while (!m_points.empty() && m_points.front().time_os < time_os - m_time_window) {
+		splat(m_points.front(), -1);
+		m_points.pop_front();
+	}
+
+	// clearing the rounding errors accumulated by the subtractions
+	if (m_points.empty() && m_map_sum != 0) {
+		std::fill(m_map.begin(), m_map.end(), 0);
+		m_map_sum = 0;
+	}
+
+}
+
+void GazeSaliencyMap::splat(const SaliencyPoint& point, double sign) {
+
+	const std::vector<double>& kernel = get_kernel(point.sigma);
+	int span = static_cast<int>(kernel.size());
+
+	// clipping the gaussian to the map
+	int x_start = std::max(0, point.corner_x), x_end = std::min(m_width, point.corner_x + span);
+	int y_start = std::max(0, point.corner_y), y_end = std::min(m_height, point.corner_y + span);
+	if (x_start >= x_end || y_start >= y_end) return;
+
+	// outer product of the 1D kernels (the sum of the clipped gaussian is the product of the clipped kernel sums)
+	double x_sum = 0, y_sum = 0;
+	for (int x = x_start; x < x_end; x++) x_sum += kernel[x - point.corner_x];
+
+	for (int y = y_start; y < y_end; y++) {
+		double y_weight = sign * kernel[y - point.corner_y];
+		double* row_p = m_map.data() + static_cast<size_t>(y) * m_width;
+		for (int x = x_start; x < x_end; x++) row_p[x] += y_weight * kernel[x - point.corner_x];
+		y_sum += kernel[y - point.corner_y];
+	}
+
+	m_map_sum += sign * x_sum * y_sum;
+
+}
+
+const std::vector<double>& GazeSaliencyMap::get_kernel(int sigma) {
+
+	auto kernel_it = m_kernels.find(sigma);
+	if (kernel_it != m_kernels.end()) return kernel_it->second;
+
+	// odd span of 6 sigma, centered on the gaze point
+	int span = 6 * sigma;
+	if (span % 2 == 0) span -= 1;
+	int half_span = span / 2;
+
+	std::vector<double> kernel(span);
+	for (int i = 0; i < span; i++) {
+		double offset = i - half_span;
+		kernel[i] = std::exp(-(offset * offset) / (2.0 * sigma * sigma));
+	}
+
+	return m_kernels.emplace(sigma, std::move(kernel)).first->second;
+
+}
+
+/*******************************************************************************
+* OUTPUT
+******************************************************************************/
+
+bool GazeSaliencyMap::get_map(std::vector<float>& map) const {
+
+	map.resize(m_map.size());
+	if (m_points.empty() || m_map_sum <= 0) {
+		std::fill(map.begin(), map.end(), 0.f);
+		return false;
+	}
+
+	// negative values can only come from rounding errors
+	double inv_sum = 1.0 / m_map_sum;
+	for (size_t i = 0; i < m_map.size(); i++) {
+		map[i] = static_cast<float>(std::max(0.0, m_map[i]) * inv_sum);
+	}
+
+	return true;
+
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <map>
+#include <deque>
+#include <cmath>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+/**
+* Saliency map (sonopy/gaze.py -> generate_saliency_map) maintained incrementally over a sliding time window.
+*
+* Every filtered gaze point adds a gaussian (sigma of 1 degree of visual angle) to a low resolution grid of the
+* US image display and the gaussian is subtracted once the point leaves the time window, the map is therefore always
+* the sum of the gaussians of the points within the window (the points decay out of the map as time passes).
+* Gaussians are separable (outer product of two 1D kernels), a point costs O(span^2) additions when it enters and
+* leaves the window, independently of the number of points in the window. The 1D kernels are cached per sigma.
+*/
+class GazeSaliencyMap {
+
+	public:
+
+		GazeSaliencyMap() {}
+
+		/**
+		* Defines the map dimensions and the time window, then clears the map.
+		*
+		* \param map_width The width of the map (saliency map units).
+		* \param map_height The height of the map (saliency map units).
+		* \param time_window The span of time (us) covered by the map.
+		*/
+		void configure(int map_width, int map_height, int64_t time_window);
+
+		/**
+		* Removes all of the points from the map.
+		*/
+		void reset(void);
+
+		/**
+		* Adds the gaussian of a gaze point to the map, then removes the points which left the time window.
+		*
+		* \param time_os The OS acquisition time (us) of the point.
+		* \param x_display The relative x coordinate on the US image display.
+		* \param y_display The relative y coordinate on the US image display.
+		* \param sigma The sigma of the gaussian (saliency map units).
+		*/
+		void add_point(int64_t time_os, float x_display, float y_display, int sigma);
+
+		/**
+		* Removes the points which are older than (time_os - time window).
+		*
+		* \param time_os The current OS time (us).
+		*/
+		void expire_points(int64_t time_os);
+
+		/**
+		* Copies the normalized map (sum of 1, row major) in to the provided vector.
+		*
+		* \param map The output map, resized to (width * height).
+		* \return (false) if the time window holds no point (the map is then filled with zeros).
+		*/
+		bool get_map(std::vector<float>& map) const;
+
+		/**
+		* Computes the gaussian sigma (saliency map units) associated with 1 degree of visual angle, as done by sonopy.
+		*
+		* \param head_distance The distance (m) between the head and the screen.
+		* \param screen_width The width (px) of the screen.
+		* \param phys_screen_width The width (m) of the screen.
+		* \param display_width The width (px) of the US image display.
+		* \param map_width The width of the map (saliency map units).
+		*/
+		static int compute_sigma(double head_distance, int screen_width, double phys_screen_width, int display_width, int map_width);
+
+		int get_width(void) const { return m_width; }
+		int get_height(void) const { return m_height; }
+		size_t get_n_points(void) const { return m_points.size(); }
+
+	private:
+
+		/**
+		* Gaze point within the time window (top left corner of its gaussian)
+		*/
+		struct SaliencyPoint {
+			int64_t time_os;
+			int corner_x;
+			int corner_y;
+			int sigma;
+		};
+
+		/**
+		* Adds (sign = 1) or subtracts (sign = -1) the gaussian of a point to / from the map.
+		*/
+		void splat(const SaliencyPoint& point, double sign);
+
+		/**
+		* \return The 1D gaussian kernel (odd span of 6 sigma) for the given sigma.
+		*/
+		const std::vector<double>& get_kernel(int sigma);
+
+		int m_width = 0;
+		int m_height = 0;
+		int64_t m_time_window = 0;
+
+		// map values (sum of the gaussians) and their total
+		std::vector<double> m_map;
+		double m_map_sum = 0;
+
+		// points within the time window (oldest first) and 1D kernels per sigma
+		std::deque<SaliencyPoint> m_points;
+		std::map<int, std::vector<double>> m_kernels;
+
+};
\ No newline at end of file
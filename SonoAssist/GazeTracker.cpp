@@ -16,7 +16,6 @@ void url_receiver(char const* url, void* user_data){
 
 void gaze_point_callback(tobii_gaze_point_t const* gaze_point, void* user_data) {
 	
-	int64_t tobii_time;
 	GazeTracker* manager = (GazeTracker*)user_data;
 
 	if (gaze_point->validity == TOBII_VALIDITY_VALID) {
@@ -28,25 +27,8 @@ void gaze_point_callback(tobii_gaze_point_t const* gaze_point, void* user_data)
 
 		// only writting out data in main display mode
 		else {
-		
-			// getting timestamp strings
-			tobii_system_clock(manager->m_tobii_api, &tobii_time);
-			std::string reception_time_os = manager->get_micro_timestamp();
-			std::string reception_time_tobii = std::to_string(tobii_time);
-			std::string data_time_tobii = std::to_string(gaze_point->timestamp_us);
-
-			// defining the output string
-			std::string output_str = reception_time_os + "," + reception_time_tobii + "," + data_time_tobii + "," +
-				std::to_string(gaze_point->position_xy[0]) + "," + std::to_string(gaze_point->position_xy[1]) + "\n";
-
-			// writing to redis
-			manager->write_str_to_redis(manager->m_redis_entry, output_str);
-
-			// writing to output files, after passthrough check
-			if (!manager->get_pass_through()) {
-				manager->m_output_gaze_file << output_str;
-			}
-			
+			manager->push_sample({GazeSampleType::GAZE_POINT, manager->m_callbacks_time_os, manager->m_callbacks_time_tobii,
+				gaze_point->timestamp_us, {gaze_point->position_xy[0], gaze_point->position_xy[1], 0}});
 		}
 
 	}
@@ -55,27 +37,14 @@ void gaze_point_callback(tobii_gaze_point_t const* gaze_point, void* user_data)
 
 void head_pose_callback(tobii_head_pose_t const* head_pose, void* user_data) {
 
-	int64_t tobii_time;
 	GazeTracker* manager = (GazeTracker*)user_data;
 
 	if (head_pose->position_validity == TOBII_VALIDITY_VALID) {
 	
-		// only writting out data in main display mode
-		if (!manager->get_stream_preview_status() && !manager->get_pass_through()) {
-		
-			// getting timestamp strings
-			tobii_system_clock(manager->m_tobii_api, &tobii_time);
-			std::string reception_time_os = manager->get_micro_timestamp();
-			std::string reception_time_tobii = std::to_string(tobii_time);
-			std::string data_time_tobii = std::to_string(head_pose->timestamp_us);
-			
-			// defining the output string
-			std::string output_str = reception_time_os + "," + reception_time_tobii + "," + data_time_tobii + "," +
-				std::to_string(head_pose->position_xyz[0]) + "," + std::to_string(head_pose->position_xyz[1]) + "," + 
-				std::to_string(head_pose->position_xyz[2]) + "\n";
-
-			manager->m_output_head_file << output_str;
-
+		// only handling data in main display mode (the head distance is used by the gaze processing in pass through mode)
+		if (!manager->get_stream_preview_status()) {
+			manager->push_sample({GazeSampleType::HEAD_POSE, manager->m_callbacks_time_os, manager->m_callbacks_time_tobii,
+				head_pose->timestamp_us, {head_pose->position_xyz[0], head_pose->position_xyz[1], head_pose->position_xyz[2]}});
 		}
 
 	}
@@ -123,7 +92,10 @@ void GazeTracker::connect_device(void) {
 		// initializing communication (device level)
 		try {
 			
-			error = tobii_enumerate_local_device_urls(m_tobii_api, url_receiver, url);
+			// the device url can be forced (e.g. Tobii Stream Engine stand-in devices), the first local device is used otherwise
+			std::string device_url = (*m_config_ptr)["eye_tracker_device_url"];
+			if (!device_url.empty() && device_url.size() < sizeof(url)) strcpy(url, device_url.c_str());
+			else error = tobii_enumerate_local_device_urls(m_tobii_api, url_receiver, url);
 			error = tobii_device_create(m_tobii_api, url, TOBII_FIELD_OF_USE_INTERACTIVE, &m_tobii_device);
 			
 			// subscribing the gaze data callback
@@ -163,15 +135,26 @@ void GazeTracker::start_stream() {
 		set_output_file(m_output_folder_path);
 		m_output_head_file.open(m_output_head_str, std::fstream::app);
 		m_output_gaze_file.open(m_output_gaze_str, std::fstream::app);
+		m_output_filtered_file.open(m_output_filtered_str, std::fstream::app);
+		m_output_events_file.open(m_output_events_str, std::fstream::app);
+
+		// preparing the online gaze processing
+		configure_gaze_processing();
 
 		// connecting to redis (if redis enabled)
 		if (m_redis_state) {
 			m_redis_entry = (*m_config_ptr)["eye_tracker_redis_entry"];
 			m_redis_rate_div = std::atoi((*m_config_ptr)["eye_tracker_redis_rate_div"].c_str());
-			connect_to_redis({m_redis_entry});
+			connect_to_redis({m_redis_entry, m_redis_filtered_entry, m_redis_events_entry, m_redis_saliency_entry});
 		}
 
-		// launching the collection thread
+		// launching the processing and collection threads
+		m_n_dropped_samples = 0;
+		m_n_processed_samples = 0;
+		m_stream_start_time = get_micro_timestamp_count();
+		m_latest_gaze_valid = false;
+		m_process_samples = true;
+		m_processing_thread = std::thread(&GazeTracker::process_samples, this);
 		m_collect_data = true;
 		m_collection_thread = std::thread(&GazeTracker::collect_data, this);
 		m_device_streaming = true;
@@ -184,13 +167,27 @@ void GazeTracker::stop_stream() {
 	
 	if (m_device_connected && m_device_streaming) {
 	
-		// stop the streaming thread
+		// stop the streaming thread, then the processing thread (once the remaining samples are written)
 		m_collect_data = false;
 		m_collection_thread.join();
+		m_process_samples = false;
+		m_processing_thread.join();
+
+		double stream_duration_s = (get_micro_timestamp_count() - m_stream_start_time) / 1000000.0;
+		write_debug_output("GazeTracker - processed samples : " + QString::number(m_n_processed_samples) + 
+			" (" + QString::number(m_n_processed_samples / std::max(stream_duration_s, 1e-6), 'f', 1) + " samples / s)");
+		if (m_n_dropped_samples > 0) {
+			write_debug_output("GazeTracker - dropped samples (processing overrun) : " + QString::number(m_n_dropped_samples));
+		}
+		if (m_saliency_active) {
+			write_debug_output("GazeTracker - published saliency maps : " + QString::number(m_n_saliency_maps));
+		}
 
 		// closing the output file redis connection
 		m_output_gaze_file.close();
 		m_output_head_file.close();
+		m_output_filtered_file.close();
+		m_output_events_file.close();
 		disconnect_from_redis();
 	
 		m_device_streaming = false;
@@ -208,8 +205,12 @@ void GazeTracker::set_output_file(const std::string& output_folder_path) {
 		// defining the output files
 		m_output_head_str = output_folder_path + "/eye_tracker_head.csv";
 		m_output_gaze_str = output_folder_path + "/eye_tracker_gaze.csv";
+		m_output_filtered_str = output_folder_path + "/eye_tracker_gaze_filtered.csv";
+		m_output_events_str = output_folder_path + "/eye_tracker_events.csv";
 		if (m_output_head_file.is_open()) m_output_head_file.close();
 		if (m_output_gaze_file.is_open()) m_output_gaze_file.close();
+		if (m_output_filtered_file.is_open()) m_output_filtered_file.close();
+		if (m_output_events_file.is_open()) m_output_events_file.close();
 
 		// writting the head pose file header
 		m_output_head_file.open(m_output_head_str);
@@ -221,6 +222,15 @@ void GazeTracker::set_output_file(const std::string& output_folder_path) {
 		m_output_gaze_file << "Reception OS time,Reception tobii time,Onboard time,X,Y" << std::endl;
 		m_output_gaze_file.close();
 
+		// writting the online gaze processing file headers
+		m_output_filtered_file.open(m_output_filtered_str);
+		m_output_filtered_file << "OS acquisition time,X,Y,X display,Y display" << std::endl;
+		m_output_filtered_file.close();
+
+		m_output_events_file.open(m_output_events_str);
+		m_output_events_file << "Type,Start OS acquisition time,End OS acquisition time,X display,Y display,End X display,End Y display" << std::endl;
+		m_output_events_file.close();
+
 		m_output_file_loaded = true;
 
 	} catch (...) {
@@ -236,9 +246,230 @@ void GazeTracker::set_output_file(const std::string& output_folder_path) {
 void GazeTracker::collect_data(void) {
 
 	// continuously wait for data and call callbacks
+	// (the reception times are sampled once per call, for all of the samples it delivers)
 	while (m_collect_data) {
 		tobii_wait_for_callbacks(1, &m_tobii_device);
+		tobii_system_clock(m_tobii_api, &m_callbacks_time_tobii);
+		m_callbacks_time_os = get_micro_timestamp_count();
 		tobii_device_process_callbacks(m_tobii_device);
 	}
 
+}
+
+void GazeTracker::push_sample(const GazeSample& sample) {
+	if (!m_sample_ring.try_push(sample)) m_n_dropped_samples++;
+}
+
+void GazeTracker::process_samples(void) {
+
+	std::vector<GazeSample> samples(GAZE_SAMPLE_BATCH_SIZE);
+	std::vector<std::string> gaze_strs;
+	std::string gaze_file_str, head_file_str;
+	std::vector<FilteredGazePoint> filtered_points;
+	std::vector<GazeEvent> gaze_events;
+
+	while (true) {
+
+		// the ring is checked after the stop flag, so that no sample is left behind
+		bool processing = m_process_samples;
+		size_t n_samples = m_sample_ring.pop_batch(samples.data(), samples.size());
+
+		if (n_samples == 0) {
+			if (!processing) break;
+			publish_saliency_map();
+			std::this_thread::sleep_for(std::chrono::milliseconds(GAZE_PROCESSING_WAIT_MS));
+			continue;
+		}
+
+		// formatting the batch
+		m_n_processed_samples += n_samples;
+		gaze_strs.clear();
+		gaze_file_str.clear();
+		head_file_str.clear();
+		filtered_points.clear();
+		gaze_events.clear();
+		const GazeSample* latest_gaze_sample_p = nullptr;
+
+		for (size_t i = 0; i < n_samples; i++) {
+
+			const GazeSample& sample = samples[i];
+			std::string output_str = std::to_string(sample.reception_time_os) + "," + std::to_string(sample.reception_time_tobii) + "," + 
+				std::to_string(sample.data_time_tobii) + "," + std::to_string(sample.position[0]) + "," + std::to_string(sample.position[1]);
+
+			if (sample.type == GazeSampleType::GAZE_POINT) {
+				output_str += "\n";
+				gaze_file_str += output_str;
+				gaze_strs.push_back(std::move(output_str));
+				latest_gaze_sample_p = &sample;
+			} else if (!m_pass_through) {
+				head_file_str += output_str + "," + std::to_string(sample.position[2]) + "\n";
+			}
+
+			// online gaze processing (acquisition time in the OS time domain)
+			if (m_gaze_processing) {
+				if (sample.type == GazeSampleType::GAZE_POINT) {
+					int64_t acquisition_time_os = sample.reception_time_os - (sample.reception_time_tobii - sample.data_time_tobii);
+					m_gaze_processor.add_gaze_point(acquisition_time_os, sample.position[0], sample.position[1], filtered_points, gaze_events);
+				} else {
+					m_gaze_processor.add_head_pose(sample.position[2]);
+				}
+			}
+
+		}
+
+		write_gaze_processing_outputs(filtered_points, gaze_events);
+
+		if (latest_gaze_sample_p != nullptr) {
+			std::lock_guard<std::mutex> latest_gaze_lock(m_latest_gaze_mtx);
+			m_latest_gaze_sample = *latest_gaze_sample_p;
+			m_latest_gaze_valid = true;
+		}
+
+		// updating the saliency map (the sigma follows the head distance)
+		if (m_saliency_active && !filtered_points.empty()) {
+			int sigma = GazeSaliencyMap::compute_sigma(m_gaze_processor.get_head_distance(), m_gaze_processor_params.screen_width,
+				m_gaze_processor_params.phys_screen_width, m_gaze_processor_params.display_width, m_saliency_map.get_width());
+			for (const FilteredGazePoint& point : filtered_points) {
+				m_saliency_map.add_point(point.time_os, point.x_display, point.y_display, sigma);
+			}
+		}
+		publish_saliency_map();
+
+		// writing to redis
+		if (!gaze_strs.empty()) write_strs_to_redis(m_redis_entry, gaze_strs);
+
+		// writing to output files, after passthrough check
+		if (!m_pass_through) {
+			m_output_gaze_file << gaze_file_str;
+			m_output_head_file << head_file_str;
+		}
+
+	}
+
+	// the last point and the ongoing fixation are output when the stream ends
+	if (m_gaze_processing) {
+		filtered_points.clear();
+		gaze_events.clear();
+		m_gaze_processor.flush(filtered_points, gaze_events);
+		write_gaze_processing_outputs(filtered_points, gaze_events);
+	}
+
+}
+
+void GazeTracker::set_display_geometry(int screen_width, int screen_height, int display_x, int display_y, int display_width, int display_height) {
+	m_gaze_processor_params.screen_width = screen_width;
+	m_gaze_processor_params.screen_height = screen_height;
+	m_gaze_processor_params.display_x = display_x;
+	m_gaze_processor_params.display_y = display_y;
+	m_gaze_processor_params.display_width = display_width;
+	m_gaze_processor_params.display_height = display_height;
+}
+
+void GazeTracker::configure_gaze_processing(void) {
+
+	m_gaze_processing = (*m_config_ptr)["eye_tracker_processing"] == "true";
+	m_redis_filtered_entry = (*m_config_ptr)["eye_tracker_filtered_redis_entry"];
+	m_redis_events_entry = (*m_config_ptr)["eye_tracker_events_redis_entry"];
+
+	// each physical / filtering parameter keeps its (sonopy) default value when undefined or invalid
+	auto load_param = [this](const std::string& param_name, auto& value, double unit_scale) {
+		try {
+			value = static_cast<std::remove_reference_t<decltype(value)>>(std::stod((*m_config_ptr)[param_name]) * unit_scale);
+		} catch (...) {
+			write_debug_output("GazeTracker - failed to load (" + QString::fromStdString(param_name) + "), using the default value");
+		}
+	};
+
+	GazeProcessorParams& params = m_gaze_processor_params;
+	load_param("eye_tracker_phys_screen_width", params.phys_screen_width, 1);
+	load_param("eye_tracker_phys_screen_height", params.phys_screen_height, 1);
+	load_param("eye_tracker_max_gaze_speed", params.max_gaze_speed, 1);
+	load_param("eye_tracker_default_head_position", params.default_head_position, 1);
+	load_param("eye_tracker_x_offset", params.gaze_x_offset, 1);
+	load_param("eye_tracker_y_offset", params.gaze_y_offset, 1);
+	load_param("eye_tracker_min_fixation_ms", params.min_fixation_duration, 1000);
+
+	m_gaze_processor.configure(params);
+
+	// saliency map (same height / width ratio as the US image display)
+	m_saliency_active = m_gaze_processing && (*m_config_ptr)["eye_tracker_saliency"] == "true";
+	m_redis_saliency_entry = (*m_config_ptr)["eye_tracker_saliency_redis_entry"];
+	m_saliency_request_time = 0;
+	m_n_saliency_maps = 0;
+
+	int map_width = 50;
+	int64_t time_window = 200000;
+	load_param("eye_tracker_saliency_width", map_width, 1);
+	load_param("eye_tracker_saliency_window_ms", time_window, 1000);
+
+	int map_height = static_cast<int>(params.display_height * (static_cast<double>(map_width) / params.display_width));
+	m_saliency_map.configure(map_width, map_height, time_window);
+
+}
+
+void GazeTracker::write_gaze_processing_outputs(const std::vector<FilteredGazePoint>& points, const std::vector<GazeEvent>& events) {
+
+	if (points.empty() && events.empty()) return;
+
+	// formatting the filtered points
+	std::string points_file_str;
+	std::vector<std::string> points_strs;
+	for (const FilteredGazePoint& point : points) {
+		points_strs.push_back(std::to_string(point.time_os) + "," + std::to_string(point.x) + "," + std::to_string(point.y) + "," +
+			std::to_string(point.x_display) + "," + std::to_string(point.y_display) + "\n");
+		points_file_str += points_strs.back();
+	}
+
+	// formatting the fixations / saccades
+	std::string events_file_str;
+	std::vector<std::string> events_strs;
+	for (const GazeEvent& event : events) {
+		std::string type_str = (event.type == GazeEventType::FIXATION) ? "fixation" : "saccade";
+		events_strs.push_back(type_str + "," + std::to_string(event.start_time_os) + "," + std::to_string(event.end_time_os) + "," + 
+			std::to_string(event.x_display) + "," + std::to_string(event.y_display) + "," +
+			std::to_string(event.end_x_display) + "," + std::to_string(event.end_y_display) + "\n");
+		events_file_str += events_strs.back();
+	}
+
+	// all outputs are published (no rate division)
+	write_strs_to_redis(m_redis_filtered_entry, points_strs, false);
+	write_strs_to_redis(m_redis_events_entry, events_strs, false);
+
+	if (!m_pass_through) {
+		m_output_filtered_file << points_file_str;
+		m_output_events_file << events_file_str;
+	}
+
+}
+
+void GazeTracker::request_saliency_map(long long display_time_os) {
+	if (m_saliency_active) m_saliency_request_time = display_time_os;
+}
+
+void GazeTracker::publish_saliency_map(void) {
+
+	long long display_time_os = m_saliency_request_time.exchange(0);
+	if (display_time_os == 0) return;
+
+	// the map covers the time window preceding the display of the US image
+	m_saliency_map.expire_points(display_time_os);
+	m_saliency_map.get_map(m_saliency_values);
+
+	cv::Mat saliency_mat(m_saliency_map.get_height(), m_saliency_map.get_width(), CV_32FC1, m_saliency_values.data());
+	write_img_to_redis(m_redis_saliency_entry, saliency_mat, false);
+	m_n_saliency_maps++;
+
+}
+
+bool GazeTracker::get_latest_gaze_point(long long& time_os, float& x, float& y) {
+
+	std::lock_guard<std::mutex> latest_gaze_lock(m_latest_gaze_mtx);
+	if (!m_latest_gaze_valid) return false;
+
+	// acquisition time in the OS time domain
+	time_os = m_latest_gaze_sample.reception_time_os - (m_latest_gaze_sample.reception_time_tobii - m_latest_gaze_sample.data_time_tobii);
+	x = m_latest_gaze_sample.position[0];
+	y = m_latest_gaze_sample.position[1];
+	return true;
+
 }
\ No newline at end of file
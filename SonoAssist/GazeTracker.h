@@ -1,17 +1,63 @@
 #pragma once
 
 #include "SensorDevice.h"
+#include "SPSCRingBuffer.h"
+#include "GazeProcessor.h"
+#include "GazeSaliencyMap.h"
 
+#include <mutex>
+#include <atomic>
 #include <string>
 #include <thread>
+#include <vector>
+#include <chrono>
+#include <cstdint>
 #include <fstream>
+#include <type_traits>
 #include <exception>
 
 #include <tobii/tobii.h>
 #include <tobii/tobii_streams.h>
 
+// sample hand over (callbacks -> processing thread)
+#define GAZE_SAMPLE_RING_SIZE 4096
+#define GAZE_SAMPLE_BATCH_SIZE 256
+#define GAZE_PROCESSING_WAIT_MS 5
+
+/**
+* Type of eye tracker sample
+*/
+enum class GazeSampleType : uint8_t {
+	GAZE_POINT,
+	HEAD_POSE
+};
+
+/**
+* Eye tracker sample, as received by the callbacks (plain data, copied through the sample ring buffer)
+*/
+struct GazeSample {
+	GazeSampleType type;
+	int64_t reception_time_os;
+	int64_t reception_time_tobii;
+	int64_t data_time_tobii;
+	float position[3];
+};
+
 /*
 * Class to enable communication with the tobii eye tracker 4C
+*
+* The Stream Engine callbacks only copy the samples in a lock-free ring buffer, the formatting, redis publication and
+* file writing is done in batches by a seperate processing thread. This keeps the callback loop short at high gaze rates.
+*
+* When (eye_tracker_processing) is "true", the processing thread also runs the online gaze processing (see GazeProcessor) :
+* the filtered gaze points and the detected fixations / saccades are written to (eye_tracker_gaze_filtered.csv) and
+* (eye_tracker_events.csv) and published to redis as they are produced.
+*
+* The eye tracker is selected with (eye_tracker_device_url), the first local device is used when it is empty. When built with the
+* TOBII_STAND_IN option, the url selects replayed or synthetic data instead (see TobiiStandIn/TobiiStandIn.cpp).
+*
+* When (eye_tracker_saliency) is also "true", the filtered gaze points feed a saliency map (see GazeSaliencyMap) covering the
+* last (eye_tracker_saliency_window_ms). The map is published to redis (float32, row major) once per displayed US image (see request_saliency_map).
 */
 class GazeTracker : public SensorDevice {
 
@@ -28,16 +74,50 @@ class GazeTracker : public SensorDevice {
 		void connect_device(void) override;
 		void disconnect_device(void) override;
 		void set_output_file(const std::string& output_folder) override;
+
+		/**
+		* Defines the screen and US image display geometry used by the online gaze processing.
+		*
+		* \param screen_width The width (px) of the screen.
+		* \param screen_height The height (px) of the screen.
+		* \param display_x The x position (px) of the US image display on the screen.
+		* \param display_y The y position (px) of the US image display on the screen.
+		* \param display_width The width (px) of the US image display.
+		* \param display_height The height (px) of the US image display.
+		*/
+		void set_display_geometry(int screen_width, int screen_height, int display_x, int display_y, int display_width, int display_height);
+
+		/**
+		* Requests the publication of the saliency map by the processing thread (never blocks, pending requests are merged).
+		*
+		* \param display_time_os The OS time (us) at which the current US image was displayed.
+		*/
+		void request_saliency_map(long long display_time_os);
+
+		/**
+		* Provides the latest gaze point handled by the processing thread.
+		*
+		* \param time_os The OS acquisition time (us) of the gaze point.
+		* \param x The relative x coordinate on the screen.
+		* \param y The relative y coordinate on the screen.
+		* \return (false) if no gaze point was handled since the start of the stream.
+		*/
+		bool get_latest_gaze_point(long long& time_os, float& x, float& y);
 		
+		/**
+		* Hands a sample over to the processing thread (called from the callbacks, never blocks).
+		* Samples are dropped (and counted) when the processing thread does not keep up.
+		*/
+		void push_sample(const GazeSample& sample);
+
 		// tobii communication vars (accessed from callbacks)
 		bool m_tobii_api_valid = false;
 		tobii_api_t* m_tobii_api = nullptr;
 		tobii_device_t* m_tobii_device = nullptr;
 
-		// output file attributes + redis
-		std::string m_redis_entry = "";
-		std::ofstream m_output_gaze_file;
-		std::ofstream m_output_head_file;
+		// reception times of the samples processed by the current (tobii_device_process_callbacks) call
+		int64_t m_callbacks_time_os = 0;
+		int64_t m_callbacks_time_tobii = 0;
 
 	private:
 
@@ -48,15 +128,73 @@ class GazeTracker : public SensorDevice {
 		*/
 		void collect_data(void);
 
+		/**
+		* Formats, publishes and writes the samples handed over by the callbacks, in batches.
+		* This function is meant to be ran in a seperate thread. It returns once (m_process_samples) is false and all samples are processed.
+		*/
+		void process_samples(void);
+
+		/**
+		* Loads the online gaze processing configurations and resets the gaze processor.
+		*/
+		void configure_gaze_processing(void);
+
+		/**
+		* Formats, publishes and writes the outputs of the gaze processor.
+		*/
+		void write_gaze_processing_outputs(const std::vector<FilteredGazePoint>& points, const std::vector<GazeEvent>& events);
+
+		/**
+		* Publishes the saliency map if its publication was requested since the last call.
+		*/
+		void publish_saliency_map(void);
+
+		// output file attributes + redis
+		std::string m_redis_entry = "";
+		std::ofstream m_output_gaze_file;
+		std::ofstream m_output_head_file;
+		std::ofstream m_output_filtered_file;
+		std::ofstream m_output_events_file;
+
 		// output file vars
 		bool m_output_file_loaded = false;
 		std::string m_output_gaze_str = "";
 		std::string m_output_head_str = "";
+		std::string m_output_filtered_str = "";
+		std::string m_output_events_str = "";
 
 		// streaming vars
 		bool m_collect_data = false;
 		std::thread m_collection_thread;
 
+		// sample processing vars
+		std::atomic<bool> m_process_samples = false;
+		std::thread m_processing_thread;
+		std::atomic<uint64_t> m_n_dropped_samples = 0;
+		uint64_t m_n_processed_samples = 0;
+		long long m_stream_start_time = 0;
+		SPSCRingBuffer<GazeSample, GAZE_SAMPLE_RING_SIZE> m_sample_ring;
+
+		// online gaze processing vars
+		bool m_gaze_processing = false;
+		std::string m_redis_filtered_entry = "";
+		std::string m_redis_events_entry = "";
+		GazeProcessor m_gaze_processor;
+		GazeProcessorParams m_gaze_processor_params;
+
+		// saliency map vars
+		bool m_saliency_active = false;
+		std::string m_redis_saliency_entry = "";
+		GazeSaliencyMap m_saliency_map;
+		std::vector<float> m_saliency_values;
+		std::atomic<long long> m_saliency_request_time = 0;
+		uint64_t m_n_saliency_maps = 0;
+
+		// latest gaze point (shared with the UI thread)
+		std::mutex m_latest_gaze_mtx;
+		bool m_latest_gaze_valid = false;
+		GazeSample m_latest_gaze_sample;
+
 	signals:
 		void new_gaze_point(float x, float y);
 };
@@ -73,7 +211,7 @@ void url_receiver(char const* url, void* user_data);
 
 /**
 * Callback function for the collection of head position data (x, y, z coordinates (mm) from the center of the screen)
-* This function is called by the collection thread every time a new measure is available
+* This function is called by the collection thread every time a new measure is available, it hands the sample over to the processing thread
 *
 * \param gaze_point structure containing the head pose data
 * \param user_data voided context variable which was passed to the API upon callback registration.
@@ -83,7 +221,7 @@ void head_pose_callback(tobii_head_pose_t const* head_pose, void* user_data);
 
 /**
 * Callback function for the collection of gaze point data ( relative (x, y) coordinates on the screen)
-* This function is called by the collection thread every time a new gaze point is available
+* This function is called by the collection thread every time a new gaze point is available, it hands the sample over to the processing thread
 *
 * \param gaze_point structure containing the gaze point data
 * \param user_data voided context variable which was passed to the API upon callback registration. Pointer
@@ -0,0 +1,178 @@
+#include "ImgTensorPreprocessor.h"
+
+#include <cmath>
+#include <algorithm>
+
+#ifdef IMG_TENSOR_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+// gray scale conversion weights (same as cv::cvtColor)
+#define GRAY_B_WEIGHT 0.114f
+#define GRAY_G_WEIGHT 0.587f
+#define GRAY_R_WEIGHT 0.299f
+
+// minimum overlap (source pixels) for a source pixel to contribute to an output pixel
+#define AREA_MIN_OVERLAP 1e-6
+
+/*******************************************************************************
+* CONFIGURATION
+******************************************************************************/
+
+void ImgTensorPreprocessor::configure(cv::Size output_size, const cv::Mat& mask, float pix_mean, float pix_std_div) {
+
+	m_output_size = output_size;
+	m_input_size = cv::Size();
+
+	size_t n_pixels = output_size.area();
+	m_scale.assign(n_pixels, 1.f / pix_std_div);
+	m_offset.assign(n_pixels, -pix_mean / pix_std_div);
+
+	// masked pixels are zeroed before the normalization (only the offset remains)
+	if (mask.size() == output_size && mask.type() == CV_8UC1) {
+		for (int y = 0; y < output_size.height; y++) {
+			const uint8_t* mask_row = mask.ptr<uint8_t>(y);
+			for (int x = 0; x < output_size.width; x++) {
+				if (mask_row[x] == 0) m_scale[y * output_size.width + x] = 0;
+			}
+		}
+	}
+
+	m_row_buffer.assign(output_size.width, 0);
+
+}
+
+void ImgTensorPreprocessor::build_weights(int source_len, int output_len, std::vector<AreaWeight>& weights) {
+
+	weights.clear();
+
+	// every output pixel covers [i * scale, (i + 1) * scale[ of the source, weighted by the overlap
+	// the weights of an output pixel sum to 1 (scale >= 1 matches cv::INTER_AREA, scale < 1 gives a box upscale)
+	double scale = static_cast<double>(source_len) / output_len;
+	for (int i = 0; i < output_len; i++) {
+
+		double start = i * scale;
+		double end = std::min(start + scale, static_cast<double>(source_len));
+		int source_end = std::min(static_cast<int>(std::ceil(end)), source_len);
+
+		for (int j = static_cast<int>(std::floor(start)); j < source_end; j++) {
+			double overlap = std::min<double>(j + 1, end) - std::max<double>(j, start);
+			if (overlap > AREA_MIN_OVERLAP) weights.push_back({j, i, static_cast<float>(overlap / (end - start))});
+		}
+
+	}
+
+}
+
+/*******************************************************************************
+* PROCESSING
+******************************************************************************/
+
+bool ImgTensorPreprocessor::process(const cv::Mat& input, float* output) {
+
+	int n_channels = input.channels();
+	if (input.empty() || input.depth() != CV_8U || m_output_size.area() == 0) return false;
+	if (n_channels != 1 && n_channels != 3 && n_channels != 4) return false;
+
+	// resize weights
+	if (input.size() != m_input_size) {
+		build_weights(input.cols, m_output_size.width, m_x_weights);
+		build_weights(input.rows, m_output_size.height, m_y_weights);
+		m_input_size = input.size();
+	}
+	m_accumulator.resize(static_cast<size_t>(input.cols) * n_channels);
+
+	auto write_row = [this, n_channels, output](int output_row) {
+		if (n_channels == 1) write_output_row<1>(output_row, output);
+		else if (n_channels == 3) write_output_row<3>(output_row, output);
+		else write_output_row<4>(output_row, output);
+		std::fill(m_accumulator.begin(), m_accumulator.end(), 0.f);
+	};
+
+	// the y weights are sorted by output row : an output row is complete when the next weight targets an other row
+	int output_row = 0;
+	std::fill(m_accumulator.begin(), m_accumulator.end(), 0.f);
+
+	for (const AreaWeight& y_weight : m_y_weights) {
+		if (y_weight.output_index != output_row) {
+			write_row(output_row);
+			output_row = y_weight.output_index;
+		}
+		accumulate_row(input.ptr<uint8_t>(y_weight.source_index), y_weight.weight);
+	}
+
+	write_row(output_row);
+	return true;
+
+}
+
+void ImgTensorPreprocessor::accumulate_row(const uint8_t* source_row, float weight) {
+
+	size_t i = 0;
+	size_t row_len = m_accumulator.size();
+	float* acc_p = m_accumulator.data();
+
+#ifdef IMG_TENSOR_USE_SSE2
+
+	// 16 values per iteration : u8 -> i16 -> i32 -> f32, then multiply-add
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 weight_v = _mm_set1_ps(weight);
+
+	for (; i + 16 <= row_len; i += 16) {
+
+		__m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source_row + i));
+		__m128i values_lo = _mm_unpacklo_epi8(values, zero);
+		__m128i values_hi = _mm_unpackhi_epi8(values, zero);
+
+		__m128 v0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(values_lo, zero));
+		__m128 v1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(values_lo, zero));
+		__m128 v2 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(values_hi, zero));
+		__m128 v3 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(values_hi, zero));
+
+		_mm_storeu_ps(acc_p + i, _mm_add_ps(_mm_loadu_ps(acc_p + i), _mm_mul_ps(v0, weight_v)));
+		_mm_storeu_ps(acc_p + i + 4, _mm_add_ps(_mm_loadu_ps(acc_p + i + 4), _mm_mul_ps(v1, weight_v)));
+		_mm_storeu_ps(acc_p + i + 8, _mm_add_ps(_mm_loadu_ps(acc_p + i + 8), _mm_mul_ps(v2, weight_v)));
+		_mm_storeu_ps(acc_p + i + 12, _mm_add_ps(_mm_loadu_ps(acc_p + i + 12), _mm_mul_ps(v3, weight_v)));
+
+	}
+
+#endif
+
+	for (; i < row_len; i++) acc_p[i] += source_row[i] * weight;
+
+}
+
+template <int N_CHANNELS>
+void ImgTensorPreprocessor::write_output_row(int output_row, float* output) {
+
+	// horizontal resampling + gray scale conversion of the accumulated row
+	std::fill(m_row_buffer.begin(), m_row_buffer.end(), 0.f);
+	float* row_p = m_row_buffer.data();
+	const float* acc_p = m_accumulator.data();
+
+	for (const AreaWeight& x_weight : m_x_weights) {
+		const float* pixel = acc_p + x_weight.source_index * N_CHANNELS;
+		float gray = (N_CHANNELS == 1) ? pixel[0] :
+			(GRAY_B_WEIGHT * pixel[0] + GRAY_G_WEIGHT * pixel[1] + GRAY_R_WEIGHT * pixel[2]);
+		row_p[x_weight.output_index] += gray * x_weight.weight;
+	}
+
+	// mask + normalization
+	int x = 0;
+	int width = m_output_size.width;
+	size_t row_offset = static_cast<size_t>(output_row) * width;
+
+	float* out_p = output + row_offset;
+	const float* scale_p = m_scale.data() + row_offset;
+	const float* offset_p = m_offset.data() + row_offset;
+
+#ifdef IMG_TENSOR_USE_SSE2
+	for (; x + 4 <= width; x += 4) {
+		__m128 value = _mm_mul_ps(_mm_loadu_ps(row_p + x), _mm_loadu_ps(scale_p + x));
+		_mm_storeu_ps(out_p + x, _mm_add_ps(value, _mm_loadu_ps(offset_p + x)));
+	}
+#endif
+
+	for (; x < width; x++) out_p[x] = row_p[x] * scale_p[x] + offset_p[x];
+
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <opencv2/opencv.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMG_TENSOR_USE_SSE2
+#endif
+
+/**
+* Class converting (regions of) 8 bit images in to normalized float model inputs, in a single pass.
+*
+* The area resize, the gray scale conversion, the masking and the normalization ((pixel - mean) / std_div) are
+* fused : the source rows are accumulated (precomputed area weights, 16 bytes at a time with SSE2) in to the row
+* of their output row, which is then resampled horizontally, converted to gray and normalized in one go.
+* The mask and the normalization are applied as a per pixel (scale, offset) pair. The resize and conversion being
+* linear, the result matches the resize -> cvtColor -> copyTo -> normalize chain (without its intermediate rounding).
+* The output is written in to a caller provided buffer (e.g. the data of a persistent input tensor) and no memory
+* is allocated once the weights are built.
+*/
+class ImgTensorPreprocessor {
+
+	public:
+
+		ImgTensorPreprocessor() {}
+
+		/**
+		* Defines the output dimensions, the mask and the normalization parameters.
+		*
+		* \param output_size The dimensions of the output (model input).
+		* \param mask The mask of the output (CV_8UC1, output dimensions, zero pixels are set to (-mean / std_div)), an empty Mat disables masking.
+		* \param pix_mean The mean pixel value (0 - 255 range).
+		* \param pix_std_div The pixel value standard deviation (0 - 255 range).
+		*/
+		void configure(cv::Size output_size, const cv::Mat& mask, float pix_mean, float pix_std_div);
+
+		/**
+		* Converts the provided image in to the output buffer. The resize weights are (re)built when the input dimensions change.
+		*
+		* \param input The input image or region of interest (CV_8UC1, CV_8UC3 (BGR) or CV_8UC4 (BGRA), may be non continuous).
+		* \param output The output buffer (output_size.area() floats, row major).
+		* \return (false) if the input is empty, of an unsupported type or if the preprocessor is not configured.
+		*/
+		bool process(const cv::Mat& input, float* output);
+
+		cv::Size get_output_size(void) const { return m_output_size; }
+
+	private:
+
+		/**
+		* Contribution of a source pixel (or row) to an output pixel (or row)
+		*/
+		struct AreaWeight {
+			int source_index;
+			int output_index;
+			float weight;
+		};
+
+		/**
+		* Builds the area resize weights of one axis (sorted by output, then source index).
+		*/
+		static void build_weights(int source_len, int output_len, std::vector<AreaWeight>& weights);
+
+		/**
+		* Adds a weighted source row to the accumulated row (m_accumulator).
+		*/
+		void accumulate_row(const uint8_t* source_row, float weight);
+
+		/**
+		* Resamples the accumulated row horizontally, converts it to gray scale, applies the mask + normalization
+		* and writes it to the output.
+		*/
+		template <int N_CHANNELS>
+		void write_output_row(int output_row, float* output);
+
+		cv::Size m_output_size;
+		cv::Size m_input_size;
+
+		// area resize weights (rebuilt when the input dimensions change)
+		std::vector<AreaWeight> m_x_weights;
+		std::vector<AreaWeight> m_y_weights;
+
+		// mask + normalization, as (value * scale + offset) per output pixel
+		std::vector<float> m_scale;
+		std::vector<float> m_offset;
+
+		// reused between frames (accumulated input row and resampled gray output row)
+		std::vector<float> m_accumulator;
+		std::vector<float> m_row_buffer;
+
+};
\ No newline at end of file
@@ -38,7 +38,10 @@ void MLModel::set_configuration(std::shared_ptr<config_map> config_ptr) {
 	// loading the specified pytorch model + model status
 	try {
 		m_model_status = (*m_config_ptr)[m_model_status_entry] == "true";
-		m_model = torch::jit::load((*m_config_ptr)[m_model_path_entry]);
+		if (m_model_status) {
+			configure_threads();
+			load_model((*m_config_ptr)[m_model_path_entry]);
+		}
 	} 
 	catch (const c10::Error& e) {
 		m_model_status = false;
@@ -110,123 +113,145 @@ void MLModel::write_str_to_redis(const std::string& redis_entry, std::string dat
 }
 
 /*******************************************************************************
-* HELPERS
+* INFERENCE ENGINE
 ******************************************************************************/
 
-/*
-* Writes debug output to QDebug (the debug console) and the debug output window
-*/
-void MLModel::write_debug_output(const QString& debug_str) {
+c10::IValue MLModel::run_inference(const std::vector<torch::jit::IValue>& inputs) {
 
-	QString out_str = QString(m_model_description.c_str()) + " - " + debug_str;
+	// no autograd tracking / version counter updates for the forward pass
+	c10::InferenceMode inference_guard;
 
-	// sending msg to the application and vs debug windows
-	qDebug() << "\n" + out_str;
-	emit debug_output(out_str);
+	auto forward_start = std::chrono::high_resolution_clock::now();
+	c10::IValue output = m_model.forward(inputs);
+	auto forward_end = std::chrono::high_resolution_clock::now();
 
-	// logging the message
-	m_log_file << out_str.toStdString() << std::endl;
+	m_inference_latencies.push_back(std::chrono::duration<float, std::milli>(forward_end - forward_start).count());
+	return output;
 
 }
 
-/*******************************************************************************
-* US IMAGE DETECTION
-******************************************************************************/
-
-USImgDetector::USImgDetector(const std::string& template_path) {
+void MLModel::init_inference_thread(void) {
 
-	try {
-		m_template_img = cv::imread(template_path, cv::IMREAD_GRAYSCALE);
-	} catch (...) {}
+	// with OpenMP, the team size set from the configuration thread does not apply to the other threads
+	at::init_num_threads();
+	if (m_intra_op_threads > 0) at::set_num_threads(m_intra_op_threads);
 
-	m_horizontal_kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(30, 1));
-	m_morph_kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(9, 9), cv::Point(4, 4));
-	
 }
 
-void USImgDetector::find_large_contours(cv::Mat& img, std::vector<std::vector<cv::Point>>& contours) {
+bool MLModel::warmup(const std::vector<torch::jit::IValue>& inputs) {
 
-	std::vector<cv::Vec4i> hierarchy;
-	cv::findContours(img, contours, hierarchy, cv::RETR_TREE, cv::CHAIN_APPROX_NONE);
+	bool valid_warmup = false;
 
-	for (auto it = contours.begin(); it != contours.end();) {
-		
-		if ((*it).size() < m_min_contour_size) {
-			it = contours.erase(it);
-		} else {
-			it++;
-		}
-	
+	// nothing may escape : the warmup runs on the evaluation thread while (start_stream) waits for it
+	try {
+		for (int i = 0; i < m_warmup_passes; i++) run_inference(inputs);
+		valid_warmup = true;
+	} catch (const c10::Error& e) {
+		write_debug_output("Failed during the model warmup : " + QString::fromStdString(e.msg()));
+	} catch (const std::exception& e) {
+		write_debug_output("Failed during the model warmup : " + QString::fromStdString(e.what()));
+	} catch (...) {
+		write_debug_output("Failed during the model warmup");
 	}
 
+	m_inference_latencies.clear();
+	return valid_warmup;
+
 }
 
-ImgDetectData USImgDetector::detect(const cv::Mat& img) {
+void MLModel::report_inference_latency(void) {
 
-	ImgDetectData detection_data;
-	detection_data.detected = false;
+	if (m_inference_latencies.empty()) return;
 
-	if (img.cols != 0 && m_template_img.cols != 0) {
+	std::vector<float> latencies = m_inference_latencies;
+	float p50 = get_percentile(latencies, 0.50f);
+	float p99 = get_percentile(latencies, 0.99f);
+	float max_latency = *std::max_element(latencies.begin(), latencies.end());
 
-		cv::Mat filter_img = cv::Mat::zeros(img.size(), CV_8UC1);
-		cv::Mat detection_img = cv::Mat::zeros(img.size(), CV_8UC1);
+	write_debug_output("Forward latency (" + QString::number(latencies.size()) + " passes) : p50 "
+		+ QString::number(p50, 'f', 2) + " ms, p99 " + QString::number(p99, 'f', 2) + " ms, max " + QString::number(max_latency, 'f', 2) + " ms");
 
-		// smoothing + tresholding
-		cv::cvtColor(img, detection_img, CV_BGRA2GRAY);
-		cv::bilateralFilter(detection_img, filter_img, 7, 75, 75);
-		cv::adaptiveThreshold(filter_img, detection_img, 255, cv::ADAPTIVE_THRESH_MEAN_C, cv::THRESH_BINARY_INV, 11, 2);
+	m_inference_latencies.clear();
 
-		// removing horizontal lines
-		cv::Mat h_lines;
-		std::vector<cv::Vec4i> h_hierarchy;
-		std::vector<std::vector<cv::Point>> h_contours;
-		cv::morphologyEx(detection_img, h_lines, cv::MORPH_OPEN, m_horizontal_kernel, cv::Point(-1, -1), 3);
-		cv::findContours(h_lines, h_contours, h_hierarchy, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
-		cv::drawContours(detection_img, h_contours, -1, (0), cv::FILLED);
+}
 
-		// morphology
-		cv::dilate(detection_img, detection_img, m_morph_kernel);
-		cv::erode(detection_img, detection_img, m_morph_kernel);
+float MLModel::get_percentile(std::vector<float>& values, float percentile) {
 
-		// detecting and going through large contours
+	if (values.empty()) return 0;
 
-		std::vector<std::vector<cv::Point>> contours, sub_contours;
-		find_large_contours(detection_img, contours);
+	size_t rank = static_cast<size_t>(std::ceil(percentile * values.size()));
+	auto rank_it = values.begin() + std::max<size_t>(rank, 1) - 1;
+	std::nth_element(values.begin(), rank_it, values.end());
+	return *rank_it;
 
-		for (auto& contour : contours) {
+}
 
-			// filling and eroding the current contour -> this will create subcontours
-			cv::Mat contour_img = cv::Mat::zeros(img.size(), CV_8UC1);
-			cv::drawContours(contour_img, std::vector<std::vector<cv::Point>>({ contour }), -1, (255), cv::FILLED);
-			cv::erode(contour_img, contour_img, m_morph_kernel);
+void MLModel::load_model(const std::string& model_path) {
 
-			// detecting and going through sub-contours
-			find_large_contours(contour_img, sub_contours);
-			for (auto& sub_contour : sub_contours) {
+	m_model = torch::jit::load(model_path);
+	m_model.eval();
 
-				// isolating the current sub contour
-				cv::Mat sub_contour_img = cv::Mat::zeros(img.size(), CV_8UC1);
-				cv::drawContours(sub_contour_img, std::vector<std::vector<cv::Point>>({ sub_contour }), -1, (255), cv::FILLED);
+	// folding the parameters / attributes into constants, then fusing ops (conv-bn, etc.) for inference
+	try {
+		m_model = torch::jit::optimize_for_inference(torch::jit::freeze(m_model));
+	} catch (const c10::Error& e) {
+		write_debug_output("Failed to optimize the model for inference, using the un-optimized module : " + QString::fromStdString(e.msg()));
+	}
+
+	// warmup pass count
+	try {
+		m_warmup_passes = std::max(0, std::stoi((*m_config_ptr)["ml_warmup_passes"]));
+	} catch (...) {
+		m_warmup_passes = ML_DEFAULT_WARMUP_PASSES;
+	}
 
-				// checking if the sub-contour matches the us template (detection)
-				float moments_d = cv::matchShapes(m_template_img, sub_contour_img, cv::CONTOURS_MATCH_I2, 0);
-				if (moments_d <= m_detection_tresh) {
+}
 
-					detection_data.detected = true;
-					detection_data.score = moments_d;
-					detection_data.bounding_box = cv::boundingRect(sub_contour);
-					detection_data.mask = (sub_contour_img.clone())(detection_data.bounding_box);
+void MLModel::configure_threads(void) {
 
-					break;
+	int intra_op_threads = ML_DEFAULT_INTRA_OP_THREADS;
+	int inter_op_threads = ML_DEFAULT_INTER_OP_THREADS;
 
-				}
+	try {
+		intra_op_threads = std::stoi((*m_config_ptr)["ml_intra_op_threads"]);
+	} catch (...) {}
+	try {
+		inter_op_threads = std::stoi((*m_config_ptr)["ml_inter_op_threads"]);
+	} catch (...) {}
 
-			}
+	// the intra-op pool can be resized at any time (re-applied on the evaluation thread, see init_inference_thread)
+	if (intra_op_threads > 0 && at::get_num_threads() != intra_op_threads) {
+		at::set_num_threads(intra_op_threads);
+	}
+	m_intra_op_threads = intra_op_threads;
 
+	// the inter-op pool can only be sized once, before any parallel work
+	if (inter_op_threads > 0 && at::get_num_interop_threads() != inter_op_threads) {
+		try {
+			at::set_num_interop_threads(inter_op_threads);
+		} catch (const c10::Error&) {
+			write_debug_output("The inter-op thread count can only be set once, keeping " + QString::number(at::get_num_interop_threads()) + " threads");
 		}
-
 	}
 
-	return detection_data;
+}
+
+/*******************************************************************************
+* HELPERS
+******************************************************************************/
+
+/*
+* Writes debug output to QDebug (the debug console) and the debug output window
+*/
+void MLModel::write_debug_output(const QString& debug_str) {
+
+	QString out_str = QString(m_model_description.c_str()) + " - " + debug_str;
+
+	// sending msg to the application and vs debug windows
+	qDebug() << "\n" + out_str;
+	emit debug_output(out_str);
+
+	// logging the message
+	m_log_file << out_str.toStdString() << std::endl;
 
 }
\ No newline at end of file
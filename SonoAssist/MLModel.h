@@ -3,7 +3,11 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include <atomic>
+#include <cmath>
+#include <chrono>
 #include <fstream>
+#include <algorithm>
 #include <exception>
 
 #include<QDebug>
@@ -12,15 +16,23 @@
 
 #undef slots
 #include <torch/script.h>
+#include <ATen/Parallel.h>
+#include <c10/core/InferenceMode.h>
 #define slots Q_SLOTS
 #include <opencv2/opencv.hpp>
 #include <sw/redis++/redis++.h>
 
 #include "SensorDevice.h"
+#include "USImgDetector.h"
 
 #define MODEL_DISPLAY_WIDTH 1260
 #define MODEL_DISPLAY_HEIGHT 720
 
+// inference engine defaults (when the params are missing from the config)
+#define ML_DEFAULT_INTRA_OP_THREADS 2
+#define ML_DEFAULT_INTER_OP_THREADS 1
+#define ML_DEFAULT_WARMUP_PASSES 5
+
 
 /*
 * Abstract class for the implementation of ML models loaded from torch scripts.
@@ -48,7 +60,9 @@ class MLModel : public QObject {
 		bool get_redis_state(void) const;
 
 		/**
-		* Loads the app configurations along with the torch script file located at (m_config_ptr[m_model_path_entry])
+		* Loads the app configurations along with the torch script file located at (m_config_ptr[m_model_path_entry]).
+		* The module is frozen and optimized for inference once, here, and the LibTorch thread pools are sized
+		* from the config (ml_intra_op_threads, ml_inter_op_threads).
 		*/
 		void set_configuration(std::shared_ptr<config_map> config_ptr);
 
@@ -85,7 +99,8 @@ class MLModel : public QObject {
 
 		/**
 		* Launches the model evaluation in an other thread.
-		* Must be non-blocking.
+		* Must be non-blocking, apart from the warmup passes (see warmup) which should run (on the evaluation
+		* thread) before it returns.
 		*/
 		virtual void start_stream(void) = 0;
 
@@ -98,9 +113,50 @@ class MLModel : public QObject {
 
 		void write_debug_output(const QString&);
 
+		/*******************************************************************************
+		* INFERENCE ENGINE
+		******************************************************************************/
+
+		/**
+		* Runs a forward pass of the model in inference mode (no autograd tracking) and records its latency.
+		*
+		* \param inputs The model inputs.
+		* \return The model output.
+		*/
+		c10::IValue run_inference(const std::vector<torch::jit::IValue>& inputs);
+
+		/**
+		* Applies the configured intra-op thread count to the calling thread. Must be called at the start of the
+		* thread running the forward passes (the OpenMP team size is a per thread setting).
+		*/
+		void init_inference_thread(void);
+
+		/**
+		* Runs (ml_warmup_passes) forward passes on the provided inputs, so that the profiling / optimization
+		* passes of the JIT and the thread pool creation happen before the first real prediction.
+		* Must run on the thread evaluating the model (after init_inference_thread), the latencies of the warmup
+		* passes are not recorded.
+		*
+		* \param inputs Model inputs with the expected shapes (values are irrelevant).
+		* \return (false) if a warmup pass failed (the error is written to the debug output, nothing is thrown).
+		*/
+		bool warmup(const std::vector<torch::jit::IValue>& inputs);
+
+		/**
+		* Writes the p50 / p99 / max forward latencies recorded since the last report to the debug output, then clears them.
+		*/
+		void report_inference_latency(void);
+
+		/**
+		* \param values The values (reordered by the call).
+		* \param percentile The percentile, in [0, 1].
+		* \return The nearest rank percentile of the values (0 when empty).
+		*/
+		static float get_percentile(std::vector<float>& values, float percentile);
+
 		int m_model_id;
 		bool m_model_status = false;
-		bool m_stream_status = false;
+		std::atomic<bool> m_stream_status = false; // read by the evaluation threads without locking
 		std::string m_model_description;
 
 		// configs vars
@@ -116,55 +172,25 @@ class MLModel : public QObject {
 		std::ofstream m_log_file;
 		torch::jit::script::Module m_model;
 
-	signals:
-		void debug_output(QString debug_str);
-		void new_us_img_detection(QImage image);
-
-};
-
-
-/**
-* Structure to encapsulates US image detection return data
-*/
-struct ImgDetectData {
-	bool detected;
-	float score;
-	cv::Mat mask;
-	cv::Rect bounding_box;
-};
-
-
-/**
-* Class for the implementation of automatic ultrasound shell shape detection 
-*/
-class USImgDetector {
-
-	public:
-
-		USImgDetector() {}
+	private:
 
-		/*
-		* \param template_path The path to the template for Ultrasound shell shapes (image file)
-		*/
-		USImgDetector(const std::string& template_path);
-		
-		/*
-		* Attempts to detect a ultrasound shell shape contour inside of the provided image.
-		* Part of the detection process use the template provided in the constructor.
-		* 
-		* \param img The image for which to perform the detection
-		* \return The detection data (ImgDetectData)
+		/**
+		* Loads the torch script module, then freezes it and optimizes it for inference.
+		* Falls back on the un-optimized module when the optimization fails (e.g. unsupported ops).
 		*/
-		ImgDetectData detect(const cv::Mat& img);
-
-	private:
+		void load_model(const std::string& model_path);
 
-		void find_large_contours(cv::Mat& img, std::vector<std::vector<cv::Point>>& contours);
+		/**
+		* Sets the intra-op and inter-op thread counts of LibTorch (process wide) from the config.
+		*/
+		void configure_threads(void);
 
-		int m_min_contour_size = 500;
-		float m_detection_tresh = 0.002;
+		int m_warmup_passes = ML_DEFAULT_WARMUP_PASSES;
+		int m_intra_op_threads = ML_DEFAULT_INTRA_OP_THREADS;
+		std::vector<float> m_inference_latencies;
 
-		cv::Mat m_template_img;
-		cv::Mat m_morph_kernel, m_horizontal_kernel;
+	signals:
+		void debug_output(QString debug_str);
+		void new_us_img_detection(QImage image);
 
 };
\ No newline at end of file
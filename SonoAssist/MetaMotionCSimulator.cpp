@@ -0,0 +1,375 @@
+#include "MetaMotionCSimulator.h"
+
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+
+// MetaWear module ids and registers (MetaWear protocol)
+#define MODULE_ACCELEROMETER 0x03
+#define MODULE_LOGGING 0x0B
+#define MODULE_GYRO 0x13
+#define MODULE_SENSOR_FUSION 0x19
+#define REGISTER_MODULE_INFO 0x80
+#define REGISTER_READ_FLAG 0x80
+#define REGISTER_POWER 0x01
+#define REGISTER_LOGGING_TIME 0x04
+#define REGISTER_ACC_DATA 0x04
+#define REGISTER_ACC_PACKED_DATA 0x1C
+#define REGISTER_GYRO_DATA 0x05
+#define REGISTER_GYRO_PACKED_DATA 0x07
+#define REGISTER_FUSION_EULER_ANGLES 0x08
+#define REGISTER_FUSION_LINEAR_ACC 0x0A
+
+// raw data scales (8 g and 2000 dps ranges)
+#define ACC_LSB_PER_G 4096.0f
+#define GYRO_LSB_PER_DPS 16.4f
+#define PACKED_N_SAMPLES 3
+
+/**
+* Module information of the simulated MetaMotionC (id -> implementation, revision), the other modules are reported as absent
+*/
+static const std::map<uint8_t, std::vector<uint8_t>> simulated_modules = {
+	{0x01, {0x00, 0x00}}, {0x02, {0x00, 0x01}}, {MODULE_ACCELEROMETER, {0x01, 0x01}}, {0x09, {0x00, 0x02}},
+	{0x0A, {0x00, 0x00}}, {MODULE_LOGGING, {0x00, 0x02}}, {0x0C, {0x00, 0x00}}, {0x0F, {0x00, 0x01}},
+	{MODULE_GYRO, {0x00, 0x01}}, {0x15, {0x00, 0x01}}, {MODULE_SENSOR_FUSION, {0x00, 0x00}}, {0xFE, {0x00, 0x02}}
+};
+
+static uint16_t register_key(uint8_t module_id, uint8_t register_id) {
+	return (module_id << 8) | register_id;
+}
+
+static void append_float(std::vector<uint8_t>& packet, float value) {
+	uint8_t bytes[sizeof(float)];
+	std::memcpy(bytes, &value, sizeof(float));
+	packet.insert(packet.end(), bytes, bytes + sizeof(float));
+}
+
+static void append_int16(std::vector<uint8_t>& packet, float value) {
+	int16_t raw_value = static_cast<int16_t>(std::max(-32768.f, std::min(32767.f, std::round(value))));
+	packet.push_back(raw_value & 0xFF);
+	packet.push_back((raw_value >> 8) & 0xFF);
+}
+
+/*******************************************************************************
+* CONSTRUCTOR & DESTRUCTOR
+******************************************************************************/
+
+MetaMotionCSimulator::MetaMotionCSimulator(const std::string& url) {
+
+	// parsing the url params (key=value&key=value)
+	size_t params_start = url.find('?');
+	std::stringstream params_stream((params_start == std::string::npos) ? "" : url.substr(params_start + 1));
+	std::string param;
+
+	while (std::getline(params_stream, param, '&')) {
+
+		size_t separator = param.find('=');
+		if (separator == std::string::npos) continue;
+		std::string key = param.substr(0, separator);
+		std::string value = param.substr(separator + 1);
+
+		try {
+			if (key == "fusion_hz") m_fusion_rate = std::max(1.f, std::stof(value));
+			else if (key == "raw_hz") m_raw_rate = std::max(1.f, std::stof(value));
+			else if (key == "loss") m_loss = std::max(0.f, std::min(1.f, std::stof(value)));
+			else if (key == "burst_every") m_burst_every = std::max(0LL, std::stoll(value));
+			else if (key == "burst_ms") m_burst_length = std::max(0LL, std::stoll(value));
+			else if (key == "connect_ms") m_connect_time = std::max(0, std::stoi(value));
+			else if (key == "seed") m_rng_state = std::max(1U, static_cast<uint32_t>(std::stoul(value)));
+		} catch (...) {}
+
+	}
+
+}
+
+MetaMotionCSimulator::~MetaMotionCSimulator() {
+	disconnect_transport();
+}
+
+/*******************************************************************************
+* CONNECTION
+******************************************************************************/
+
+void MetaMotionCSimulator::connect_transport(std::function<void(bool)> connection_handler) {
+
+	disconnect_transport();
+
+	{
+		std::lock_guard<std::mutex> state_guard(m_state_mutex);
+		m_notify_caller = nullptr;
+		m_notify_handler = nullptr;
+		m_fusion_running = m_acc_running = m_gyro_running = false;
+		m_notify_enabled.clear();
+	}
+
+	m_n_sent = 0;
+	m_n_dropped = 0;
+	m_connected = true;
+	uint32_t generation = ++m_generation;
+
+	// the generator thread reports the connection after the simulated connection time, then emits the data
+	std::weak_ptr<MetaMotionCSimulator> simulator_weak_p = weak_from_this();
+	m_generator_thread = std::thread([this, connection_handler, generation, simulator_weak_p]() {
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(m_connect_time));
+		m_dispatcher([simulator_weak_p, connection_handler, generation]() {
+			auto simulator_p = simulator_weak_p.lock();
+			if (simulator_p && simulator_p->m_connected && simulator_p->m_generation == generation) connection_handler(true);
+		});
+
+		generate_data();
+
+	});
+
+}
+
+void MetaMotionCSimulator::disconnect_transport(void) {
+
+	m_connected = false;
+	m_generation++;
+	if (m_generator_thread.joinable()) m_generator_thread.join();
+
+}
+
+bool MetaMotionCSimulator::is_simulator_url(const std::string& url) {
+	return url.rfind(SIMULATOR_URL_PREFIX, 0) == 0;
+}
+
+/*******************************************************************************
+* GATT OPERATIONS
+******************************************************************************/
+
+void MetaMotionCSimulator::read_gatt_char(const void* caller, const MblMwGattChar* characteristic, MblMwFnIntVoidPtrArray handler) {
+
+	// device information service characteristics (16 bit uuids)
+	std::string value;
+	switch ((characteristic->uuid_high >> 32) & 0xFFFF) {
+		case 0x2A26: value = SIMULATOR_FIRMWARE; break;
+		case 0x2A24: value = SIMULATOR_MODEL; break;
+		case 0x2A27: value = SIMULATOR_HARDWARE; break;
+		case 0x2A29: value = SIMULATOR_MANUFACTURER; break;
+		case 0x2A25: value = SIMULATOR_SERIAL; break;
+	}
+
+	uint32_t generation = m_generation;
+	std::weak_ptr<MetaMotionCSimulator> simulator_weak_p = weak_from_this();
+	m_dispatcher([simulator_weak_p, generation, caller, handler, value]() {
+		auto simulator_p = simulator_weak_p.lock();
+		if (simulator_p && simulator_p->m_generation == generation) {
+			handler(caller, reinterpret_cast<const uint8_t*>(value.data()), static_cast<uint8_t>(value.size()));
+		}
+	});
+
+}
+
+void MetaMotionCSimulator::write_gatt_char(MblMwGattCharWriteType write_type, const MblMwGattChar* characteristic, const uint8_t* value, uint8_t length) {
+
+	if (length < 2) return;
+	uint8_t module_id = value[0];
+	uint8_t register_id = value[1];
+
+	// module information and logging time requests
+	if (register_id == REGISTER_MODULE_INFO) {
+		answer_module_info(module_id);
+		return;
+	}
+	if (module_id == MODULE_LOGGING && register_id == (REGISTER_LOGGING_TIME | REGISTER_READ_FLAG)) {
+		uint32_t tick = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+		notify({MODULE_LOGGING, register_id, uint8_t(tick & 0xFF), uint8_t((tick >> 8) & 0xFF), uint8_t((tick >> 16) & 0xFF),
+			uint8_t((tick >> 24) & 0xFF), 0x00});
+		return;
+	}
+	if (length < 3) return;
+
+	// power (start / stop) and notification (subscribe / unsubscribe) commands
+	std::lock_guard<std::mutex> state_guard(m_state_mutex);
+	bool enabled = value[2] != 0;
+	if (register_id == REGISTER_POWER) {
+		if (module_id == MODULE_SENSOR_FUSION) m_fusion_running = enabled;
+		else if (module_id == MODULE_ACCELEROMETER) m_acc_running = enabled;
+		else if (module_id == MODULE_GYRO) m_gyro_running = enabled;
+	} else if ((module_id == MODULE_SENSOR_FUSION && (register_id == REGISTER_FUSION_EULER_ANGLES || register_id == REGISTER_FUSION_LINEAR_ACC))
+		|| (module_id == MODULE_ACCELEROMETER && (register_id == REGISTER_ACC_DATA || register_id == REGISTER_ACC_PACKED_DATA))
+		|| (module_id == MODULE_GYRO && (register_id == REGISTER_GYRO_DATA || register_id == REGISTER_GYRO_PACKED_DATA))) {
+		m_notify_enabled[register_key(module_id, register_id)] = enabled;
+	}
+
+}
+
+void MetaMotionCSimulator::enable_notifications(const void* caller, const MblMwGattChar* characteristic, MblMwFnIntVoidPtrArray handler,
+	MblMwFnVoidVoidPtrInt ready) {
+
+	{
+		std::lock_guard<std::mutex> state_guard(m_state_mutex);
+		m_notify_caller = caller;
+		m_notify_handler = handler;
+	}
+
+	uint32_t generation = m_generation;
+	std::weak_ptr<MetaMotionCSimulator> simulator_weak_p = weak_from_this();
+	m_dispatcher([simulator_weak_p, generation, caller, ready]() {
+		auto simulator_p = simulator_weak_p.lock();
+		if (simulator_p && simulator_p->m_generation == generation) ready(caller, 0);
+	});
+
+}
+
+std::string MetaMotionCSimulator::get_stats(void) const {
+	uint64_t n_sent = m_n_sent;
+	uint64_t n_dropped = m_n_dropped;
+	return "simulated notifications sent : " + std::to_string(n_sent) + ", dropped : " + std::to_string(n_dropped)
+		+ " (" + std::to_string(n_sent + n_dropped > 0 ? 100.0 * n_dropped / (n_sent + n_dropped) : 0.0) + " %)";
+}
+
+/*******************************************************************************
+* HELPER FUNCTIONS
+******************************************************************************/
+
+void MetaMotionCSimulator::notify(const std::vector<uint8_t>& packet) {
+
+	uint32_t generation = m_generation;
+	std::weak_ptr<MetaMotionCSimulator> simulator_weak_p = weak_from_this();
+	m_dispatcher([simulator_weak_p, generation, packet]() {
+
+		auto simulator_p = simulator_weak_p.lock();
+		if (!simulator_p || simulator_p->m_generation != generation) return;
+
+		const void* caller;
+		MblMwFnIntVoidPtrArray handler;
+		{
+			std::lock_guard<std::mutex> state_guard(simulator_p->m_state_mutex);
+			caller = simulator_p->m_notify_caller;
+			handler = simulator_p->m_notify_handler;
+		}
+		if (handler != nullptr) handler(caller, packet.data(), static_cast<uint8_t>(packet.size()));
+
+	});
+
+}
+
+void MetaMotionCSimulator::answer_module_info(uint8_t module_id) {
+
+	std::vector<uint8_t> response = {module_id, REGISTER_MODULE_INFO};
+	auto module_info = simulated_modules.find(module_id);
+	if (module_info != simulated_modules.end()) response.insert(response.end(), module_info->second.begin(), module_info->second.end());
+	notify(response);
+
+}
+
+void MetaMotionCSimulator::generate_data(void) {
+
+	auto start_time = std::chrono::steady_clock::now();
+	int64_t fusion_period = static_cast<int64_t>(1e6 / m_fusion_rate);
+	int64_t raw_period = static_cast<int64_t>(1e6 / m_raw_rate);
+	int64_t next_fusion_time = 0;
+	int64_t next_raw_time = 0;
+	std::vector<uint8_t> acc_packed_packet, gyro_packed_packet;
+
+	while (m_connected) {
+
+		int64_t time_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+
+		bool fusion_running, acc_running, gyro_running;
+		bool euler_notify, linear_acc_notify, acc_notify, acc_packed_notify, gyro_notify, gyro_packed_notify;
+		{
+			std::lock_guard<std::mutex> state_guard(m_state_mutex);
+			fusion_running = m_fusion_running;
+			acc_running = m_acc_running;
+			gyro_running = m_gyro_running;
+			euler_notify = m_notify_enabled[register_key(MODULE_SENSOR_FUSION, REGISTER_FUSION_EULER_ANGLES)];
+			linear_acc_notify = m_notify_enabled[register_key(MODULE_SENSOR_FUSION, REGISTER_FUSION_LINEAR_ACC)];
+			acc_notify = m_notify_enabled[register_key(MODULE_ACCELEROMETER, REGISTER_ACC_DATA)];
+			acc_packed_notify = m_notify_enabled[register_key(MODULE_ACCELEROMETER, REGISTER_ACC_PACKED_DATA)];
+			gyro_notify = m_notify_enabled[register_key(MODULE_GYRO, REGISTER_GYRO_DATA)];
+			gyro_packed_notify = m_notify_enabled[register_key(MODULE_GYRO, REGISTER_GYRO_PACKED_DATA)];
+		}
+
+		// sensor fusion outputs (slow probe motion)
+		for (; next_fusion_time <= time_us; next_fusion_time += fusion_period) {
+
+			if (!fusion_running) continue;
+			float t = next_fusion_time / 1e6f;
+
+			if (euler_notify) {
+				std::vector<uint8_t> packet = {MODULE_SENSOR_FUSION, REGISTER_FUSION_EULER_ANGLES};
+				float heading = 180.f + 30.f * std::sin(0.5f * t);
+				append_float(packet, heading);
+				append_float(packet, 10.f * std::sin(0.7f * t));
+				append_float(packet, 15.f * std::cos(0.3f * t));
+				append_float(packet, heading);
+				if (!drop_notification(next_fusion_time)) notify(packet);
+			}
+
+			if (linear_acc_notify) {
+				std::vector<uint8_t> packet = {MODULE_SENSOR_FUSION, REGISTER_FUSION_LINEAR_ACC};
+				append_float(packet, 0.05f * std::sin(2.f * t));
+				append_float(packet, 0.03f * std::cos(1.5f * t));
+				append_float(packet, 0.02f * std::sin(t));
+				if (!drop_notification(next_fusion_time)) notify(packet);
+			}
+
+		}
+
+		// accelerometer and gyroscope outputs (gravity + noise, slow rotation)
+		for (; next_raw_time <= time_us; next_raw_time += raw_period) {
+
+			float t = next_raw_time / 1e6f;
+			float acc[3] = {0.02f * (get_random() - 0.5f), 0.02f * (get_random() - 0.5f), 1.f + 0.02f * (get_random() - 0.5f)};
+			float gyro[3] = {20.f * std::sin(0.7f * t), 10.f * std::cos(0.3f * t), 15.f * std::sin(0.5f * t)};
+
+			if (acc_running && acc_notify) {
+				std::vector<uint8_t> packet = {MODULE_ACCELEROMETER, REGISTER_ACC_DATA};
+				for (float value : acc) append_int16(packet, value * ACC_LSB_PER_G);
+				if (!drop_notification(next_raw_time)) notify(packet);
+			}
+			if (acc_running && acc_packed_notify) {
+				if (acc_packed_packet.empty()) acc_packed_packet = {MODULE_ACCELEROMETER, REGISTER_ACC_PACKED_DATA};
+				for (float value : acc) append_int16(acc_packed_packet, value * ACC_LSB_PER_G);
+				if (acc_packed_packet.size() == 2 + PACKED_N_SAMPLES * 6) {
+					if (!drop_notification(next_raw_time)) notify(acc_packed_packet);
+					acc_packed_packet.clear();
+				}
+			}
+
+			if (gyro_running && gyro_notify) {
+				std::vector<uint8_t> packet = {MODULE_GYRO, REGISTER_GYRO_DATA};
+				for (float value : gyro) append_int16(packet, value * GYRO_LSB_PER_DPS);
+				if (!drop_notification(next_raw_time)) notify(packet);
+			}
+			if (gyro_running && gyro_packed_notify) {
+				if (gyro_packed_packet.empty()) gyro_packed_packet = {MODULE_GYRO, REGISTER_GYRO_PACKED_DATA};
+				for (float value : gyro) append_int16(gyro_packed_packet, value * GYRO_LSB_PER_DPS);
+				if (gyro_packed_packet.size() == 2 + PACKED_N_SAMPLES * 6) {
+					if (!drop_notification(next_raw_time)) notify(gyro_packed_packet);
+					gyro_packed_packet.clear();
+				}
+			}
+
+		}
+
+		std::this_thread::sleep_until(start_time + std::chrono::microseconds(time_us + SIMULATOR_TICK_US));
+
+	}
+
+}
+
+bool MetaMotionCSimulator::drop_notification(int64_t time_us) {
+
+	// burst losses (link congestion), then random losses
+	bool dropped = (m_burst_every > 0 && (time_us / 1000) % m_burst_every < m_burst_length) || (m_loss > 0 && get_random() < m_loss);
+	if (dropped) m_n_dropped++;
+	else m_n_sent++;
+	return dropped;
+
+}
+
+float MetaMotionCSimulator::get_random(void) {
+	// xorshift32, uniform in [0, 1)
+	m_rng_state ^= m_rng_state << 13;
+	m_rng_state ^= m_rng_state >> 17;
+	m_rng_state ^= m_rng_state << 5;
+	return (m_rng_state >> 8) / 16777216.f;
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "MetaWearTransport.h"
+
+#include <map>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+
+#define SIMULATOR_URL_PREFIX "metamotionc-sim://"
+
+// simulated board information (device information service)
+#define SIMULATOR_FIRMWARE "1.5.0"
+#define SIMULATOR_MODEL "5"
+#define SIMULATOR_HARDWARE "0.4"
+#define SIMULATOR_MANUFACTURER "MbientLab Inc"
+#define SIMULATOR_SERIAL "053AB5"
+
+// default params (rates in Hz, times in ms)
+#define SIMULATOR_DEFAULT_FUSION_RATE 100
+#define SIMULATOR_DEFAULT_RAW_RATE 100
+#define SIMULATOR_DEFAULT_CONNECT_TIME 50
+#define SIMULATOR_TICK_US 1000
+
+/**
+* In-process simulator of a MetaMotionC board, selected with its url (ext_imu_transport_url) :
+*
+*	metamotionc-sim://?fusion_hz=100&raw_hz=100&loss=0.01&burst_every=2000&burst_ms=100&connect_ms=50&seed=1
+*
+* The simulator answers the reads of the device information service and the module information / logging time requests
+* issued by (mbl_mw_metawearboard_initialize), then emits the notifications of the sensor fusion (euler angles, linear acceleration)
+* and accelerometer / gyroscope (single and packed) signals once they are subscribed to and started by the SDK.
+*
+* Losses : each data notification is dropped with the (loss) probability, and all of the notifications are dropped during
+* (burst_ms) every (burst_every) ms. Module responses are never dropped. Logging (onboard log download) is not simulated.
+*/
+class MetaMotionCSimulator : public MetaWearTransport, public std::enable_shared_from_this<MetaMotionCSimulator> {
+
+	public:
+
+		/**
+		* \param url The simulator url (see the class description), unknown params are ignored.
+		*/
+		MetaMotionCSimulator(const std::string& url);
+		~MetaMotionCSimulator();
+
+		void connect_transport(std::function<void(bool)> connection_handler) override;
+		void disconnect_transport(void) override;
+
+		void read_gatt_char(const void* caller, const MblMwGattChar* characteristic, MblMwFnIntVoidPtrArray handler) override;
+		void write_gatt_char(MblMwGattCharWriteType write_type, const MblMwGattChar* characteristic, const uint8_t* value, uint8_t length) override;
+		void enable_notifications(const void* caller, const MblMwGattChar* characteristic, MblMwFnIntVoidPtrArray handler,
+			MblMwFnVoidVoidPtrInt ready) override;
+
+		std::string get_stats(void) const override;
+
+		/**
+		* \return True if the url selects the simulator.
+		*/
+		static bool is_simulator_url(const std::string& url);
+
+	private:
+
+		/**
+		* Queues a notification (MetaWear notify characteristic) for the SDK, dropped if the connection changed in the meantime.
+		*/
+		void notify(const std::vector<uint8_t>& packet);
+
+		/**
+		* Answers the module information request of a module (present or not).
+		*/
+		void answer_module_info(uint8_t module_id);
+
+		/**
+		* Emits the due data notifications until the transport is disconnected (generator thread).
+		*/
+		void generate_data(void);
+		bool drop_notification(int64_t time_us);
+		float get_random(void);
+
+		// simulation params
+		float m_fusion_rate = SIMULATOR_DEFAULT_FUSION_RATE;
+		float m_raw_rate = SIMULATOR_DEFAULT_RAW_RATE;
+		float m_loss = 0;
+		int64_t m_burst_every = 0;
+		int64_t m_burst_length = 0;
+		int m_connect_time = SIMULATOR_DEFAULT_CONNECT_TIME;
+		uint32_t m_rng_state = 1;
+
+		// SDK handlers and board state (the generator thread reads the state)
+		mutable std::mutex m_state_mutex;
+		const void* m_notify_caller = nullptr;
+		MblMwFnIntVoidPtrArray m_notify_handler = nullptr;
+		bool m_fusion_running = false;
+		bool m_acc_running = false;
+		bool m_gyro_running = false;
+		std::map<uint16_t, bool> m_notify_enabled;
+
+		// connection state (the generation invalidates the queued handlers of previous connections)
+		std::atomic<bool> m_connected = false;
+		std::atomic<uint32_t> m_generation = 0;
+		std::thread m_generator_thread;
+
+		// stats
+		std::atomic<uint64_t> m_n_sent = 0;
+		std::atomic<uint64_t> m_n_dropped = 0;
+
+};
\ No newline at end of file
@@ -28,6 +28,11 @@ void on_disconnect_wrap(void* context, const void* caller, MblMwFnVoidVoidPtrInt
 
 void MetaWearBluetoothClient::read_gatt_char(const void* caller, const MblMwGattChar* characteristic, MblMwFnIntVoidPtrArray handler) {
 
+	if (m_transport_p != nullptr) {
+		m_transport_p->read_gatt_char(caller, characteristic, handler);
+		return;
+	}
+
 	int service_index;
 
 	// proceed if the required characteristic is valid
@@ -47,6 +52,11 @@ void MetaWearBluetoothClient::read_gatt_char(const void* caller, const MblMwGatt
 void MetaWearBluetoothClient::write_gatt_char(MblMwGattCharWriteType writeType, const MblMwGattChar* characteristic,
 	const uint8_t* value, uint8_t length) {
 
+	if (m_transport_p != nullptr) {
+		m_transport_p->write_gatt_char(writeType, characteristic, value, length);
+		return;
+	}
+
 	int service_index;
 
 	// proceed if the required characteristic is valid
@@ -75,6 +85,11 @@ void MetaWearBluetoothClient::write_gatt_char(MblMwGattCharWriteType writeType,
 void MetaWearBluetoothClient::enable_notifications(const void* caller, const MblMwGattChar* characteristic, MblMwFnIntVoidPtrArray handler,
 	MblMwFnVoidVoidPtrInt ready) {
 
+	if (m_transport_p != nullptr) {
+		m_transport_p->enable_notifications(caller, characteristic, handler, ready);
+		return;
+	}
+
 	int service_index;
 
 	// proceed if the required characteristic is valid
@@ -88,8 +103,8 @@ void MetaWearBluetoothClient::enable_notifications(const void* caller, const Mbl
 			// enabling notification for the descriptor
 			m_metawear_services_p[service_index]->writeDescriptor(notification, QByteArray::fromHex("0100"));
 
-			// adding an entry in the characteristic-callback map
-			m_char_update_callback_map[target_characteristic.uuid().toString()] = std::tuple<const void*, MblMwFnIntVoidPtrArray>(caller, handler);
+			// adding an entry in the characteristic-callback table
+			m_char_update_callback_table.insert(qt_uuid_to_key(target_characteristic.uuid()), std::tuple<const void*, MblMwFnIntVoidPtrArray>(caller, handler));
 			
 		}
 
@@ -135,11 +150,28 @@ MetaWearBluetoothClient::MetaWearBluetoothClient(int device_id, std::string devi
 			write_debug_output("MetaWearBluetoothClient - ble device discovery level error occured, code : " + QString(error));
 		});
 
+	// moving the client and its BLE objects to the BLE thread (their slots and callbacks run in its event loop)
+	m_ble_thread.setObjectName("MetaWearBLE");
+	m_discovery_agent.moveToThread(&m_ble_thread);
+	moveToThread(&m_ble_thread);
+	m_ble_thread.start();
+
 }
 
 MetaWearBluetoothClient::~MetaWearBluetoothClient() {
-	disconnect_device();
-	clear_metawear_connection();
+
+	// releasing the BLE objects from the BLE thread, the client is handed back to the destroying thread
+	QThread* destroying_thread = QThread::currentThread();
+	run_in_ble_thread([this, destroying_thread]() {
+		disconnect_device();
+		clear_metawear_connection();
+		m_discovery_agent.moveToThread(destroying_thread);
+		moveToThread(destroying_thread);
+	}, true);
+
+	m_ble_thread.quit();
+	m_ble_thread.wait();
+
 }
 
 /*******************************************************************************
@@ -148,12 +180,39 @@ MetaWearBluetoothClient::~MetaWearBluetoothClient() {
 
 void MetaWearBluetoothClient::connect_device() {
 
+	if (!in_ble_thread()) {
+		run_in_ble_thread([this]() { connect_device(); }, false);
+		return;
+	}
+
 	// making sure that requirements have been loaded
 	if (m_config_loaded && m_sensor_used) {
 		
 		clear_metawear_connection();
+		m_connect_start_time = std::chrono::steady_clock::now();
+
+		// connecting through the configured transport (e.g. simulator) instead of the Qt BLE services
+		std::string transport_url = (*m_config_ptr)["ext_imu_transport_url"];
+		if (!transport_url.empty()) {
+			connect_transport(transport_url);
+			return;
+		}
+		if (m_transport_p != nullptr) clear_connection_cache();
+		m_transport_p.reset();
+		m_transport_url = "";
+
+		// reconnecting to the cached device (no scan) when the target address did not change
+		QString target_device_adress((*m_config_ptr)["ext_imu_ble_address"].c_str());
+		m_cached_connection = m_device_cached && !m_used_service_uuids.isEmpty() && m_cached_device_info.address().toString() == target_device_adress;
+		if (m_cached_connection) {
+			m_metawear_device_controller_p = std::shared_ptr<QLowEnergyController>(QLowEnergyController::createCentral(m_cached_device_info));
+			write_debug_output("MetaWearBluetoothClient - reconnecting to the cached device : " + target_device_adress + "\n");
+			device_discovery_finished();
+			return;
+		}
 
 		// launching device discovery
+		clear_connection_cache();
 		m_discovery_agent.start(QBluetoothDeviceDiscoveryAgent::LowEnergyMethod);
 		write_debug_output("MetaWearBluetoothClient - starting device scan\n");
 	}
@@ -162,7 +221,25 @@ void MetaWearBluetoothClient::connect_device() {
 
 void MetaWearBluetoothClient::disconnect_device() {
 
+	if (!in_ble_thread()) {
+		run_in_ble_thread([this]() { disconnect_device(); }, true);
+		return;
+	}
+
 	stop_stream();
+
+	// an interrupted log download leaves the entries on the board
+	if (m_log_downloading) {
+		write_debug_output("MetaWearBluetoothClient - onboard log download interrupted by the disconnection");
+		finish_log_download(false);
+	}
+
+	// the answer to a pending logging setup step is not expected anymore (ignored if it arrives)
+	if (m_log_setup_pending) {
+		m_log_setup_pending = false;
+		m_log_setup_cancelled = false;
+		finish_log_download(false);
+	}
 	
 	// changing the device state
 	m_device_connected = false;
@@ -174,12 +251,28 @@ void MetaWearBluetoothClient::disconnect_device() {
 
 void MetaWearBluetoothClient::start_stream() {
 
+	if (!in_ble_thread()) {
+		run_in_ble_thread([this]() { start_stream(); }, true);
+		return;
+	}
+
+	if (m_log_downloading) {
+		write_debug_output("MetaWearBluetoothClient - the onboard log of the previous acquisition is still downloading");
+		return;
+	}
+
+	if (m_log_setup_pending) {
+		write_debug_output("MetaWearBluetoothClient - the onboard logging setup of the previous acquisition is still pending");
+		return;
+	}
+
 	if (m_device_connected && !m_device_streaming && m_output_file_loaded) {
 
 		// opening the output files
 		set_output_file(m_output_folder_path);
-		m_output_ori_file.open(m_output_ori_file_str, std::fstream::app);
+		if (!m_raw_mode) m_output_ori_file.open(m_output_ori_file_str, std::fstream::app);
 		m_output_acc_file.open(m_output_acc_file_str, std::fstream::app);
+		if (m_raw_mode) m_output_gyro_file.open(m_output_gyro_file_str, std::fstream::app);
 		
 		// connecting to redis (if redis enabled)
 		if (m_redis_state) {
@@ -187,70 +280,16 @@ void MetaWearBluetoothClient::start_stream() {
 			m_redis_rate_div = std::atoi((*m_config_ptr)["ext_imu_redis_rate_div"].c_str());
 			connect_to_redis({m_redis_entry});
 		}
-		
-		MblMwFnData euler_angles_callback = [](void* context, const MblMwData* data) {
-
-			MblMwEulerAngles* euler_angles = (MblMwEulerAngles*)data->value;
-			MetaWearBluetoothClient* client_p = static_cast<MetaWearBluetoothClient*>(context);
-
-			// only writting data to file in normal mode
-			if (!client_p->get_stream_preview_status()) {
-			
-				// getting timestamps strings
-				std::string reception_time_os = client_p->get_micro_timestamp();
-				std::string data_time = std::to_string(data->epoch);
 
-				// defining the output string
-				std::string output_str = reception_time_os + "," + data_time + "," + std::to_string(euler_angles->heading) + ","
-					+ std::to_string(euler_angles->pitch) + "," + std::to_string(euler_angles->roll) + "," + std::to_string(euler_angles->yaw)
-					+ "\n";
-
-				client_p->write_str_to_redis(client_p->m_redis_entry, output_str);
-
-				// writing to output file after passthrough mode check
-				if (!client_p->get_pass_through()) {
-					client_p->m_output_ori_file << output_str;
-				}
-				
-			}
+		m_acc_clock = PackedSampleClock();
+		m_gyro_clock = PackedSampleClock();
 
-		};
+		// subscribing to the data signals of the selected mode
+		if (m_log_mode) start_log_stream();
+		else if (m_raw_mode) start_raw_stream();
+		else start_fusion_stream();
 
-		MblMwFnData acceleration_callback = [](void* context, const MblMwData* data) {
-
-			MblMwCartesianFloat* acceleration = (MblMwCartesianFloat*)data->value;
-			MetaWearBluetoothClient* client_p = static_cast<MetaWearBluetoothClient*>(context);
-
-			// only writtingdata to file in normal mode
-			if (!client_p->get_stream_preview_status() && !client_p->get_pass_through()) {
-			
-				// getting timestamps strings
-				std::string reception_time_os = client_p->get_micro_timestamp();
-				std::string data_time = std::to_string(data->epoch);
-
-				// defining the output string
-				std::string output_str = reception_time_os + "," + data_time + "," + std::to_string(acceleration->x) + ','
-					+ std::to_string(acceleration->y) + "," + std::to_string(acceleration->z) + "\n";
-
-				// writing to output file after passthrough mode check
-				client_p->m_output_acc_file << output_str;
-				
-			}
-
-		};
-		
-		// setting up the callback for euler angles data
-		auto euler_angles_sig = mbl_mw_sensor_fusion_get_data_signal(m_metawear_board_p, MBL_MW_SENSOR_FUSION_DATA_EULER_ANGLE);
-		mbl_mw_datasignal_subscribe(euler_angles_sig, this, euler_angles_callback);
-
-		// setting up the callback for cartesian acceleration
-		auto acceleration_sig = mbl_mw_sensor_fusion_get_data_signal(m_metawear_board_p, MBL_MW_SENSOR_FUSION_DATA_LINEAR_ACC);
-		mbl_mw_datasignal_subscribe(acceleration_sig, this, acceleration_callback);
-			
-		// enabling the relevant signals and starting the acquisition
-		mbl_mw_sensor_fusion_enable_data(m_metawear_board_p, MBL_MW_SENSOR_FUSION_DATA_EULER_ANGLE);
-		mbl_mw_sensor_fusion_enable_data(m_metawear_board_p, MBL_MW_SENSOR_FUSION_DATA_LINEAR_ACC);
-		mbl_mw_sensor_fusion_start(m_metawear_board_p);
+		m_stream_start_time = std::chrono::steady_clock::now();
 
 		m_device_streaming = true;
 	}
@@ -259,14 +298,38 @@ void MetaWearBluetoothClient::start_stream() {
 
 void MetaWearBluetoothClient::stop_stream(void){
 
+	if (!in_ble_thread()) {
+		run_in_ble_thread([this]() { stop_stream(); }, true);
+		return;
+	}
+
 	if (m_device_connected && m_device_streaming) {
 
 		// stoping stream from board
-		mbl_mw_sensor_fusion_stop(m_metawear_board_p);
+		if (m_log_mode) stop_log_stream();
+		else if (m_raw_mode) stop_raw_stream();
+		else mbl_mw_sensor_fusion_stop(m_metawear_board_p);
 
-		// closing the output files and redis connection
-		m_output_ori_file.close();
-		m_output_acc_file.close();
+		if (m_transport_p != nullptr) {
+			write_debug_output("MetaWearBluetoothClient - transport stats, " + QString(m_transport_p->get_stats().c_str()));
+		}
+
+		// reporting the achieved sample rates (raw mode)
+		double stream_duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_stream_start_time).count();
+		if (m_raw_mode && stream_duration > 0) {
+			write_debug_output("MetaWearBluetoothClient - raw stream achieved rates : accelerometer "
+				+ QString::number(m_acc_clock.n_samples / stream_duration, 'f', 1) + " Hz (odr " + QString::number(m_acc_odr) + " Hz), gyroscope "
+				+ QString::number(m_gyro_clock.n_samples / stream_duration, 'f', 1) + " Hz (odr " + QString::number(m_gyro_odr) + " Hz), samples per notification : "
+				+ QString::number((m_acc_clock.n_packets + m_gyro_clock.n_packets) > 0 ?
+					double(m_acc_clock.n_samples + m_gyro_clock.n_samples) / (m_acc_clock.n_packets + m_gyro_clock.n_packets) : 0, 'f', 2));
+		}
+
+		// closing the output files (once the log is downloaded in log mode) and redis connection
+		if (!m_log_downloading) {
+			m_output_ori_file.close();
+			m_output_acc_file.close();
+			m_output_gyro_file.close();
+		}
 		disconnect_from_redis();
 		
 		m_device_streaming = false;
@@ -276,26 +339,61 @@ void MetaWearBluetoothClient::stop_stream(void){
 
 void MetaWearBluetoothClient::set_output_file(const std::string& output_folder_path) {
 
+	if (!in_ble_thread()) {
+		run_in_ble_thread([this, output_folder_path]() { set_output_file(output_folder_path); }, true);
+		return;
+	}
+
+	// the downloading log is written to the current output files, the new ones are set once it is complete
+	if (m_log_downloading) {
+		m_deferred_output_folder_path = output_folder_path;
+		write_debug_output("MetaWearBluetoothClient - the output file will be set once the onboard log is downloaded");
+		return;
+	}
+
 	try {
 
 		m_output_folder_path = output_folder_path;
 
+		// getting the acquisition mode (sensor fusion or raw)
+		m_raw_mode = (*m_config_ptr)["ext_imu_raw_mode"] == "true";
+		m_log_mode = (*m_config_ptr)["ext_imu_log_mode"] == "true";
+		m_log_preview_period = std::atoi((*m_config_ptr)["ext_imu_log_preview_period"].c_str());
+		if (m_log_preview_period <= 0) m_log_preview_period = LOG_DEFAULT_PREVIEW_PERIOD;
+		try {
+			m_raw_rate = std::stof((*m_config_ptr)["ext_imu_raw_rate"]);
+			if (m_raw_rate <= 0) m_raw_rate = RAW_DEFAULT_RATE;
+		} catch (...) {
+			m_raw_rate = RAW_DEFAULT_RATE;
+		}
+
 		// defining the output and sync output file paths
 		m_output_ori_file_str = output_folder_path + "/ext_imu_orientation.csv";
 		m_output_acc_file_str = output_folder_path + "/ext_imu_acceleration.csv";
+		m_output_gyro_file_str = output_folder_path + "/ext_imu_gyroscope.csv";
 		if (m_output_ori_file.is_open()) m_output_ori_file.close();
 		if (m_output_acc_file.is_open()) m_output_acc_file.close();
+		if (m_output_gyro_file.is_open()) m_output_gyro_file.close();
 
-		// writing the orientation output file header
-		m_output_ori_file.open(m_output_ori_file_str);
-		m_output_ori_file << "Reception OS time,Onboard time,Heading,Pitch,Roll,Yaw" << std::endl;
-		m_output_ori_file.close();
+		// writing the orientation output file header (sensor fusion modes, the OS times of logged samples are estimated)
+		if (!m_raw_mode) {
+			m_output_ori_file.open(m_output_ori_file_str);
+			m_output_ori_file << "Reception OS time,Onboard time,Heading,Pitch,Roll,Yaw" << std::endl;
+			m_output_ori_file.close();
+		}
 
 		// writing the acceleration output file header
 		m_output_acc_file.open(m_output_acc_file_str);
 		m_output_acc_file << "Reception OS time,Onboard time,ACC X,ACC Y,ACC Z" << std::endl;
 		m_output_acc_file.close();
 
+		// writing the angular velocity output file header (raw mode)
+		if (m_raw_mode) {
+			m_output_gyro_file.open(m_output_gyro_file_str);
+			m_output_gyro_file << "Reception OS time,Onboard time,GYR X,GYR Y,GYR Z" << std::endl;
+			m_output_gyro_file.close();
+		}
+
 		m_output_file_loaded = true;
 
 	} catch (...) {
@@ -317,6 +415,8 @@ void MetaWearBluetoothClient::device_discovered(const QBluetoothDeviceInfo& devi
 	// only interested in the target device
 	if ((incoming_adress_str == target_device_adress) && !m_metawear_device_controller_p) {	
 		m_metawear_device_controller_p = std::shared_ptr<QLowEnergyController>(QLowEnergyController::createCentral(device));
+		m_cached_device_info = device;
+		m_device_cached = true;
 		write_debug_output("MetaWearBluetoothClient - device with address : " + incoming_adress_str + " discovered\n");
 	}
 
@@ -356,6 +456,7 @@ void MetaWearBluetoothClient::device_discovery_finished(void) {
 			static_cast<void (QLowEnergyController::*)(QLowEnergyController::Error)>(&QLowEnergyController::error),
 			[this](QLowEnergyController::Error error) {
 				write_debug_output("MetaWearBluetoothClient - BLE device communication level error occured, code : " + QString(error));
+				drop_cached_connection();
 			});
 
 		// connecting to the target device
@@ -382,6 +483,9 @@ void MetaWearBluetoothClient::device_disconnected(){
 		m_disconnect_handler(m_disconnect_event_caller, 0);
 	}
 
+	// a cached connection that drops is not reused, the next connection scans for the device
+	drop_cached_connection();
+
 	// moving to a disconnected device state
 	if (m_device_connected) {
 		disconnect_device();
@@ -394,6 +498,9 @@ void MetaWearBluetoothClient::device_disconnected(){
 
 void MetaWearBluetoothClient::service_discovered(const QBluetoothUuid& gatt_uuid){
 
+	// reconnections only explore the services used by the board during the previous connection
+	if (m_cached_connection && !m_used_service_uuids.contains(gatt_uuid)) return;
+
 	// creating the service object from the uuid + configuring if valid
 	QString service_uuid_str = gatt_uuid.toString();
 	QLowEnergyService* service_p = m_metawear_device_controller_p->createServiceObject(gatt_uuid, this);
@@ -454,43 +561,17 @@ void MetaWearBluetoothClient::service_discovery_finished() {
 				}
 			}
 			if (discovered_count == m_metawear_services_p.size()) break;
-			ms_wait_time += 500;
-			QThread::msleep(500);
+			ms_wait_time += DISCOVER_DETAILS_POLL;
+			QThread::msleep(DISCOVER_DETAILS_POLL);
 		}
 
-		// creating the object for interfacing with the metawear board
-		m_metawear_ble_interface = { this, write_gatt_char_wrap, read_gatt_char_wrap, enable_notifications_wrap, on_disconnect_wrap };
-		m_metawear_board_p = mbl_mw_metawearboard_create(&m_metawear_ble_interface);
-		mbl_mw_metawearboard_set_time_for_response(m_metawear_board_p, METAWEARTIMEOUT);
-
-		write_debug_output("MetaWearBluetoothClient - starting the MetaBoard initialization");
-
-		// initializing the board + defining the initialization callback (the initialization process uses the bluetooth interface)
-		mbl_mw_metawearboard_initialize(m_metawear_board_p, this, [](void* context, MblMwMetaWearBoard* board, int32_t status) -> void {
-
-			bool connection_status = (status == 0);
-			MetaWearBluetoothClient* bluetooth_client = (static_cast<MetaWearBluetoothClient*>(context));
-
-			// configuring the board on succes
-			if (connection_status) {
-				mbl_mw_sensor_fusion_set_mode(board, MBL_MW_SENSOR_FUSION_MODE_IMU_PLUS);
-				mbl_mw_sensor_fusion_set_acc_range(board, MBL_MW_SENSOR_FUSION_ACC_RANGE_8G);
-				mbl_mw_sensor_fusion_write_config(board);
-			}  else {
-				bluetooth_client->disconnect_device();
-				bluetooth_client->clear_metawear_connection();
-			}
-
-			// updating the connection status + notifying the main window
-			bluetooth_client->set_connection_status(connection_status);
-			emit bluetooth_client->device_status_change(bluetooth_client->get_device_id(), connection_status);
-
-			if (connection_status) bluetooth_client->write_debug_output("MetaWearBluetoothClient - MetaBoard initialization succeded");
-			else bluetooth_client->write_debug_output("MetaWearBluetoothClient - MetaBoard initialization failed");
+		// the characteristics are resolved once, before the board starts issuing gatt requests
+		build_characteristic_table();
 
-		});
+		initialize_board();
 
 	} else {
+		if (m_cached_connection) clear_connection_cache();
 		disconnect_device();
 		clear_metawear_connection();
 		write_debug_output("MetaWearBluetoothClient - service discovery completed with no services found");
@@ -527,20 +608,15 @@ void MetaWearBluetoothClient::service_characteristic_read(const QLowEnergyCharac
 void MetaWearBluetoothClient::service_characteristic_changed(const QLowEnergyCharacteristic& characteristic, const QByteArray& newValue) {
 
 	// checking if the changed characteristic is registered to a call back
-	auto callback_map_entry = m_char_update_callback_map.find(characteristic.uuid().toString());
-	if (callback_map_entry != m_char_update_callback_map.end()) {
+	const std::tuple<const void*, MblMwFnIntVoidPtrArray>* callback_entry = m_char_update_callback_table.find(qt_uuid_to_key(characteristic.uuid()));
+
+	if (callback_entry != nullptr) {
 	
-		// converting the service characteristic to metawear format
-		const char* byte_array_data = newValue.data();
-		uint8_t* converted_data = new uint8_t[newValue.length()];
-		for (auto i = 0; i < newValue.length(); i++)
-			converted_data[i] = (uint8_t) byte_array_data[i];
-		
-		// calling the proper call back (specified in the map)
+		// calling the proper call back (specified in the table), with the packet data
 		try {
-			std::get<1>(callback_map_entry->second)(
-				std::get<0>(callback_map_entry->second),
-				converted_data,
+			std::get<1>(*callback_entry)(
+				std::get<0>(*callback_entry),
+				reinterpret_cast<const uint8_t*>(newValue.constData()),
 				newValue.length()
 			);
 		} catch (...) {}
@@ -555,15 +631,21 @@ void MetaWearBluetoothClient::service_characteristic_changed(const QLowEnergyCha
 
 void MetaWearBluetoothClient::clear_metawear_connection() {
 
+	// disconnecting the transport first (its queued handlers are discarded)
+	if (m_transport_p != nullptr) m_transport_p->disconnect_transport();
+
 	// clearing qt communication vars
+	// (the controller signals are disconnected first, requested disconnections are not handled as connection drops)
 	if (m_metawear_device_controller_p != nullptr) {
+		m_metawear_device_controller_p->disconnect();
 		m_metawear_device_controller_p->disconnectFromDevice();
+		m_characteristic_table.clear();
 		m_metawear_services_p.clear();
 		m_metawear_device_controller_p.reset();
 	}
 
 	// clearing callback structures / vars
-	m_char_update_callback_map.clear();
+	m_char_update_callback_table.clear();
 	bytes_callback_queue empty_queue;
 	std::swap(m_char_read_callback_queue, empty_queue);
 	m_disconnect_event_caller = nullptr;
@@ -578,36 +660,617 @@ void MetaWearBluetoothClient::clear_metawear_connection() {
 
 }
 
- QLowEnergyCharacteristic MetaWearBluetoothClient::find_characteristic(const MblMwGattChar* characteristic_struct, int& service_index, const QString& debug_str) {
+void MetaWearBluetoothClient::start_fusion_stream(void) {
 
-	// getting the uuid object for the target characteristic and the target service
-	QBluetoothUuid target_characteristic_uuid = metawear_uuid_to_qt_uuid(characteristic_struct->uuid_low, characteristic_struct->uuid_high);
-	QBluetoothUuid target_service_uuid = metawear_uuid_to_qt_uuid(characteristic_struct->service_uuid_low, characteristic_struct->service_uuid_high);
+	MblMwFnData euler_angles_callback = [](void* context, const MblMwData* data) {
 
-	// looking through the services for the specified characteristic
-	service_index = -1;
-	QLowEnergyCharacteristic characteristic;
-	for (auto i = 0; i < m_metawear_services_p.size(); i++) {
+		MblMwEulerAngles* euler_angles = (MblMwEulerAngles*)data->value;
+		MetaWearBluetoothClient* client_p = static_cast<MetaWearBluetoothClient*>(context);
+
+		// only writting data to file in normal mode
+		if (!client_p->get_stream_preview_status()) {
+		
+			// getting timestamps strings
+			std::string reception_time_os = client_p->get_micro_timestamp();
+			std::string data_time = std::to_string(data->epoch);
+
+			// defining the output string
+			std::string output_str = reception_time_os + "," + data_time + "," + std::to_string(euler_angles->heading) + ","
+				+ std::to_string(euler_angles->pitch) + "," + std::to_string(euler_angles->roll) + "," + std::to_string(euler_angles->yaw)
+				+ "\n";
+
+			client_p->write_str_to_redis(client_p->m_redis_entry, output_str);
+
+			// writing to output file after passthrough mode check
+			if (!client_p->get_pass_through()) {
+				client_p->m_output_ori_file << output_str;
+			}
+			
+		}
+
+	};
+
+	MblMwFnData acceleration_callback = [](void* context, const MblMwData* data) {
+
+		MblMwCartesianFloat* acceleration = (MblMwCartesianFloat*)data->value;
+		MetaWearBluetoothClient* client_p = static_cast<MetaWearBluetoothClient*>(context);
+
+		// only writtingdata to file in normal mode
+		if (!client_p->get_stream_preview_status() && !client_p->get_pass_through()) {
 		
-		characteristic = m_metawear_services_p[i]->characteristic(target_characteristic_uuid);
+			// getting timestamps strings
+			std::string reception_time_os = client_p->get_micro_timestamp();
+			std::string data_time = std::to_string(data->epoch);
+
+			// defining the output string
+			std::string output_str = reception_time_os + "," + data_time + "," + std::to_string(acceleration->x) + ','
+				+ std::to_string(acceleration->y) + "," + std::to_string(acceleration->z) + "\n";
+
+			// writing to output file after passthrough mode check
+			client_p->m_output_acc_file << output_str;
+			
+		}
+
+	};
+	
+	// setting up the callback for euler angles data
+	auto euler_angles_sig = mbl_mw_sensor_fusion_get_data_signal(m_metawear_board_p, MBL_MW_SENSOR_FUSION_DATA_EULER_ANGLE);
+	mbl_mw_datasignal_subscribe(euler_angles_sig, this, euler_angles_callback);
+
+	// setting up the callback for cartesian acceleration
+	auto acceleration_sig = mbl_mw_sensor_fusion_get_data_signal(m_metawear_board_p, MBL_MW_SENSOR_FUSION_DATA_LINEAR_ACC);
+	mbl_mw_datasignal_subscribe(acceleration_sig, this, acceleration_callback);
 		
-		if (characteristic.isValid()) {
-			service_index = i;
-			break;
+	// enabling the relevant signals and starting the acquisition
+	mbl_mw_sensor_fusion_enable_data(m_metawear_board_p, MBL_MW_SENSOR_FUSION_DATA_EULER_ANGLE);
+	mbl_mw_sensor_fusion_enable_data(m_metawear_board_p, MBL_MW_SENSOR_FUSION_DATA_LINEAR_ACC);
+	mbl_mw_sensor_fusion_start(m_metawear_board_p);
+
+}
+
+void MetaWearBluetoothClient::start_raw_stream(void) {
+
+	MblMwFnData acceleration_callback = [](void* context, const MblMwData* data) {
+
+		MblMwCartesianFloat* acceleration = (MblMwCartesianFloat*)data->value;
+		MetaWearBluetoothClient* client_p = static_cast<MetaWearBluetoothClient*>(context);
+		double sample_time = client_p->get_sample_time(client_p->m_acc_clock, data->epoch);
+
+		// only writting data to file in normal mode
+		if (!client_p->get_stream_preview_status()) {
+
+			// defining the output string
+			std::string output_str = client_p->get_micro_timestamp() + "," + std::to_string(sample_time) + "," + std::to_string(acceleration->x) + ","
+				+ std::to_string(acceleration->y) + "," + std::to_string(acceleration->z) + "\n";
+
+			client_p->write_str_to_redis(client_p->m_redis_entry, output_str);
+
+			// writing to output file after passthrough mode check
+			if (!client_p->get_pass_through()) {
+				client_p->m_output_acc_file << output_str;
+			}
+
 		}
+
+	};
+
+	MblMwFnData rotation_callback = [](void* context, const MblMwData* data) {
+
+		MblMwCartesianFloat* rotation = (MblMwCartesianFloat*)data->value;
+		MetaWearBluetoothClient* client_p = static_cast<MetaWearBluetoothClient*>(context);
+		double sample_time = client_p->get_sample_time(client_p->m_gyro_clock, data->epoch);
+
+		// only writting data to file in normal mode
+		if (!client_p->get_stream_preview_status() && !client_p->get_pass_through()) {
+
+			// defining the output string
+			std::string output_str = client_p->get_micro_timestamp() + "," + std::to_string(sample_time) + "," + std::to_string(rotation->x) + ","
+				+ std::to_string(rotation->y) + "," + std::to_string(rotation->z) + "\n";
+
+			client_p->m_output_gyro_file << output_str;
+
+		}
+
+	};
+
+	configure_raw_sensors();
+	m_acc_clock.sample_period = 1000.0 / m_acc_odr;
+	m_gyro_clock.sample_period = 1000.0 / m_gyro_odr;
+
+	// setting up the callbacks for the packed signals (RAW_SAMPLES_PER_PACKET samples per notification)
+	auto acceleration_sig = mbl_mw_acc_get_packed_acceleration_data_signal(m_metawear_board_p);
+	mbl_mw_datasignal_subscribe(acceleration_sig, this, acceleration_callback);
+	auto rotation_sig = mbl_mw_gyro_bmi160_get_packed_rotation_data_signal(m_metawear_board_p);
+	mbl_mw_datasignal_subscribe(rotation_sig, this, rotation_callback);
+
+	start_raw_sensors();
+
+	write_debug_output("MetaWearBluetoothClient - raw stream started (packed), accelerometer at " + QString::number(m_acc_odr) + " Hz, gyroscope at "
+		+ QString::number(m_gyro_odr) + " Hz");
+
+}
+
+void MetaWearBluetoothClient::stop_raw_stream(void) {
+
+	stop_raw_sensors();
+
+	// removing the subscriptions (the signals would keep the callbacks otherwise)
+	mbl_mw_datasignal_unsubscribe(mbl_mw_acc_get_packed_acceleration_data_signal(m_metawear_board_p));
+	mbl_mw_datasignal_unsubscribe(mbl_mw_gyro_bmi160_get_packed_rotation_data_signal(m_metawear_board_p));
+
+}
+
+void MetaWearBluetoothClient::configure_raw_sensors(void) {
+
+	// configuring the accelerometer (closest supported output data rate)
+	int acc_odr_index = 0;
+	while (acc_odr_index < ACC_N_ODRS - 1 && ACC_MIN_ODR * (1 << acc_odr_index) * 1.5f <= m_raw_rate) acc_odr_index++;
+	m_acc_odr = ACC_MIN_ODR * (1 << acc_odr_index);
+	mbl_mw_acc_set_odr(m_metawear_board_p, m_acc_odr);
+	mbl_mw_acc_set_range(m_metawear_board_p, RAW_ACC_RANGE);
+	mbl_mw_acc_write_acceleration_config(m_metawear_board_p);
+
+	// configuring the gyroscope (closest supported output data rate)
+	int gyro_odr_index = 0;
+	while (gyro_odr_index < GYRO_N_ODRS - 1 && GYRO_MIN_ODR * (1 << gyro_odr_index) * 1.5f <= m_raw_rate) gyro_odr_index++;
+	m_gyro_odr = GYRO_MIN_ODR * (1 << gyro_odr_index);
+	mbl_mw_gyro_bmi160_set_odr(m_metawear_board_p, static_cast<MblMwGyroBmi160Odr>(MBL_MW_GYRO_BMI160_ODR_25Hz + gyro_odr_index));
+	mbl_mw_gyro_bmi160_set_range(m_metawear_board_p, MBL_MW_GYRO_BMI160_RANGE_2000dps);
+	mbl_mw_gyro_bmi160_write_config(m_metawear_board_p);
+
+}
+
+void MetaWearBluetoothClient::start_raw_sensors(void) {
+	mbl_mw_acc_enable_acceleration_sampling(m_metawear_board_p);
+	mbl_mw_gyro_bmi160_enable_rotation_sampling(m_metawear_board_p);
+	mbl_mw_acc_start(m_metawear_board_p);
+	mbl_mw_gyro_bmi160_start(m_metawear_board_p);
+}
+
+void MetaWearBluetoothClient::stop_raw_sensors(void) {
+	mbl_mw_acc_stop(m_metawear_board_p);
+	mbl_mw_gyro_bmi160_stop(m_metawear_board_p);
+	mbl_mw_acc_disable_acceleration_sampling(m_metawear_board_p);
+	mbl_mw_gyro_bmi160_disable_rotation_sampling(m_metawear_board_p);
+}
+
+/*******************************************************************************
+* ONBOARD LOGGING
+******************************************************************************/
+
+void MetaWearBluetoothClient::start_log_stream(void) {
+
+	// defining the logged signals (full rate), the first one is also streamed as the live preview
+	m_logged_signals.clear();
+	if (m_raw_mode) {
+		configure_raw_sensors();
+		m_logged_signals.push_back({this, mbl_mw_acc_get_acceleration_data_signal(m_metawear_board_p), nullptr, &m_output_acc_file, false,
+			"accelerometer", 1000.0 / m_acc_odr});
+		m_logged_signals.push_back({this, mbl_mw_gyro_bmi160_get_rotation_data_signal(m_metawear_board_p), nullptr, &m_output_gyro_file, false,
+			"gyroscope", 1000.0 / m_gyro_odr});
+	} else {
+		m_logged_signals.push_back({this, mbl_mw_sensor_fusion_get_data_signal(m_metawear_board_p, MBL_MW_SENSOR_FUSION_DATA_EULER_ANGLE),
+			nullptr, &m_output_ori_file, true, "euler angles", 1000.0 / FUSION_RATE});
+		m_logged_signals.push_back({this, mbl_mw_sensor_fusion_get_data_signal(m_metawear_board_p, MBL_MW_SENSOR_FUSION_DATA_LINEAR_ACC),
+			nullptr, &m_output_acc_file, false, "linear acceleration", 1000.0 / FUSION_RATE});
 	}
 
-	// debug information about requested service and characteristic
-	write_debug_output("........................... find_characteristic call (begin)");
-	write_debug_output("target service uuid : " + target_service_uuid.toString());
-	if (characteristic.isValid()) write_debug_output("target service name : " + m_metawear_services_p[service_index]->serviceName());
-	write_debug_output("target characteristic uuid : " + target_characteristic_uuid.toString());
-	if (characteristic.isValid()) write_debug_output("target characteristic name : " + characteristic.name());
-	write_debug_output("requests in the callback queue : " + QString(int(m_char_read_callback_queue.size())));
-	write_debug_output("debug string : " + debug_str);
-	write_debug_output("........................... find_characteristic call (end)");
+	m_log_epoch_offset = std::numeric_limits<long long>::max();
+	m_n_log_setup_steps = 0;
+	m_log_started = false;
+
+	// the loggers and the preview processor are created one after the other (asynchronous board commands)
+	setup_next_log_step();
+
+}
+
+void MetaWearBluetoothClient::setup_next_log_step(void) {
+
+	// creating the next logger
+	if (m_n_log_setup_steps < m_logged_signals.size()) {
+
+		m_log_setup_pending = true;
+		mbl_mw_datasignal_log(m_logged_signals[m_n_log_setup_steps].signal, this, [](void* context, MblMwDataLogger* logger) -> void {
+
+			MetaWearBluetoothClient* client_p = static_cast<MetaWearBluetoothClient*>(context);
+			if (!client_p->m_log_setup_pending) {
+				if (logger != nullptr) mbl_mw_logger_remove(logger);
+				return;
+			}
+
+			LoggedSignal& logged_signal = client_p->m_logged_signals[client_p->m_n_log_setup_steps];
+			logged_signal.logger = logger;
+			if (!client_p->end_log_setup_step(logger != nullptr)) return;
+
+			mbl_mw_logger_subscribe(logger, &logged_signal, log_data_callback);
+
+			client_p->m_n_log_setup_steps++;
+			client_p->setup_next_log_step();
+
+		});
+
+	}
+
+	// creating the preview processor (1 sample per preview period)
+	else if (m_n_log_setup_steps == m_logged_signals.size()) {
+
+		m_log_setup_pending = true;
+		mbl_mw_dataprocessor_time_create(m_logged_signals[0].signal, MBL_MW_TIME_ABSOLUTE, m_log_preview_period, this,
+			[](void* context, MblMwDataProcessor* processor) -> void {
+
+			MetaWearBluetoothClient* client_p = static_cast<MetaWearBluetoothClient*>(context);
+			if (!client_p->m_log_setup_pending) {
+				if (processor != nullptr) mbl_mw_dataprocessor_remove(processor);
+				return;
+			}
+
+			client_p->m_preview_processor = processor;
+			if (!client_p->end_log_setup_step(processor != nullptr)) return;
+
+			mbl_mw_datasignal_subscribe(reinterpret_cast<MblMwDataSignal*>(processor), &client_p->m_logged_signals[0], preview_data_callback);
+
+			client_p->m_n_log_setup_steps++;
+			client_p->setup_next_log_step();
+
+		});
+
+	}
+
+	// starting the logger, then the sensors
+	else {
+
+		mbl_mw_logging_start(m_metawear_board_p, 0);
+		if (m_raw_mode) {
+			start_raw_sensors();
+		} else {
+			mbl_mw_sensor_fusion_enable_data(m_metawear_board_p, MBL_MW_SENSOR_FUSION_DATA_EULER_ANGLE);
+			mbl_mw_sensor_fusion_enable_data(m_metawear_board_p, MBL_MW_SENSOR_FUSION_DATA_LINEAR_ACC);
+			mbl_mw_sensor_fusion_start(m_metawear_board_p);
+		}
+
+		m_log_started = true;
+		write_debug_output("MetaWearBluetoothClient - onboard logging started, live preview period : " + QString::number(m_log_preview_period) + " ms");
+
+	}
+
+}
+
+bool MetaWearBluetoothClient::end_log_setup_step(bool created) {
+
+	m_log_setup_pending = false;
+
+	// the stream was stopped during the step, the logged signals were kept until now
+	if (m_log_setup_cancelled) {
+		m_log_setup_cancelled = false;
+		finish_log_download(true);
+		return false;
+	}
+
+	if (!created) {
+		if (m_n_log_setup_steps < m_logged_signals.size()) {
+			write_debug_output("MetaWearBluetoothClient - failed to create the onboard logger for : " + QString(m_logged_signals[m_n_log_setup_steps].name.c_str()));
+		} else {
+			write_debug_output("MetaWearBluetoothClient - failed to create the preview processor");
+		}
+		fail_log_stream();
+		return false;
+	}
+
+	return true;
+
+}
+
+void MetaWearBluetoothClient::fail_log_stream(void) {
+
+	// releasing the loggers created so far (the sensors and the logger were not started)
+	finish_log_download(true);
+	disconnect_from_redis();
+	m_device_streaming = false;
+
+	disconnect_device();
+
+}
+
+void MetaWearBluetoothClient::stop_log_stream(void) {
+
+	// stopping the sensors, then the logger
+	if (m_raw_mode) stop_raw_sensors();
+	else mbl_mw_sensor_fusion_stop(m_metawear_board_p);
+	mbl_mw_logging_stop(m_metawear_board_p);
+
+	if (!m_log_started) {
+		write_debug_output("MetaWearBluetoothClient - the stream was stopped before the onboard logging started");
+		// the pending setup step still references the logged signals, its callback does the cleanup
+		if (m_log_setup_pending) m_log_setup_cancelled = true;
+		else finish_log_download(true);
+		return;
+	}
+
+	// downloading the log (the samples are written by the logger callbacks)
+	m_log_downloading = true;
+	m_log_download_handler = { this,
+		[](void* context, uint32_t entries_left, uint32_t total_entries) -> void {
+			MetaWearBluetoothClient* client_p = static_cast<MetaWearBluetoothClient*>(context);
+			emit client_p->log_download_progress(total_entries - entries_left, total_entries);
+			if (entries_left == 0) client_p->finish_log_download(true);
+		},
+		[](void* context, uint8_t id, int64_t epoch, const uint8_t* data, uint8_t length) -> void {
+			static_cast<MetaWearBluetoothClient*>(context)->m_n_unknown_log_entries++;
+		},
+		[](void* context, const MblMwData* data) -> void {
+			static_cast<MetaWearBluetoothClient*>(context)->m_n_unknown_log_entries++;
+		}
+	};
+	m_n_unknown_log_entries = 0;
+	m_log_download_start_time = std::chrono::steady_clock::now();
+	mbl_mw_logging_download(m_metawear_board_p, LOG_DOWNLOAD_N_NOTIFIES, &m_log_download_handler);
+
+	write_debug_output("MetaWearBluetoothClient - onboard log download started");
+
+}
+
+void MetaWearBluetoothClient::finish_log_download(bool board_available) {
+
+	// reporting the downloaded samples and the gaps in their onboard timestamps
+	if (m_log_downloading) {
+		double download_duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_log_download_start_time).count();
+		for (const auto& logged_signal : m_logged_signals) {
+			write_debug_output("MetaWearBluetoothClient - downloaded " + QString(logged_signal.name.c_str()) + " samples : "
+				+ QString::number(logged_signal.n_samples) + ", timestamp gaps : " + QString::number(logged_signal.n_gaps));
+		}
+		write_debug_output("MetaWearBluetoothClient - onboard log downloaded in " + QString::number(download_duration, 'f', 1) + " s, unknown entries : "
+			+ QString::number(m_n_unknown_log_entries));
+	}
+
+	// removing the loggers and the preview processor, then clearing the board log
+	if (board_available) {
+		for (auto& logged_signal : m_logged_signals) {
+			if (logged_signal.logger != nullptr) mbl_mw_logger_remove(logged_signal.logger);
+		}
+		if (m_preview_processor != nullptr) mbl_mw_dataprocessor_remove(m_preview_processor);
+		mbl_mw_logging_clear_entries(m_metawear_board_p);
+	}
+	m_preview_processor = nullptr;
+	m_logged_signals.clear();
+
+	m_output_ori_file.close();
+	m_output_acc_file.close();
+	m_output_gyro_file.close();
+
+	// setting the output file requested during the download
+	if (m_log_downloading) {
+		m_log_downloading = false;
+		if (!m_deferred_output_folder_path.empty()) {
+			set_output_file(m_deferred_output_folder_path);
+			m_deferred_output_folder_path.clear();
+		}
+	}
+
+}
+
+void MetaWearBluetoothClient::log_data_callback(void* context, const MblMwData* data) {
+
+	LoggedSignal* logged_signal = static_cast<LoggedSignal*>(context);
+	MetaWearBluetoothClient* client_p = logged_signal->client_p;
+
+	// counting the gaps in the onboard timestamps (more than 1.5 sample period)
+	if (logged_signal->last_epoch >= 0 && data->epoch - logged_signal->last_epoch > 1.5 * logged_signal->sample_period) logged_signal->n_gaps++;
+	logged_signal->last_epoch = data->epoch;
+	logged_signal->n_samples++;
+
+	// the reception OS time of logged samples is estimated from the onboard time (offset measured with the live preview)
+	long long os_time = (client_p->m_log_epoch_offset == std::numeric_limits<long long>::max()) ? 0 :
+		data->epoch * 1000 + client_p->m_log_epoch_offset;
+
+	*(logged_signal->file_p) << format_sample(std::to_string(os_time), data, logged_signal->euler_angles);
+
+}
+
+void MetaWearBluetoothClient::preview_data_callback(void* context, const MblMwData* data) {
+
+	LoggedSignal* logged_signal = static_cast<LoggedSignal*>(context);
+	MetaWearBluetoothClient* client_p = logged_signal->client_p;
+
+	// the smallest (reception - onboard) difference is the best estimate of the clock offset (lowest latency)
+	long long reception_time = SensorDevice::get_micro_timestamp_count();
+	client_p->m_log_epoch_offset = std::min(client_p->m_log_epoch_offset, reception_time - data->epoch * 1000);
+
+	if (!client_p->get_stream_preview_status()) {
+		client_p->write_str_to_redis(client_p->m_redis_entry, format_sample(std::to_string(reception_time), data, logged_signal->euler_angles));
+	}
+
+}
+
+std::string MetaWearBluetoothClient::format_sample(const std::string& os_time, const MblMwData* data, bool euler_angles) {
+
+	if (euler_angles) {
+		MblMwEulerAngles* angles = (MblMwEulerAngles*)data->value;
+		return os_time + "," + std::to_string(data->epoch) + "," + std::to_string(angles->heading) + "," + std::to_string(angles->pitch) + ","
+			+ std::to_string(angles->roll) + "," + std::to_string(angles->yaw) + "\n";
+	}
+
+	MblMwCartesianFloat* values = (MblMwCartesianFloat*)data->value;
+	return os_time + "," + std::to_string(data->epoch) + "," + std::to_string(values->x) + "," + std::to_string(values->y) + ","
+		+ std::to_string(values->z) + "\n";
+
+}
+
+double MetaWearBluetoothClient::get_sample_time(PackedSampleClock& clock, int64_t epoch) {
+
+	// samples unpacked from the same notification share its epoch (reception time of the notification, i.e. of its last sample)
+	if (epoch == clock.last_epoch) {
+		clock.packet_index++;
+	} else {
+		clock.packet_index = 0;
+		clock.n_packets++;
+	}
+	clock.last_epoch = epoch;
+	clock.n_samples++;
+
+	return static_cast<double>(epoch) - (RAW_SAMPLES_PER_PACKET - 1 - clock.packet_index) * clock.sample_period;
+
+}
+
+void MetaWearBluetoothClient::initialize_board(void) {
+
+	// creating the object for interfacing with the metawear board
+	m_metawear_ble_interface = { this, write_gatt_char_wrap, read_gatt_char_wrap, enable_notifications_wrap, on_disconnect_wrap };
+	m_metawear_board_p = mbl_mw_metawearboard_create(&m_metawear_ble_interface);
+	mbl_mw_metawearboard_set_time_for_response(m_metawear_board_p, METAWEARTIMEOUT);
+
+	// restoring the cached board state (the initialization then skips the module discovery)
+	if (m_cached_connection && !m_cached_board_state.empty()) {
+		mbl_mw_metawearboard_deserialize(m_metawear_board_p, m_cached_board_state.data(), static_cast<uint32_t>(m_cached_board_state.size()));
+	}
+
+	write_debug_output("MetaWearBluetoothClient - starting the MetaBoard initialization");
+
+	// initializing the board + defining the initialization callback (the initialization process uses the bluetooth interface)
+	mbl_mw_metawearboard_initialize(m_metawear_board_p, this, [](void* context, MblMwMetaWearBoard* board, int32_t status) -> void {
+
+		bool connection_status = (status == 0);
+		MetaWearBluetoothClient* bluetooth_client = (static_cast<MetaWearBluetoothClient*>(context));
+
+		// configuring the board on succes
+		if (connection_status) {
+			mbl_mw_sensor_fusion_set_mode(board, MBL_MW_SENSOR_FUSION_MODE_IMU_PLUS);
+			mbl_mw_sensor_fusion_set_acc_range(board, MBL_MW_SENSOR_FUSION_ACC_RANGE_8G);
+			mbl_mw_sensor_fusion_write_config(board);
+			bluetooth_client->cache_board_state();
+		}  else {
+			bluetooth_client->disconnect_device();
+			bluetooth_client->clear_metawear_connection();
+		}
+
+		// reporting the connection latency
+		double connect_duration = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - bluetooth_client->m_connect_start_time).count();
+		bluetooth_client->write_debug_output("MetaWearBluetoothClient - " + QString(bluetooth_client->m_cached_connection ? "cached reconnection" : "full connection")
+			+ " completed in " + QString::number(connect_duration, 'f', 0) + " ms");
+
+		// a failed cached reconnection falls back to a full connection (scan + discovery)
+		if (!connection_status && bluetooth_client->m_cached_connection) {
+			bluetooth_client->write_debug_output("MetaWearBluetoothClient - cached reconnection failed, falling back to a full connection");
+			bluetooth_client->clear_connection_cache();
+			bluetooth_client->connect_device();
+			return;
+		}
+
+		// updating the connection status + notifying the main window
+		bluetooth_client->set_connection_status(connection_status);
+		emit bluetooth_client->device_status_change(bluetooth_client->get_device_id(), connection_status);
+
+		if (connection_status) bluetooth_client->write_debug_output("MetaWearBluetoothClient - MetaBoard initialization succeded");
+		else bluetooth_client->write_debug_output("MetaWearBluetoothClient - MetaBoard initialization failed");
+
+	});
+
+}
+
+void MetaWearBluetoothClient::connect_transport(const std::string& transport_url) {
+
+	// creating the transport (a new url resets the connection cache)
+	if (m_transport_p == nullptr || transport_url != m_transport_url) {
+		
+		clear_connection_cache();
+		m_transport_p.reset();
+		m_transport_url = transport_url;
+
+		if (MetaMotionCSimulator::is_simulator_url(transport_url)) {
+			m_transport_p = std::make_shared<MetaMotionCSimulator>(transport_url);
+		} else {
+			emit device_status_change(m_device_id, false);
+			write_debug_output("MetaWearBluetoothClient - unknown transport url : " + QString(transport_url.c_str()));
+			return;
+		}
+
+		// the transport handlers run in the BLE thread (with the MetaWear SDK)
+		m_transport_p->set_dispatcher([this](std::function<void(void)> function) { run_in_ble_thread(function, false); });
+
+	}
+
+	m_cached_connection = !m_cached_board_state.empty();
+	write_debug_output("MetaWearBluetoothClient - connecting through the transport : " + QString(transport_url.c_str()));
+
+	m_transport_p->connect_transport([this](bool connection_status) {
+		if (connection_status) {
+			initialize_board();
+		} else {
+			emit device_status_change(m_device_id, false);
+			write_debug_output("MetaWearBluetoothClient - transport connection failed");
+		}
+	});
+
+}
+
+void MetaWearBluetoothClient::cache_board_state(void) {
+
+	uint32_t state_size = 0;
+	uint8_t* state = mbl_mw_metawearboard_serialize(m_metawear_board_p, &state_size);
+	if (state != nullptr) {
+		m_cached_board_state.assign(state, state + state_size);
+		mbl_mw_memory_free(state);
+	}
+
+}
+
+void MetaWearBluetoothClient::clear_connection_cache(void) {
+	m_device_cached = false;
+	m_cached_connection = false;
+	m_cached_board_state.clear();
+	m_used_service_uuids.clear();
+}
+
+void MetaWearBluetoothClient::drop_cached_connection(void) {
+
+	if (!m_cached_connection) return;
+	clear_connection_cache();
+
+	if (!m_device_connected) {
+		write_debug_output("MetaWearBluetoothClient - cached reconnection failed, falling back to a full connection");
+		run_in_ble_thread([this]() { connect_device(); }, false);
+	}
+
+}
+
+void MetaWearBluetoothClient::run_in_ble_thread(const std::function<void(void)>& function, bool blocking) {
+	QMetaObject::invokeMethod(this, function, blocking ? Qt::BlockingQueuedConnection : Qt::QueuedConnection);
+}
+
+bool MetaWearBluetoothClient::in_ble_thread(void) const {
+	return QThread::currentThread() == &m_ble_thread;
+}
+
+void MetaWearBluetoothClient::build_characteristic_table(void) {
+
+	m_characteristic_table.clear();
+
+	for (int i = 0; i < m_metawear_services_p.size(); i++) {
+		Uuid128 service_uuid = qt_uuid_to_key(m_metawear_services_p[i]->serviceUuid());
+		for (const QLowEnergyCharacteristic& characteristic : m_metawear_services_p[i]->characteristics()) {
+			m_characteristic_table.insert(qt_uuid_to_key(characteristic.uuid()), GattCharEntry{service_uuid, i, characteristic});
+		}
+	}
+
+	write_debug_output("MetaWearBluetoothClient - characteristic lookup table built, entries : " + QString::number(m_characteristic_table.size()));
+
+}
+
+QLowEnergyCharacteristic MetaWearBluetoothClient::find_characteristic(const MblMwGattChar* characteristic_struct, int& service_index, const QString& debug_str) {
+
+	const GattCharEntry* table_entry = m_characteristic_table.find(metawear_uuid_to_key(characteristic_struct->uuid_low, characteristic_struct->uuid_high));
+	if (table_entry != nullptr && table_entry->service_uuid == metawear_uuid_to_key(characteristic_struct->service_uuid_low, characteristic_struct->service_uuid_high)) {
+		service_index = table_entry->service_index;
+		m_used_service_uuids.insert(m_metawear_services_p[service_index]->serviceUuid());
+		return table_entry->characteristic;
+	}
+
+	// debug information about the missing service and characteristic
+	service_index = -1;
+	write_debug_output("MetaWearBluetoothClient - " + debug_str + " : unknown characteristic, service uuid : " + 
+		metawear_uuid_to_qt_uuid(characteristic_struct->service_uuid_low, characteristic_struct->service_uuid_high).toString() +
+		", characteristic uuid : " + metawear_uuid_to_qt_uuid(characteristic_struct->uuid_low, characteristic_struct->uuid_high).toString());
 
-	return characteristic;
+	return QLowEnergyCharacteristic();
 
 }
 
@@ -625,4 +1288,17 @@ void MetaWearBluetoothClient::clear_metawear_connection() {
 	 // returning the coresponding UUID
 	 return QBluetoothUuid(converted_uuid);
  
+ }
+
+ Uuid128 MetaWearBluetoothClient::qt_uuid_to_key(const QBluetoothUuid& uuid) {
+	 quint128 uuid_bytes = uuid.toUInt128();
+	 return Uuid128::from_bytes(uuid_bytes.data);
+ }
+
+ Uuid128 MetaWearBluetoothClient::metawear_uuid_to_key(const uint64_t uuid_low, const uint64_t uuid_high) {
+	 // the high word holds the first 8 bytes of the uuid (same key as the quint128 of metawear_uuid_to_qt_uuid)
+	 Uuid128 uuid;
+	 uuid.high = uuid_high;
+	 uuid.low = uuid_low;
+	 return uuid;
  }
\ No newline at end of file
@@ -1,13 +1,22 @@
 #pragma once
 
 #include "SensorDevice.h"
+#include "UuidHashTable.h"
+#include "MetaWearTransport.h"
+#include "MetaMotionCSimulator.h"
 
 #include <queue>
 #include <tuple>
 #include <memory>
 #include <string>
+#include <chrono>
 #include <fstream>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+#include <functional>
 
+#include <QSet>
 #include <QThread>
 #include <QtGlobal>
 #include <QtBluetooth/QLowEnergyService>
@@ -17,19 +26,54 @@
 
 #include "metawear/core/data.h"
 #include "metawear/core/types.h"
+#include "metawear/core/logging.h"
 #include "metawear/core/datasignal.h"
+#include "metawear/core/datalogger.h"
+#include "metawear/processor/time.h"
+#include "metawear/processor/dataprocessor.h"
 #include "metawear/core/metawearboard.h"
+#include "metawear/platform/memory.h"
+#include "metawear/sensor/gyro_bmi160.h"
 #include "metawear/sensor/accelerometer.h"
 #include "metawear/sensor/sensor_fusion.h"
 
 #define DISCOVER_DETAILS_DELAY 5000
+#define DISCOVER_DETAILS_POLL 100
 #define DESCRIPTOR_WRITE_DELAY 500
 #define DISCOVERY_TIMEOUT 5000
 #define METAWEARTIMEOUT 500
 
-using bytes_callback_map = std::map<QString, std::tuple<const void*, MblMwFnIntVoidPtrArray>>;
+// raw (packed) acquisition mode
+#define RAW_DEFAULT_RATE 100
+#define RAW_ACC_RANGE 8.0f
+#define RAW_SAMPLES_PER_PACKET 3
+
+// supported output data rates (Hz), accelerometer : ACC_MIN_ODR * 2^n, gyroscope : GYRO_MIN_ODR * 2^n
+#define ACC_MIN_ODR 0.78125f
+#define ACC_N_ODRS 12
+#define GYRO_MIN_ODR 25.0f
+#define GYRO_N_ODRS 8
+
+// onboard logging mode (sensor fusion output rate (Hz), live preview period (ms), notifications per download progress update)
+#define FUSION_RATE 100
+#define LOG_DEFAULT_PREVIEW_PERIOD 100
+#define LOG_DOWNLOAD_N_NOTIFIES 100
+
+using bytes_callback_table = UuidHashTable<std::tuple<const void*, MblMwFnIntVoidPtrArray>>;
 using bytes_callback_queue = std::queue<std::tuple<const void*, MblMwFnIntVoidPtrArray>>;
 
+/**
+* Resolved characteristic (service uuid + service object index + characteristic object)
+*/
+struct GattCharEntry {
+	Uuid128 service_uuid;
+	int service_index;
+	QLowEnergyCharacteristic characteristic;
+};
+
+// characteristics keyed by their uuid (unique among the services of the board)
+using gatt_char_table = UuidHashTable<GattCharEntry>;
+
 /*******************************************************************************
 * WRAPPER FUNCTIONS FOR THE (MblMwBtleConnection) STRUCTURE
 ******************************************************************************/
@@ -43,12 +87,15 @@ void on_disconnect_wrap(void* context, const void* caller, MblMwFnVoidVoidPtrInt
 * Class to enable communication with the MetaWear MetaMotionC gyroscope/magnometer/accelerometer (IMU) sensor.
 * 
 * Communication with the MetaWear C sensor is done via BLE.
-* This class can't utilise threads since it utilises the Bluetooth interface provided by Qt. 
-* The call back functions provided by this interface can only run in the main thread.
+* The client lives in its own thread (m_ble_thread), which runs the event loop of the Qt Bluetooth objects (discovery agent, controller
+* and services). The BLE callbacks, the MetaWear data callbacks and the output writing therefore run in that thread, away from the UI.
+* The (SensorDevice) overrides can be called from any thread, they are forwarded to the BLE thread. Only signals reach the UI thread.
 * This class does not implement the acquisition preview functionality
 */
 class MetaWearBluetoothClient : public SensorDevice {
 
+	Q_OBJECT
+
 	public:
 	
 		MetaWearBluetoothClient(int device_id, std::string device_description, std::string redis_state_entry, std::string log_file_path);
@@ -109,11 +156,73 @@ class MetaWearBluetoothClient : public SensorDevice {
 		*/
 		void on_disconnect(const void* caller, MblMwFnVoidVoidPtrInt handler);
 
+		/**
+		* Clock of a packed signal, samples of a packed notification share the epoch of the notification (host reception time)
+		* and are placed backward from it, one sample period (output data rate applied to the sensor) apart.
+		*/
+		struct PackedSampleClock {
+			double sample_period = 1000.0 / RAW_DEFAULT_RATE;
+			int64_t last_epoch = -1;
+			int packet_index = 0;
+			uint64_t n_samples = 0;
+			uint64_t n_packets = 0;
+		};
+
+		/**
+		* \return The estimated time (ms) of the sample.
+		*/
+		double get_sample_time(PackedSampleClock& clock, int64_t epoch);
+
+		/**
+		* Signal logged onboard (full rate) during the acquisition, with the output file of its samples and download stats
+		*/
+		struct LoggedSignal {
+			MetaWearBluetoothClient* client_p;
+			MblMwDataSignal* signal;
+			MblMwDataLogger* logger;
+			std::ofstream* file_p;
+			bool euler_angles;
+			std::string name;
+			double sample_period;
+			int64_t last_epoch = -1;
+			uint64_t n_samples = 0;
+			uint64_t n_gaps = 0;
+		};
+
+		/**
+		* Callbacks for the downloaded (logged) samples and the live preview samples.
+		*/
+		static void log_data_callback(void* context, const MblMwData* data);
+		static void preview_data_callback(void* context, const MblMwData* data);
+
+		/**
+		* \return The output (csv) string of an euler angles or cartesian sample.
+		*/
+		static std::string format_sample(const std::string& os_time, const MblMwData* data, bool euler_angles);
+
 		// file output attributes + redis
 		std::ofstream m_output_ori_file;
 		std::ofstream m_output_acc_file;
+		std::ofstream m_output_gyro_file;
 		std::string m_redis_entry = "";
 
+		// raw (packed accelerometer + gyroscope) acquisition attributes
+		PackedSampleClock m_acc_clock;
+		PackedSampleClock m_gyro_clock;
+		float m_raw_rate = RAW_DEFAULT_RATE;
+		float m_acc_odr = RAW_DEFAULT_RATE;
+		float m_gyro_odr = RAW_DEFAULT_RATE;
+
+		// onboard logging attributes (the logged signals must not be reallocated while the loggers are subscribed)
+		std::vector<LoggedSignal> m_logged_signals;
+		MblMwDataProcessor* m_preview_processor = nullptr;
+		long long m_log_epoch_offset = std::numeric_limits<long long>::max();
+		uint64_t m_n_unknown_log_entries = 0;
+		size_t m_n_log_setup_steps = 0;
+		bool m_log_started = false;
+		bool m_log_setup_pending = false;
+		bool m_log_setup_cancelled = false;
+
 		// metawear communication attributes
 		MblMwMetaWearBoard* m_metawear_board_p = nullptr;
 		MblMwBtleConnection m_metawear_ble_interface = { 0 };
@@ -125,7 +234,106 @@ class MetaWearBluetoothClient : public SensorDevice {
 		******************************************************************************/
 
 		void clear_metawear_connection(void);
+
+		/**
+		* Subscribes to the sensor fusion signals (euler angles + linear acceleration, one sample per notification).
+		*/
+		void start_fusion_stream(void);
+
+		/**
+		* Subscribes to the packed accelerometer and gyroscope signals (several samples per notification), at the supported
+		* output data rates closest to (m_raw_rate) (m_acc_odr, m_gyro_odr).
+		*/
+		void start_raw_stream(void);
+		void stop_raw_stream(void);
+		void configure_raw_sensors(void);
+		void start_raw_sensors(void);
+		void stop_raw_sensors(void);
+
+		/**
+		* Logs the acquisition signals onboard (full rate) and streams a decimated preview (1 sample per m_log_preview_period)
+		* The loggers and the preview processor are created asynchronously, one after the other (setup_next_log_step).
+		*/
+		void start_log_stream(void);
+		void setup_next_log_step(void);
+
+		/**
+		* Handles the board answer to a logger / preview processor creation. Returns (false) when the setup does not continue :
+		* the stream was stopped while the step was pending (the deferred cleanup is done here) or the board could not create it.
+		*
+		* \param created If the logger / processor was created by the board.
+		*/
+		bool end_log_setup_step(bool created);
+
+		/**
+		* Stops the stream after a failed logging setup, then disconnects the device (status change).
+		*/
+		void fail_log_stream(void);
+
+		/**
+		* Stops the logging and starts the bulk download of the log, the samples are written to the output files as they are received.
+		*/
+		void stop_log_stream(void);
+
+		/**
+		* Reports the downloaded samples, releases the loggers and clears the board log (when the board is still available).
+		*/
+		void finish_log_download(bool board_available);
+
+		/**
+		* Creates the MetaWear board object (restoring the cached board state on reconnections) and initializes it.
+		* Called once the device is reachable (Qt BLE services discovered, or transport connected).
+		*/
+		void initialize_board(void);
+
+		/**
+		* Connects to the board through the transport of the url (instead of the Qt BLE services), the transport is kept between connections.
+		*
+		* \param transport_url The transport url (ext_imu_transport_url), see (MetaMotionCSimulator) for the simulator.
+		*/
+		void connect_transport(const std::string& transport_url);
+
+		/**
+		* Stores the serialized board state (module information), restored before the initialization of cached reconnections.
+		*/
+		void cache_board_state(void);
+
+		/**
+		* Forgets the cached device, services and board state (the next connection scans for the device).
+		*/
+		void clear_connection_cache(void);
+
+		/**
+		* Clears the cache after a controller error / disconnection of a cached connection. A cached reconnection that
+		* did not complete falls back to a full connection (queued, the controller is released by the new connection).
+		*/
+		void drop_cached_connection(void);
+
+		/**
+		* Queues the function for execution in the BLE thread.
+		*
+		* \param function The function to execute.
+		* \param blocking When true, returns once the function was executed (must not be called from the BLE thread).
+		*/
+		void run_in_ble_thread(const std::function<void(void)>& function, bool blocking);
+		bool in_ble_thread(void) const;
 		QBluetoothUuid metawear_uuid_to_qt_uuid(const uint64_t uuid_low, const uint64_t uuid_high) const;
+		static Uuid128 qt_uuid_to_key(const QBluetoothUuid& uuid);
+		static Uuid128 metawear_uuid_to_key(const uint64_t uuid_low, const uint64_t uuid_high);
+
+		/**
+		* Fills the characteristic lookup table with the characteristics of the discovered services.
+		*/
+		void build_characteristic_table(void);
+
+		/**
+		* Looks up the characteristic in the lookup table (O(1), debug output on misses only).
+		*
+		* \param characteristic_struct The service and characteristic uuids.
+		* \param service_index Set to the index of the service object (-1 on misses).
+		* \param debug_str Description of the caller (for the debug output).
+		* \return The characteristic object (invalid on misses).
+		*/
 		QLowEnergyCharacteristic find_characteristic(const MblMwGattChar* characteristic_struct, int& service_index, const QString& debug_str = "");
 	
 		// synchronization status var
@@ -135,18 +343,43 @@ class MetaWearBluetoothClient : public SensorDevice {
 		bool m_output_file_loaded = false;
 		std::string m_output_ori_file_str = "";
 		std::string m_output_acc_file_str = "";
+		std::string m_output_gyro_file_str = "";
+
+		// acquisition mode (raw or sensor fusion, onboard logging) and stream start time (achieved rate report)
+		bool m_raw_mode = false;
+		bool m_log_mode = false;
+		bool m_log_downloading = false;
+		std::string m_deferred_output_folder_path = "";
+		int m_log_preview_period = LOG_DEFAULT_PREVIEW_PERIOD;
+		MblMwLogDownloadHandler m_log_download_handler = { 0 };
+		std::chrono::steady_clock::time_point m_log_download_start_time;
+		std::chrono::steady_clock::time_point m_stream_start_time;
 
 		// device disconnect handling vars
 		const void* m_disconnect_event_caller = nullptr;
 		MblMwFnVoidVoidPtrInt m_disconnect_handler = nullptr;
 
-		// ble communication objects
+		// ble communication objects (owned by the BLE thread)
+		QThread m_ble_thread;
 		QBluetoothDeviceDiscoveryAgent m_discovery_agent;
 		std::vector<std::shared_ptr<QLowEnergyService>> m_metawear_services_p;
 		std::shared_ptr<QLowEnergyController> m_metawear_device_controller_p = nullptr;
+		gatt_char_table m_characteristic_table;
+
+		// connection cache (reconnections skip the device scan, only explore the used services and restore the board state)
+		bool m_device_cached = false;
+		bool m_cached_connection = false;
+		QBluetoothDeviceInfo m_cached_device_info;
+		QSet<QBluetoothUuid> m_used_service_uuids;
+		std::vector<uint8_t> m_cached_board_state;
+		std::chrono::steady_clock::time_point m_connect_start_time;
+
+		// transport used instead of the Qt BLE services (nullptr when using the Qt BLE services)
+		std::string m_transport_url = "";
+		std::shared_ptr<MetaWearTransport> m_transport_p = nullptr;
 		
 		// callback structure
-		bytes_callback_map m_char_update_callback_map;
+		bytes_callback_table m_char_update_callback_table;
 		bytes_callback_queue m_char_read_callback_queue;
 
 	private slots:
@@ -177,6 +410,7 @@ class MetaWearBluetoothClient : public SensorDevice {
 
 		/**
 		* Callback function for the (QLowEnergyService::characteristicChanged) and (QLowEnergyService::characteristicWritten) signals emited by all BLE services
+		* The handler is looked up by the 128 bit characteristic UUID (flat hash table) and receives the packet data in place (no allocation).
 		* Flow :
 		*	1) The metaWear API calls write_gatt_char_wrap() -> write_gatt_char() which sends out a characteristic write request to the device
 		*	2) The MetaWear device confirms that data was written to the characteristic, trigerring this callback
@@ -184,4 +418,7 @@ class MetaWearBluetoothClient : public SensorDevice {
 		*/
 		void service_characteristic_changed(const QLowEnergyCharacteristic& characteristic, const QByteArray& newValue);
 
+	signals:
+		void log_download_progress(int n_downloaded_entries, int n_total_entries);
+
 };
\ No newline at end of file
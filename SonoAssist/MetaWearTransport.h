@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <functional>
+
+#include "metawear/core/connection.h"
+
+/**
+* Transport of the MetaWear SDK (MblMwBtleConnection) when the board is not reached through the Qt BLE services of (MetaWearBluetoothClient).
+* (MetaWearBluetoothClient) forwards the GATT operations of the SDK to the transport of its (ext_imu_transport_url).
+*
+* The SDK is not thread safe, transports never call the SDK handlers from their own threads or from within the GATT operations.
+* The handlers are queued with the dispatcher, which runs them in the thread of the client (BLE thread).
+*/
+class MetaWearTransport {
+
+	public:
+
+		using dispatcher = std::function<void(std::function<void(void)>)>;
+
+		virtual ~MetaWearTransport() {}
+
+		/**
+		* \param connection_handler Called (through the dispatcher) with the connection status once the connection attempt is completed.
+		*/
+		virtual void connect_transport(std::function<void(bool)> connection_handler) = 0;
+		virtual void disconnect_transport(void) = 0;
+
+		// GATT operations of the (MblMwBtleConnection) interface
+		virtual void read_gatt_char(const void* caller, const MblMwGattChar* characteristic, MblMwFnIntVoidPtrArray handler) = 0;
+		virtual void write_gatt_char(MblMwGattCharWriteType write_type, const MblMwGattChar* characteristic, const uint8_t* value, uint8_t length) = 0;
+		virtual void enable_notifications(const void* caller, const MblMwGattChar* characteristic, MblMwFnIntVoidPtrArray handler,
+			MblMwFnVoidVoidPtrInt ready) = 0;
+
+		/**
+		* \return A description of the transport activity (notifications sent, lost ...), reported when the stream stops.
+		*/
+		virtual std::string get_stats(void) const = 0;
+
+		void set_dispatcher(dispatcher dispatcher_function) { m_dispatcher = dispatcher_function; }
+
+	protected:
+
+		dispatcher m_dispatcher;
+
+};
\ No newline at end of file
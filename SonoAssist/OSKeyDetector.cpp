@@ -1,5 +1,28 @@
 #include "OSKeyDetector.h"
 
+#include <cctype>
+#include <sstream>
+
+#ifndef _WIN32
+#include <ctime>
+#include <cerrno>
+#include <vector>
+#include <poll.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/input.h>
+#endif
+
+#ifdef _WIN32
+OSKeyDetector* OSKeyDetector::m_hook_detector = nullptr;
+#endif
+
+OSKeyDetector::~OSKeyDetector() {
+    stop_listening();
+}
+
 /*******************************************************************************
 * SENSOR DEVICE OVERRIDES
 ******************************************************************************/
@@ -7,7 +30,11 @@
 void OSKeyDetector::connect_device(void) {
 
     if (m_config_loaded && m_sensor_used) {
-        m_device_connected = true;
+
+        // (re)starting the key listener with the configured key actions
+        stop_listening();
+        m_device_connected = load_key_actions() && start_listening((*m_config_ptr)["os_key_input_device"]);
+
     }
 
     emit device_status_change(m_device_id, m_device_connected);
@@ -16,6 +43,8 @@ void OSKeyDetector::connect_device(void) {
 
 void OSKeyDetector::disconnect_device(void) {
  
+    stop_listening();
+
     m_device_connected = false;
     emit device_status_change(m_device_id, false);
 
@@ -23,15 +52,9 @@ void OSKeyDetector::disconnect_device(void) {
 
 void OSKeyDetector::start_stream() {
 
+    // the key presses are received as long as the device is connected
     if (m_device_connected && !m_device_streaming) {
-
-        // launching the key detection thread
-        m_listen = true;
-        m_listener_thread = std::thread(&OSKeyDetector::detect_keys, this);
-
-        // once the acquisition process is launched, changing the sensor's acquisition state 
         m_device_streaming = true;
-
     }
 
 }
@@ -39,51 +62,292 @@ void OSKeyDetector::start_stream() {
 void OSKeyDetector::stop_stream() {
 
     if (m_device_streaming) {
+        m_device_streaming = false;
+    }
 
-        // stopping the data collection thread
-        m_listen = false;
-        m_listener_thread.join();
+}
 
-        // once the acquisition process is stoped, changing the sensor's acquisition state 
-        m_device_streaming = false;
+/*******************************************************************************
+* KEY ACTIONS
+******************************************************************************/
+
+bool OSKeyDetector::load_key_actions(void) {
+
+    static const std::map<std::string, int> action_names = {
+        {"add_marker", OS_ACTION_ADD_MARKER}, {"remove_marker", OS_ACTION_REMOVE_MARKER},
+        {"start_acquisition", OS_ACTION_START_ACQUISITION}, {"stop_acquisition", OS_ACTION_STOP_ACQUISITION}
+    };
+
+    std::string key_actions_str = (*m_config_ptr)["os_key_actions"];
+    if (key_actions_str.empty()) key_actions_str = OS_DEFAULT_KEY_ACTIONS;
+
+    // parsing the "key:action" pairs (seperated by commas)
+    m_key_actions.clear();
+    std::stringstream key_actions_stream(key_actions_str);
+    std::string key_action;
+
+    while (std::getline(key_actions_stream, key_action, ',')) {
+
+        key_action.erase(0, key_action.find_first_not_of(' '));
+        key_action.erase(key_action.find_last_not_of(' ') + 1);
+        size_t separator = key_action.find(':');
+        if (separator == std::string::npos) continue;
+
+        int key_code = get_key_code(key_action.substr(0, separator));
+        auto action = action_names.find(key_action.substr(separator + 1));
+        if (key_code >= 0 && action != action_names.end()) {
+            m_key_actions[key_code] = action->second;
+        } else {
+            write_debug_output("OSKeyDetector - invalid key action : " + QString(key_action.c_str()));
+        }
 
     }
 
+    if (m_key_actions.empty()) write_debug_output("OSKeyDetector - no valid key action in : " + QString(key_actions_str.c_str()));
+    return !m_key_actions.empty();
+
+}
+
+int OSKeyDetector::get_key_code(const std::string& key_name) {
+
+    std::string name = key_name;
+    for (auto& character : name) character = std::toupper(static_cast<unsigned char>(character));
+
+#ifdef _WIN32
+
+    // virtual key codes (letters and digits are their ascii codes)
+    if (name.size() == 1 && std::isalnum(static_cast<unsigned char>(name[0]))) return name[0];
+    if (name == "SPACE") return VK_SPACE;
+    if (name.size() >= 2 && name[0] == 'F') {
+        int function_index = std::atoi(name.c_str() + 1);
+        if (function_index >= 1 && function_index <= 12) return VK_F1 + function_index - 1;
+    }
+
+#else
+
+    // evdev key codes
+    static const std::map<std::string, int> key_codes = {
+        {"A", KEY_A}, {"B", KEY_B}, {"C", KEY_C}, {"D", KEY_D}, {"E", KEY_E}, {"F", KEY_F}, {"G", KEY_G}, {"H", KEY_H},
+        {"I", KEY_I}, {"J", KEY_J}, {"K", KEY_K}, {"L", KEY_L}, {"M", KEY_M}, {"N", KEY_N}, {"O", KEY_O}, {"P", KEY_P},
+        {"Q", KEY_Q}, {"R", KEY_R}, {"S", KEY_S}, {"T", KEY_T}, {"U", KEY_U}, {"V", KEY_V}, {"W", KEY_W}, {"X", KEY_X},
+        {"Y", KEY_Y}, {"Z", KEY_Z}, {"0", KEY_0}, {"1", KEY_1}, {"2", KEY_2}, {"3", KEY_3}, {"4", KEY_4}, {"5", KEY_5},
+        {"6", KEY_6}, {"7", KEY_7}, {"8", KEY_8}, {"9", KEY_9}, {"F1", KEY_F1}, {"F2", KEY_F2}, {"F3", KEY_F3},
+        {"F4", KEY_F4}, {"F5", KEY_F5}, {"F6", KEY_F6}, {"F7", KEY_F7}, {"F8", KEY_F8}, {"F9", KEY_F9}, {"F10", KEY_F10},
+        {"F11", KEY_F11}, {"F12", KEY_F12}, {"SPACE", KEY_SPACE}
+    };
+    auto key_code = key_codes.find(name);
+    if (key_code != key_codes.end()) return key_code->second;
+
+#endif
+
+    return -1;
+
+}
+
+void OSKeyDetector::handle_key_event(int key_code, bool pressed, long long os_time) {
+
+    // releases re-arm the key, repeats (key held down) are ignored
+    if (!pressed) {
+        m_pressed_keys.erase(key_code);
+        return;
+    }
+    if (!m_pressed_keys.insert(key_code).second) return;
+
+    auto key_action = m_key_actions.find(key_code);
+    if (key_action != m_key_actions.end()) {
+        emit key_detected(key_action->second, os_time);
+    }
+
 }
 
 /*******************************************************************************
 * DATA COLLECTION FUNCTIONS
 ******************************************************************************/
 
-void OSKeyDetector::detect_keys() {
+#ifdef _WIN32
+
+void OSKeyDetector::listen_keys(std::string input_device) {
 
-    int input_cycle = 0;
-    int input_cycle_offset = 15;
+    (void) input_device;
 
+    // installing the hook (its events are delivered while this thread retrieves its messages)
+    m_hook_detector = this;
+    HHOOK keyboard_hook_handle = SetWindowsHookEx(WH_KEYBOARD_LL, &OSKeyDetector::keyboard_hook, GetModuleHandle(NULL), 0);
+    if (keyboard_hook_handle == NULL) {
+        write_debug_output("OSKeyDetector - failed to install the keyboard hook, error : " + QString::number(GetLastError()));
+        return;
+    }
+
+    // waiting for messages (hook events) or the stop event
+    MSG message;
     while (m_listen) {
+        DWORD wait_result = MsgWaitForMultipleObjects(1, &m_stop_event, FALSE, INFINITE, QS_ALLINPUT);
+        if (wait_result == WAIT_OBJECT_0) break;
+        while (PeekMessage(&message, NULL, 0, 0, PM_REMOVE)) {
+            TranslateMessage(&message);
+            DispatchMessage(&message);
+        }
+    }
 
-        if (input_cycle == 0) {
-        
-            // looking for a key press in the monitored keys 
-            // https://stackoverflow.com/questions/41600981/how-do-i-check-if-a-key-is-pressed-on-c
-            int key = OS_NO_KEY;
-            if (GetKeyState('A') & 0x8000) key = OS_A_KEY;
-            else if (GetKeyState('D') & 0x8000) key = OS_D_KEY;
-        
-            // emitting to the main window once a key press is detected
-            if (key != OS_NO_KEY) {
-                input_cycle = input_cycle_offset;
-                emit key_detected(key);
-            }
+    UnhookWindowsHookEx(keyboard_hook_handle);
+    m_hook_detector = nullptr;
+
+}
+
+LRESULT CALLBACK OSKeyDetector::keyboard_hook(int code, WPARAM w_param, LPARAM l_param) {
+
+    // the hook is called as the event is dispatched, its time is sampled first (the event time of the hook is in ms)
+    long long os_time = get_micro_timestamp_count();
+
+    if (code == HC_ACTION && m_hook_detector != nullptr) {
+        KBDLLHOOKSTRUCT* key_event = reinterpret_cast<KBDLLHOOKSTRUCT*>(l_param);
+        bool pressed = (w_param == WM_KEYDOWN || w_param == WM_SYSKEYDOWN);
+        m_hook_detector->handle_key_event(key_event->vkCode, pressed, os_time);
+    }
+
+    return CallNextHookEx(NULL, code, w_param, l_param);
+
+}
+
+bool OSKeyDetector::start_listening(const std::string& input_device) {
+
+    // the listener thread can only be stopped through the stop event
+    m_stop_event = CreateEvent(NULL, TRUE, FALSE, NULL);
+    if (m_stop_event == NULL) {
+        write_debug_output("OSKeyDetector - failed to create the stop event, error : " + QString::number(GetLastError()));
+        return false;
+    }
+
+    m_listen = true;
+    m_listener_thread = std::thread(&OSKeyDetector::listen_keys, this, input_device);
+    return true;
+
+}
+
+void OSKeyDetector::stop_listening(void) {
+
+    if (m_listener_thread.joinable()) {
+        m_listen = false;
+        SetEvent(m_stop_event);
+        m_listener_thread.join();
+    }
 
+    if (m_stop_event != NULL) {
+        CloseHandle(m_stop_event);
+        m_stop_event = NULL;
+    }
+    m_pressed_keys.clear();
+
+}
+
+#else
+
+void OSKeyDetector::listen_keys(std::string input_device) {
+
+    // opening the configured input device, or all of the keyboards (devices with letter keys)
+    std::vector<std::string> device_paths;
+    if (!input_device.empty()) {
+        device_paths.push_back(input_device);
+    } else if (DIR* input_dir = opendir("/dev/input")) {
+        while (dirent* entry = readdir(input_dir)) {
+            if (std::string(entry->d_name).rfind("event", 0) == 0) device_paths.push_back("/dev/input/" + std::string(entry->d_name));
         }
+        closedir(input_dir);
+    }
 
-        else if (input_cycle > 0) {
-            input_cycle--;
+    std::vector<pollfd> poll_fds = {{m_stop_pipe[0], POLLIN, 0}};
+    for (const auto& device_path : device_paths) {
+
+        int device_fd = open(device_path.c_str(), O_RDONLY | O_NONBLOCK);
+        if (device_fd < 0) continue;
+
+        unsigned long key_bits[KEY_MAX / (8 * sizeof(unsigned long)) + 1] = {0};
+        ioctl(device_fd, EVIOCGBIT(EV_KEY, sizeof(key_bits)), key_bits);
+        bool keyboard = (key_bits[KEY_A / (8 * sizeof(unsigned long))] >> (KEY_A % (8 * sizeof(unsigned long)))) & 1;
+
+        // event times in the monotonic clock (event age computation)
+        int clock_id = CLOCK_MONOTONIC;
+        if (keyboard || !input_device.empty()) {
+            ioctl(device_fd, EVIOCSCLOCKID, &clock_id);
+            poll_fds.push_back({device_fd, POLLIN, 0});
+        } else {
+            close(device_fd);
         }
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(25));
-        
     }
 
-}
\ No newline at end of file
+    if (poll_fds.size() == 1) write_debug_output("OSKeyDetector - no readable keyboard device found (/dev/input permissions)");
+
+    // waiting for input events or the stop signal
+    input_event events[64];
+    while (m_listen && poll(poll_fds.data(), poll_fds.size(), -1) >= 0) {
+
+        if (poll_fds[0].revents & POLLIN) break;
+
+        for (size_t i = 1; i < poll_fds.size(); i++) {
+
+            // removed devices are no longer polled
+            if (poll_fds[i].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+                close(poll_fds[i].fd);
+                poll_fds[i].fd = -1;
+                continue;
+            }
+
+            if (!(poll_fds[i].revents & POLLIN)) continue;
+            ssize_t n_bytes = read(poll_fds[i].fd, events, sizeof(events));
+            if (n_bytes <= 0) continue;
+
+            // the event times (monotonic clock) are converted with the age of the events
+            timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            long long os_now = get_micro_timestamp_count();
+            for (size_t j = 0; j < n_bytes / sizeof(input_event); j++) {
+                if (events[j].type != EV_KEY || events[j].value == 2) continue;
+                long long event_age = (now.tv_sec - events[j].time.tv_sec) * 1000000LL + (now.tv_nsec / 1000 - events[j].time.tv_usec);
+                handle_key_event(events[j].code, events[j].value == 1, os_now - event_age);
+            }
+
+        }
+
+    }
+
+    for (size_t i = 1; i < poll_fds.size(); i++) {
+        if (poll_fds[i].fd >= 0) close(poll_fds[i].fd);
+    }
+
+}
+
+bool OSKeyDetector::start_listening(const std::string& input_device) {
+
+    // the listener thread can only be stopped through the stop pipe
+    if (pipe(m_stop_pipe) != 0) {
+        m_stop_pipe[0] = m_stop_pipe[1] = -1;
+        write_debug_output("OSKeyDetector - failed to create the stop pipe, error : " + QString::number(errno));
+        return false;
+    }
+
+    m_listen = true;
+    m_listener_thread = std::thread(&OSKeyDetector::listen_keys, this, input_device);
+    return true;
+
+}
+
+void OSKeyDetector::stop_listening(void) {
+
+    if (m_listener_thread.joinable()) {
+        m_listen = false;
+        ssize_t written = write(m_stop_pipe[1], "x", 1);
+        (void) written;
+        m_listener_thread.join();
+    }
+
+    if (m_stop_pipe[0] >= 0) {
+        close(m_stop_pipe[0]);
+        close(m_stop_pipe[1]);
+        m_stop_pipe[0] = m_stop_pipe[1] = -1;
+    }
+    m_pressed_keys.clear();
+
+}
+
+#endif
\ No newline at end of file
@@ -1,19 +1,37 @@
 #pragma once
 
+#include <set>
+#include <map>
 #include <string>
 #include <thread>
+#include <atomic>
 #include <fstream>
+
+#ifdef _WIN32
 #include <Windows.h>
+#endif
 
 #include "SensorDevice.h"
 
-#define OS_NO_KEY 0
-#define OS_A_KEY 1
-#define OS_D_KEY 2
+// actions associated to the keys (os_key_actions)
+#define OS_ACTION_NONE 0
+#define OS_ACTION_ADD_MARKER 1
+#define OS_ACTION_REMOVE_MARKER 2
+#define OS_ACTION_START_ACQUISITION 3
+#define OS_ACTION_STOP_ACQUISITION 4
+
+#define OS_DEFAULT_KEY_ACTIONS "A:add_marker, D:remove_marker"
 
 /*
-* Class for the detection of key presses ('A' and 'D' keys for now)
-* The key presses can be detected even when the main application window is out of focus or minimized
+* Class for the detection of key presses, the keys and their actions are defined by the (os_key_actions) parameter
+* ("key:action" pairs, keys : A-Z, 0-9, F1-F12, SPACE, actions : add_marker, remove_marker, start_acquisition, stop_acquisition).
+* The default only defines the markers (A / D), keys starting / stopping the acquisition must be added explicitly.
+* 
+* Key presses are received as OS input events (no polling) : low level keyboard hook on Windows, evdev keyboards on Linux
+* (all of the keyboards, or the (os_key_input_device) device, such as a uinput test device). Each press is emitted with the
+* time of the input event : reception time of the hook call on Windows, evdev event time on Linux (key repeats are ignored).
+* The key presses can be detected even when the main application window is out of focus or minimized.
+* Key presses are detected while the device is connected (acquisitions can be started with a key), the main window filters the actions.
 */
 class OSKeyDetector : public SensorDevice {
 
@@ -24,6 +42,7 @@ class OSKeyDetector : public SensorDevice {
 		OSKeyDetector(int device_id, const std::string& device_description, 
 			const std::string& redis_state_entry, const std::string& log_file_path): 
 			SensorDevice(device_id, device_description, redis_state_entry, log_file_path) {};
+		~OSKeyDetector();
 
 		void stop_stream(void) override;
 		void start_stream(void) override;
@@ -34,15 +53,59 @@ class OSKeyDetector : public SensorDevice {
 	private:
 
 		/**
-		* Detects and emits key presses (for the 'A' and 'D' keys) to the main window
-		* This method is meant to run in a seperate thread
+		* Fills the key code -> action map from the (os_key_actions) parameter.
+		*
+		* \return (false) if no valid key action was found.
+		*/
+		bool load_key_actions(void);
+
+		/**
+		* \param key_name The name of the key (A-Z, 0-9, F1-F12, SPACE).
+		* \return The platform key code (virtual key code / evdev code), -1 for unknown keys.
+		*/
+		static int get_key_code(const std::string& key_name);
+
+		/**
+		* Emits the action of the key on presses (repeats and releases are ignored).
+		*
+		* \param key_code The platform key code.
+		* \param pressed True for key down events.
+		* \param os_time The time (us, get_micro_timestamp_count) of the input event.
 		*/
-		void detect_keys(void);
+		void handle_key_event(int key_code, bool pressed, long long os_time);
 
-		bool m_listen = false;
+		/**
+		* Receives the OS input events until (m_listen) is cleared, meant to run in a seperate thread
+		*
+		* \param input_device The evdev device to read (Linux), all of the keyboards when empty.
+		*/
+		void listen_keys(std::string input_device);
+
+		/**
+		* Starts the listener thread (see listen_keys).
+		*
+		* \param input_device The evdev device to read (Linux), all of the keyboards when empty.
+		* \return (false) when the stop event / pipe of the listener could not be created (no thread is started).
+		*/
+		bool start_listening(const std::string& input_device);
+		void stop_listening(void);
+
+		std::atomic<bool> m_listen = false;
 		std::thread m_listener_thread;
+		std::map<int, int> m_key_actions;
+		std::set<int> m_pressed_keys;
+
+#ifdef _WIN32
+		// low level hook (a single detector receives the hook events)
+		static LRESULT CALLBACK keyboard_hook(int code, WPARAM w_param, LPARAM l_param);
+		static OSKeyDetector* m_hook_detector;
+		HANDLE m_stop_event = NULL;
+#else
+		// pipe waking the listener thread when stopping
+		int m_stop_pipe[2] = {-1, -1};
+#endif
 
 	signals:
-		void key_detected(int key);
+		void key_detected(int action, long long os_time);
 
 };
\ No newline at end of file
@@ -0,0 +1,149 @@
+#include "PointCloudGenerator.h"
+
+#include <cmath>
+#include <cstring>
+
+#ifdef PC_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+// voxel indices are packed on 21 bits per axis (offset to stay positive)
+#define PC_VOXEL_INDEX_BITS 21
+#define PC_VOXEL_INDEX_OFFSET (1 << (PC_VOXEL_INDEX_BITS - 1))
+#define PC_VOXEL_INDEX_MASK ((1ULL << PC_VOXEL_INDEX_BITS) - 1)
+
+/*******************************************************************************
+* LOOKUP TABLE
+******************************************************************************/
+
+void PointCloudGenerator::set_intrinsics(const rs2_intrinsics& intrinsics) {
+
+	if (std::memcmp(&intrinsics, &m_intrinsics, sizeof(rs2_intrinsics)) == 0) return;
+	m_intrinsics = intrinsics;
+
+	size_t n_pixels = static_cast<size_t>(intrinsics.width) * intrinsics.height;
+	m_ray_x.resize(n_pixels);
+	m_ray_y.resize(n_pixels);
+	m_x.resize(n_pixels);
+	m_y.resize(n_pixels);
+	m_z.resize(n_pixels);
+
+	// deprojecting every pixel at a depth of 1
+	float point[3];
+	for (int v = 0; v < intrinsics.height; v++) {
+		for (int u = 0; u < intrinsics.width; u++) {
+			float pixel[2] = {static_cast<float>(u), static_cast<float>(v)};
+			rs2_deproject_pixel_to_point(point, &intrinsics, pixel, 1.f);
+			m_ray_x[v * intrinsics.width + u] = point[0];
+			m_ray_y[v * intrinsics.width + u] = point[1];
+		}
+	}
+
+}
+
+/*******************************************************************************
+* POINT CLOUD GENERATION
+******************************************************************************/
+
+size_t PointCloudGenerator::generate(const uint16_t* depth_data, size_t depth_stride, float depth_units, float voxel_size, std::vector<float>& xyz) {
+
+	size_t n_pixels = m_z.size();
+	deproject(depth_data, depth_stride, depth_units);
+
+	// packing the valid points
+	if (voxel_size <= 0) {
+
+		xyz.resize(3 * n_pixels);
+		float* xyz_p = xyz.data();
+		for (size_t i = 0; i < n_pixels; i++) {
+			if (m_z[i] > 0) {
+				*xyz_p++ = m_x[i];
+				*xyz_p++ = m_y[i];
+				*xyz_p++ = m_z[i];
+			}
+		}
+
+		xyz.resize(xyz_p - xyz.data());
+		return xyz.size() / 3;
+
+	}
+
+	// accumulating the valid points in their voxel (voxels are output in order of first occupation)
+	m_voxels.clear();
+	m_voxel_order.clear();
+	float inv_voxel_size = 1.f / voxel_size;
+
+	for (size_t i = 0; i < n_pixels; i++) {
+
+		if (m_z[i] <= 0) continue;
+
+		uint64_t key = 0;
+		for (float coord : {m_x[i], m_y[i], m_z[i]}) {
+			int64_t index = static_cast<int64_t>(std::floor(coord * inv_voxel_size)) + PC_VOXEL_INDEX_OFFSET;
+			key = (key << PC_VOXEL_INDEX_BITS) | (static_cast<uint64_t>(index) & PC_VOXEL_INDEX_MASK);
+		}
+
+		VoxelAccumulator& voxel = m_voxels[key];
+		if (voxel.n_points++ == 0) m_voxel_order.push_back(key);
+		voxel.x += m_x[i];
+		voxel.y += m_y[i];
+		voxel.z += m_z[i];
+
+	}
+
+	xyz.resize(3 * m_voxel_order.size());
+	float* xyz_p = xyz.data();
+	for (uint64_t key : m_voxel_order) {
+		const VoxelAccumulator& voxel = m_voxels[key];
+		float inv_n_points = 1.f / voxel.n_points;
+		*xyz_p++ = voxel.x * inv_n_points;
+		*xyz_p++ = voxel.y * inv_n_points;
+		*xyz_p++ = voxel.z * inv_n_points;
+	}
+
+	return m_voxel_order.size();
+
+}
+
+void PointCloudGenerator::deproject(const uint16_t* depth_data, size_t depth_stride, float depth_units) {
+
+	size_t width = m_intrinsics.width;
+	const uint8_t* depth_bytes = reinterpret_cast<const uint8_t*>(depth_data);
+
+#ifdef PC_USE_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 units = _mm_set1_ps(depth_units);
+#endif
+
+	// the depth rows may be padded (stride), the per pixel buffers are not
+	for (int v = 0; v < m_intrinsics.height; v++) {
+
+		size_t x = 0;
+		size_t row_offset = v * width;
+		const uint16_t* depth_row = reinterpret_cast<const uint16_t*>(depth_bytes + v * depth_stride);
+
+#ifdef PC_USE_SSE2
+
+		// 4 pixels per iteration : depth (u16) -> z (f32) -> x, y from the rays
+		for (; x + 4 <= width; x += 4) {
+			size_t i = row_offset + x;
+			__m128i depth = _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(depth_row + x)), zero);
+			__m128 z = _mm_mul_ps(_mm_cvtepi32_ps(depth), units);
+			_mm_storeu_ps(m_z.data() + i, z);
+			_mm_storeu_ps(m_x.data() + i, _mm_mul_ps(_mm_loadu_ps(m_ray_x.data() + i), z));
+			_mm_storeu_ps(m_y.data() + i, _mm_mul_ps(_mm_loadu_ps(m_ray_y.data() + i), z));
+		}
+
+#endif
+
+		for (; x < width; x++) {
+			size_t i = row_offset + x;
+			float z = depth_row[x] * depth_units;
+			m_z[i] = z;
+			m_x[i] = m_ray_x[i] * z;
+			m_y[i] = m_ray_y[i] * z;
+		}
+
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+#include <librealsense2/rs.hpp>
+#include <librealsense2/rsutil.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PC_USE_SSE2
+#endif
+
+/**
+* Class converting depth images to point clouds (XYZ, meters, camera coordinates).
+*
+* The deprojection rays (x / z and y / z for every pixel, distortion model included) are computed once from the
+* stream intrinsics and stored in a lookup table, converting a depth image is then reduced to multiplications
+* (4 pixels at a time with SSE2). Invalid pixels (depth of 0) are discarded and the points can optionally
+* be downsampled on a voxel grid (one point, the centroid, per occupied voxel).
+*/
+class PointCloudGenerator {
+
+	public:
+
+		PointCloudGenerator() {}
+
+		/**
+		* Builds the ray lookup table for the provided intrinsics (no-op when the intrinsics did not change).
+		*
+		* \param intrinsics The intrinsics of the depth stream.
+		*/
+		void set_intrinsics(const rs2_intrinsics& intrinsics);
+
+		/**
+		* Generates the point cloud of the provided depth image, sized according to the current intrinsics.
+		*
+		* \param depth_data The depth pixels.
+		* \param depth_stride The size (bytes) of a depth row, padding included (rs2::video_frame::get_stride_in_bytes).
+		* \param depth_units The depth (meters) of one depth unit.
+		* \param voxel_size The size (meters) of the downsampling voxels, values <= 0 disable the downsampling.
+		* \param xyz The packed (x, y, z) coordinates of the points (float32, meters), resized to 3 * the number of points.
+		* \return The number of points.
+		*/
+		size_t generate(const uint16_t* depth_data, size_t depth_stride, float depth_units, float voxel_size, std::vector<float>& xyz);
+
+	private:
+
+		/**
+		* Computes the coordinates of every pixel into (m_x, m_y, m_z), invalid pixels have a z of 0.
+		*/
+		void deproject(const uint16_t* depth_data, size_t depth_stride, float depth_units);
+
+		/**
+		* Running sum of the points falling in a voxel
+		*/
+		struct VoxelAccumulator {
+			float x = 0;
+			float y = 0;
+			float z = 0;
+			uint32_t n_points = 0;
+		};
+
+		// ray lookup table (one entry per pixel)
+		rs2_intrinsics m_intrinsics = {};
+		std::vector<float> m_ray_x;
+		std::vector<float> m_ray_y;
+
+		// per pixel coordinates (reused between frames)
+		std::vector<float> m_x;
+		std::vector<float> m_y;
+		std::vector<float> m_z;
+
+		// voxel grid (reused between frames)
+		std::vector<uint64_t> m_voxel_order;
+		std::unordered_map<uint64_t, VoxelAccumulator> m_voxels;
+
+};
\ No newline at end of file
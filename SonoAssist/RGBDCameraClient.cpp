@@ -16,18 +16,41 @@ void RGBDCameraClient::connect_device(void) {
 
 	if (m_config_loaded && m_sensor_used) {
 	
-		write_debug_output("RGBDCameraClient - testing the connection to the camera");
-
-		// testing connection with the camera
-		try {			
-			rs2::pipeline p;
-			p.start();
-			p.stop();
-			m_device_connected = true;
-			write_debug_output("RGBDCameraClient - successfully connected to the camera");
-		} catch (...) {
-			m_device_connected = false;
-			write_debug_output("RGBDCameraClient - failed to connect to the camera");
+		configure_playback();
+		configure_recording();
+
+		// testing the playback file (no camera required)
+		if (!m_playback_file_str.empty()) {
+			
+			write_debug_output("RGBDCameraClient - testing the playback file : " + QString::fromStdString(m_playback_file_str));
+
+			try {
+				rs2::context ctx;
+				rs2::playback playback_device = ctx.load_device(m_playback_file_str);
+				ctx.unload_device(m_playback_file_str);
+				m_device_connected = true;
+				write_debug_output("RGBDCameraClient - successfully opened the playback file");
+			} catch (...) {
+				m_device_connected = false;
+				write_debug_output("RGBDCameraClient - failed to open the playback file");
+			}
+
+		} else {
+
+			write_debug_output("RGBDCameraClient - testing the connection to the camera");
+
+			// testing connection with the camera
+			try {			
+				rs2::pipeline p;
+				p.start();
+				p.stop();
+				m_device_connected = true;
+				write_debug_output("RGBDCameraClient - successfully connected to the camera");
+			} catch (...) {
+				m_device_connected = false;
+				write_debug_output("RGBDCameraClient - failed to connect to the camera");
+			}
+
 		}
 
 		emit device_status_change(m_device_id, m_device_connected);
@@ -48,19 +71,55 @@ void RGBDCameraClient::start_stream() {
 	if (m_device_connected && !m_device_streaming && m_output_file_loaded) {
 	
 		// setting the base recording configurations
+		// (playback files provide the streams they were recorded with)
+		// (in preview mode, only the color stream is opened with the negotiated preview profile)
 		m_camera_cfg = rs2::config();
-		m_camera_cfg.enable_stream(RS2_STREAM_COLOR, RGB_WIDTH, RGB_HEIGHT, RS2_FORMAT_BGR8, RGB_FPS);
-		m_camera_cfg.enable_stream(RS2_STREAM_DEPTH, DEPTH_WIDTH, DEPTH_HEIGHT, RS2_FORMAT_Z16, DEPTH_FPS);
+		if (!m_playback_file_str.empty()) {
+			m_camera_cfg.enable_device_from_file(m_playback_file_str, false);
+		} else if (!m_stream_preview || !configure_preview_stream()) {
+			m_camera_cfg.enable_stream(RS2_STREAM_COLOR, RGB_WIDTH, RGB_HEIGHT, RS2_FORMAT_BGR8, RGB_FPS);
+			m_camera_cfg.enable_stream(RS2_STREAM_DEPTH, DEPTH_WIDTH, DEPTH_HEIGHT, RS2_FORMAT_Z16, DEPTH_FPS);
+		}
 
-		// preview mode does not record the camera images
+		// preview mode does not record the camera images (playback files are never re-recorded to .bag)
 		if (!m_stream_preview && !m_pass_through) {
-			m_camera_cfg.enable_record_to_file(m_output_file_str);
-			m_output_index_file.open(m_output_index_file_str, std::fstream::app);
+			if (m_compressed_recording) {
+				if (!m_compressed_recorder.start(m_compressed_output_file_str, m_encoder_threads, m_jpeg_quality)) {
+					write_debug_output("RGBDCameraClient - failed to start the compressed recording");
+				}
+			} else if (m_playback_file_str.empty()) {
+				m_camera_cfg.enable_record_to_file(m_output_file_str);
+			}
+			m_output_index.open(m_output_index_file_str);
 		} 
 
 		// starting the acquisition pipeline
 		m_camera_pipe = rs2::pipeline();
 		m_camera_pipe.start(m_camera_cfg);
+
+		// setting the playback speed
+		if (!m_playback_file_str.empty()) {
+			rs2::playback playback_device = m_camera_pipe.get_active_profile().get_device().as<rs2::playback>();
+			playback_device.set_real_time(m_playback_real_time);
+		}
+
+		// live camera frames are timestamped in the global (host synchronized) time domain, when supported
+		else {
+			for (rs2::sensor& sensor : m_camera_pipe.get_active_profile().get_device().query_sensors()) {
+				if (sensor.supports(RS2_OPTION_GLOBAL_TIME_ENABLED)) sensor.set_option(RS2_OPTION_GLOBAL_TIME_ENABLED, 1.f);
+			}
+		}
+
+		m_n_received_frames = 0;
+		m_output_index.reset_drop_accounting();
+		m_stream_start_time = std::chrono::high_resolution_clock::now();
+
+		// launching the processing / redis publication (if redis enabled, not in preview mode)
+		m_process_data = m_redis_state && !m_stream_preview;
+		if (m_process_data) {
+			configure_processing();
+			m_processing_thread = std::thread(&RGBDCameraClient::process_camera_data, this);
+		}
 		
 		// launching the image emitting / indexing
 		// camera images are only sent to the UI in preview mode
@@ -81,14 +140,47 @@ void RGBDCameraClient::stop_stream() {
 		// stoping the data image emitting thread, in preview mode
 		m_collect_data = false;
 		m_collection_thread.join();
+
+		// stoping the processing thread (the remaining frameset is discarded)
+		if (m_process_data) {
+			m_process_data = false;
+			m_processing_thread.join();
+			disconnect_from_redis();
+			write_debug_output("RGBDCameraClient - published " + QString::number(m_n_processed_frames) + " of "
+				+ QString::number(m_n_handed_frames) + " framesets handed over for processing");
+			if (m_n_pointclouds > 0) {
+				write_debug_output("RGBDCameraClient - generated " + QString::number(m_n_pointclouds) + " point clouds, average time (us) : "
+					+ QString::number(m_pointcloud_time_us / m_n_pointclouds) + ", average points : " 
+					+ QString::number(m_n_pointcloud_points / m_n_pointclouds) + ", throughput (points / s) : "
+					+ QString::number(m_pointcloud_time_us ? m_n_pointcloud_points * 1000000.0 / m_pointcloud_time_us : 0.0));
+			}
+		}
 		
 		// stoping the acquisition pipeline
 		m_camera_pipe.stop();
 
 		// closing the output index
-		if (!m_stream_preview) {
-			m_output_index_file.close();
+		m_output_index.close();
+
+		// finishing the compressed recording (remaining framesets are encoded before returning)
+		if (m_compressed_recorder.is_recording()) {
+			m_compressed_recorder.stop();
+			uint64_t n_written_bytes = m_compressed_recorder.get_n_written_bytes();
+			write_debug_output("RGBDCameraClient - compressed recording, written framesets : " 
+				+ QString::number(m_compressed_recorder.get_n_written_framesets()) + ", dropped framesets : "
+				+ QString::number(m_compressed_recorder.get_n_dropped_framesets()) + ", compression ratio : "
+				+ QString::number(n_written_bytes ? (double) m_compressed_recorder.get_n_raw_bytes() / n_written_bytes : 0.0));
+		}
+
+		// reporting the throughput
+		auto stream_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::high_resolution_clock::now() - m_stream_start_time).count();
+		if (stream_time_ms > 0) {
+			write_debug_output("RGBDCameraClient - received " + QString::number(m_n_received_frames) + " frames in "
+				+ QString::number(stream_time_ms) + " ms (" + QString::number(m_n_received_frames * 1000.0 / stream_time_ms) + " fps)");
 		}
+		write_debug_output("RGBDCameraClient - dropped frames, color : " + QString::number(m_output_index.get_dropped_color_frames())
+			+ ", depth : " + QString::number(m_output_index.get_dropped_depth_frames()));
 
 		m_device_streaming = false;
 
@@ -104,13 +196,11 @@ void RGBDCameraClient::set_output_file(const std::string& output_folder_path) {
 
 		// defining output files
 		m_output_file_str = output_folder_path + "/RGBD_camera_data.bag";
-		m_output_index_file_str = output_folder_path + "/RGBD_camera_index.csv";
-		if (m_output_index_file.is_open()) m_output_index_file.close();
+		m_output_index_file_str = output_folder_path + "/RGBD_camera_index.bin";
+		m_compressed_output_file_str = output_folder_path + "/RGBD_camera_data.rgbd";
 
-		// defining the index file header
-		m_output_index_file.open(m_output_index_file_str);
-		m_output_index_file << "Time (us)" << std::endl;
-		m_output_index_file.close();
+		// writing the index file header
+		if (!m_output_index.create(m_output_index_file_str)) throw std::runtime_error("index creation failed");
 		
 		m_output_file_loaded = true;
 
@@ -124,47 +214,250 @@ void RGBDCameraClient::set_output_file(const std::string& output_folder_path) {
 * DATA COLLECTION FUNCTIONS
 ******************************************************************************/
 
+void RGBDCameraClient::configure_playback(void) {
+
+	try {
+		m_playback_file_str = (*m_config_ptr)["rgbd_playback_file"];
+		m_playback_real_time = (*m_config_ptr)["rgbd_playback_real_time"] != "false";
+	} catch (...) {
+		m_playback_file_str = "";
+		m_playback_real_time = true;
+	}
+
+}
+
+bool RGBDCameraClient::configure_preview_stream(void) {
+
+	try {
+
+		// listing the native color modes of the camera
+		std::vector<SensorMode> modes;
+		rs2::context ctx;
+		rs2::device_list devices = ctx.query_devices();
+		if (devices.size() == 0) return false;
+
+		for (rs2::sensor& sensor : devices[0].query_sensors()) {
+			for (rs2::stream_profile& profile : sensor.get_stream_profiles()) {
+				if (profile.stream_type() == RS2_STREAM_COLOR && profile.format() == RS2_FORMAT_BGR8 && profile.is<rs2::video_stream_profile>()) {
+					rs2::video_stream_profile video_profile = profile.as<rs2::video_stream_profile>();
+					modes.push_back({video_profile.width(), video_profile.height(), video_profile.fps()});
+				}
+			}
+		}
+
+		// opening the color stream with the lowest mode fitting the preview profile
+		int mode_index = select_preview_mode(modes, m_preview_width, m_preview_height, m_preview_fps);
+		if (mode_index == -1) return false;
+
+		const SensorMode& mode = modes[mode_index];
+		m_camera_cfg.enable_stream(RS2_STREAM_COLOR, mode.width, mode.height, RS2_FORMAT_BGR8, mode.fps);
+		write_debug_output("RGBDCameraClient - preview mode : " + QString::number(mode.width) + "x" 
+			+ QString::number(mode.height) + " @ " + QString::number(mode.fps) + " fps");
+
+		return true;
+
+	} catch (...) {
+		write_debug_output("RGBDCameraClient - failed to negotiate the preview mode");
+		return false;
+	}
+
+}
+
+void RGBDCameraClient::configure_processing(void) {
+
+	m_redis_color_entry = (*m_config_ptr)["rgbd_color_redis_entry"];
+	m_redis_depth_entry = (*m_config_ptr)["rgbd_depth_redis_entry"];
+	m_processing_rate_div = std::max(1, std::atoi((*m_config_ptr)["rgbd_redis_rate_div"].c_str()));
+
+	// the rate division is done before processing, every call to the redis writting functions is a publication
+	m_redis_rate_div = 1;
+
+	// point cloud configurations
+	m_pointcloud_active = (*m_config_ptr)["rgbd_pointcloud_active"] == "true";
+	m_redis_pointcloud_entry = (*m_config_ptr)["rgbd_pointcloud_redis_entry"];
+	m_pointcloud_rate_div = std::max(1, std::atoi((*m_config_ptr)["rgbd_pointcloud_rate_div"].c_str()));
+	m_pointcloud_voxel_size = static_cast<float>(std::atof((*m_config_ptr)["rgbd_pointcloud_voxel_size"].c_str()));
+
+	connect_to_redis({m_redis_color_entry, m_redis_depth_entry, m_redis_pointcloud_entry});
+
+	// resetting the depth filters (the temporal filter keeps the history of the previous stream)
+	int decimation = RGBD_DEFAULT_DECIMATION;
+	try {
+		decimation = std::stoi((*m_config_ptr)["rgbd_decimation_magnitude"]);
+	} catch (...) {}
+	m_decimation_filter = rs2::decimation_filter();
+	m_decimation_filter.set_option(RS2_OPTION_FILTER_MAGNITUDE, static_cast<float>(std::max(1, decimation)));
+	m_spatial_filter = rs2::spatial_filter();
+	m_temporal_filter = rs2::temporal_filter();
+
+	m_n_handed_frames = 0;
+	m_n_processed_frames = 0;
+	m_n_pointclouds = 0;
+	m_n_pointcloud_points = 0;
+	m_pointcloud_time_us = 0;
+
+}
+
+void RGBDCameraClient::configure_recording(void) {
+
+	try {
+		m_compressed_recording = (*m_config_ptr)["rgbd_compressed_recording"] == "true";
+		m_encoder_threads = std::stoi((*m_config_ptr)["rgbd_encoder_threads"]);
+		m_jpeg_quality = std::stoi((*m_config_ptr)["rgbd_jpeg_quality"]);
+	} catch (...) {
+		m_encoder_threads = 0;
+		m_jpeg_quality = RGBD_DEFAULT_JPEG_QUALITY;
+	}
+
+}
+
 void RGBDCameraClient::collect_camera_data(void) {
 
-	void* frame_data_p = nullptr;
+	rs2::frameset frames;
 
-	// defining QImage for writting
-	int resized_w = RGB_WIDTH / CAMERA_DISPLAY_RESIZE_FACTOR;
-	int resized_h = RGB_HEIGHT / CAMERA_DISPLAY_RESIZE_FACTOR;
-	QImage q_image(resized_w, resized_h, QImage::Format_RGB888);
+	// preview image (sized once the dimensions of the color frames are known)
+	QImage q_image;
+	auto preview_period = std::chrono::milliseconds(1000 / m_preview_fps);
+	auto last_preview_time = std::chrono::steady_clock::now() - preview_period;
 
 	while (m_collect_data) {
 
-		// grabbing the color image from the camera
-		frame_data_p = (void*)m_camera_pipe.wait_for_frames().get_color_frame().get_data();
+		// grabbing the color image from the camera (or the playback file)
+		if (!m_camera_pipe.try_wait_for_frames(&frames, CAMERA_FRAME_TIMEOUT_MS)) {
+
+			// the end of a playback file ends the data collection
+			if (!m_playback_file_str.empty()) {
+				rs2::playback playback_device = m_camera_pipe.get_active_profile().get_device().as<rs2::playback>();
+				if (playback_device.current_status() == RS2_PLAYBACK_STATUS_STOPPED) {
+					write_debug_output("RGBDCameraClient - reached the end of the playback file");
+					break;
+				}
+			}
+
+			continue;
 
-		// displaying images in preview mode
-		if (m_stream_preview) {
+		}
+
+		long long reception_time = get_micro_timestamp_count();
+		m_n_received_frames++;
+
+		// indexing received images (records are only written in main mode, when the index is open)
+		// dropped frames are counted in all modes
+		m_output_index.add_frames(frames, reception_time);
+
+		// handing the frameset to the compressed recording encoders (never blocks)
+		if (m_compressed_recorder.is_recording()) m_compressed_recorder.enqueue(frames);
+
+		// handing the frameset to the processing thread (never blocks, unprocessed framesets are replaced)
+		if (m_process_data && (m_n_received_frames % m_processing_rate_div) == 0) {
+			m_processing_queue.enqueue(frames);
+			m_n_handed_frames++;
+		}
+
+		// displaying images in preview mode, at the preview rate
+		// (frames are consumed as they arrive, so that they do not pile up in the librealsense queue)
+		rs2::video_frame color_frame_rs = frames.get_color_frame();
+		auto current_time = std::chrono::steady_clock::now();
+		if (m_stream_preview && color_frame_rs && (current_time - last_preview_time) >= preview_period) {
 		
-			// converting captured frame to opencv Mat
-			cv::Mat color_frame(cv::Size(RGB_WIDTH, RGB_HEIGHT), CV_8UC3, frame_data_p, cv::Mat::AUTO_STEP);
+			last_preview_time = current_time;
+
+			// converting captured frame to opencv Mat (the negotiated mode / playback files define the resolution)
+			cv::Mat color_frame(cv::Size(color_frame_rs.get_width(), color_frame_rs.get_height()), CV_8UC3,
+				(void*)color_frame_rs.get_data(), cv::Mat::AUTO_STEP);
+
+			cv::Size preview_size = get_preview_display_size(color_frame.cols, color_frame.rows);
+			if (q_image.width() != preview_size.width || q_image.height() != preview_size.height) {
+				q_image = QImage(preview_size.width, preview_size.height, QImage::Format_RGB888);
+			}
 
 			// resizing the captured frame and binding to the Qimage
-			cv::Mat resized_color_frame(resized_h, resized_w, CV_8UC3, q_image.bits(), q_image.bytesPerLine());
-			cv::resize(color_frame, resized_color_frame, resized_color_frame.size(), 0, 0, cv::INTER_AREA);
-			cv::cvtColor(resized_color_frame, resized_color_frame, CV_BGR2RGB);
+			cv::Mat resized_color_frame(preview_size, CV_8UC3, q_image.bits(), q_image.bytesPerLine());
+			if (color_frame.size() == preview_size) {
+				cv::cvtColor(color_frame, resized_color_frame, CV_BGR2RGB);
+			} else {
+				cv::resize(color_frame, resized_color_frame, preview_size, 0, 0, cv::INTER_AREA);
+				cv::cvtColor(resized_color_frame, resized_color_frame, CV_BGR2RGB);
+			}
 
-			// emiting the frame and waiting 
 			emit new_video_frame(q_image.copy());
-			std::this_thread::sleep_for(std::chrono::milliseconds(CAMERA_DISPLAY_THREAD_DELAY_MS));
 
 		}
+		
+	}
 
-		// main mode
-		else {
+}
+
+void RGBDCameraClient::process_camera_data(void) {
+
+	rs2::frame frame;
+
+	while (m_process_data) {
+
+		if (!m_processing_queue.try_wait_for_frame(&frame, RGBD_PROCESSING_WAIT_MS)) continue;
+
+		try {
 
-			// indexing received images in main mode
-			if (!m_pass_through) {
-				m_output_index_file << get_micro_timestamp() << "\n";
+			// filtering the depth frame (in the disparity domain)
+			rs2::frameset filtered_frames = frame.apply_filter(m_decimation_filter)
+				.apply_filter(m_depth_to_disparity)
+				.apply_filter(m_spatial_filter)
+				.apply_filter(m_temporal_filter)
+				.apply_filter(m_disparity_to_depth);
+
+			// generating the point cloud from the filtered depth (before alignment, in the depth camera coordinates)
+			if (m_pointcloud_active && (m_n_processed_frames % m_pointcloud_rate_div) == 0) {
+				publish_pointcloud(filtered_frames.get_depth_frame());
 			}
 
+			// aligning the depth frame to the color frame
+			rs2::frameset frames = filtered_frames.apply_filter(m_depth_to_color);
+
+			rs2::video_frame color_frame = frames.get_color_frame();
+			rs2::depth_frame depth_frame = frames.get_depth_frame();
+			if (!color_frame || !depth_frame) continue;
+
+			// downscaling the images (depth values are not interpolated)
+			cv::Mat color_mat(cv::Size(color_frame.get_width(), color_frame.get_height()), CV_8UC3,
+				(void*)color_frame.get_data(), cv::Mat::AUTO_STEP);
+			cv::Mat depth_mat(cv::Size(depth_frame.get_width(), depth_frame.get_height()), CV_16UC1,
+				(void*)depth_frame.get_data(), cv::Mat::AUTO_STEP);
+
+			cv::Mat redis_color_mat, redis_depth_mat;
+			cv::Size redis_img_size(color_mat.cols / RGBD_REDIS_RESIZE_FACTOR, color_mat.rows / RGBD_REDIS_RESIZE_FACTOR);
+			cv::resize(color_mat, redis_color_mat, redis_img_size, 0, 0, cv::INTER_AREA);
+			cv::resize(depth_mat, redis_depth_mat, redis_img_size, 0, 0, cv::INTER_NEAREST);
+
+			write_img_to_redis(m_redis_color_entry, redis_color_mat);
+			write_img_to_redis(m_redis_depth_entry, redis_depth_mat);
+			m_n_processed_frames++;
+
+		} catch (...) {
+			write_debug_output("RGBDCameraClient - failed to process a frameset");
 		}
-		
+
+	}
+
+}
+
+void RGBDCameraClient::publish_pointcloud(const rs2::depth_frame& depth_frame) {
+
+	if (!depth_frame) return;
+
+	auto start_time = std::chrono::high_resolution_clock::now();
+
+	m_pointcloud_generator.set_intrinsics(depth_frame.get_profile().as<rs2::video_stream_profile>().get_intrinsics());
+	size_t n_points = m_pointcloud_generator.generate(static_cast<const uint16_t*>(depth_frame.get_data()), depth_frame.get_stride_in_bytes(),
+		depth_frame.get_units(), m_pointcloud_voxel_size, m_pointcloud_xyz);
+
+	m_pointcloud_time_us += std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::high_resolution_clock::now() - start_time).count();
+	m_n_pointcloud_points += n_points;
+	m_n_pointclouds++;
+
+	// publishing the packed (x, y, z) float coordinates
+	if (n_points > 0) {
+		write_img_to_redis(m_redis_pointcloud_entry, cv::Mat(static_cast<int>(n_points), 1, CV_32FC3, m_pointcloud_xyz.data()));
 	}
 
 }
\ No newline at end of file
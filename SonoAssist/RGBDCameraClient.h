@@ -1,11 +1,15 @@
 #pragma once
 
 #include "SensorDevice.h"
+#include "RGBDFrameIndex.h"
+#include "RGBDRecorder.h"
+#include "PointCloudGenerator.h"
 
 #include <string>
 #include <thread>
 #include <chrono>
 #include <fstream>
+#include <algorithm>
 
 #include <opencv2/opencv.hpp>
 #include <librealsense2/rs.hpp>
@@ -20,12 +24,38 @@
 #define DEPTH_HEIGHT 720
 #define N_SKIP_FRAMES 30
 
-// resize factor to fit a target display of (360 x 640) px
-#define CAMERA_DISPLAY_RESIZE_FACTOR 3
-#define CAMERA_DISPLAY_THREAD_DELAY_MS 150
+// timeout when waiting for frames (live camera or playback file)
+#define CAMERA_FRAME_TIMEOUT_MS 5000
+
+// resize factor of the images published to redis (480 x 270 px for the default color resolution)
+#define RGBD_REDIS_RESIZE_FACTOR 4
+#define RGBD_DEFAULT_DECIMATION 2
+#define RGBD_PROCESSING_WAIT_MS 100
 
 /**
 * Class to enable communication with the Intel Realsens D435 camera
+*
+* When the (rgbd_playback_file) parameter points to a recorded .bag file, the client replays that file instead of
+* connecting to the camera (no recording of the .bag file in that case, the index is still written).
+*
+* The frame index (RGBD_camera_index.bin) is a binary, memory mappable file holding the frame numbers, device timestamps
+* and OS reception time of every frameset along with the running count of dropped frames (see RGBDFrameIndex).
+* The (rgbd_playback_real_time) parameter selects real time or maximum speed playback.
+*
+* In preview mode (live camera), only the color stream is opened, with the lowest native mode fitting the preview profile.
+*
+* When (rgbd_compressed_recording) is "true", the framesets are written to a compressed recording (RGBD_camera_data.rgbd,
+* JPEG color + lossless RVL depth, see RGBDRecorder) instead of the .bag file. This is also available in playback mode.
+*
+* When redis output is enabled (rgbd_to_redis), a processing thread filters the depth frames (decimation, spatial and
+* temporal filters), aligns them to the color frames and publishes the downscaled color (CV_8UC3) and depth (CV_16UC1)
+* images once every (rgbd_redis_rate_div) framesets. Only the latest frameset is kept for processing,
+* the collection (and recording) of the frames is never delayed by the processing.
+*
+* When (rgbd_pointcloud_active) is "true", the processing thread also converts the filtered depth frames into point clouds
+* (see PointCloudGenerator) once every (rgbd_pointcloud_rate_div) processed framesets, optionally downsampled with
+* (rgbd_pointcloud_voxel_size) meter voxels. The packed float (x, y, z) coordinates are published to redis.
+* The generation throughput is reported when the stream stops (a .bag file in playback mode gives repeatable measures).
 */
 class RGBDCameraClient : public SensorDevice {
 
@@ -52,18 +82,93 @@ class RGBDCameraClient : public SensorDevice {
 		*/
 		void collect_camera_data(void);
 
+		/**
+		* Filters, aligns and publishes (to redis) the latest framesets handed over by the collection thread.
+		* This function is meant to be executed in a seperate thread.
+		*/
+		void process_camera_data(void);
+
+		/**
+		* Generates the point cloud of the provided depth frame and publishes it to redis.
+		*/
+		void publish_pointcloud(const rs2::depth_frame& depth_frame);
+
+		/**
+		* Loads the redis output and processing configurations
+		*/
+		void configure_processing(void);
+
+		/**
+		* Enables the color stream with the lowest native mode fitting the preview profile (see SensorDevice).
+		*
+		* \return (false) if the camera modes could not be queried.
+		*/
+		bool configure_preview_stream(void);
+
+		/**
+		* Loads the playback configurations ((m_playback_file_str) is empty for a live camera)
+		*/
+		void configure_playback(void);
+
+		/**
+		* Loads the compressed recording configurations
+		*/
+		void configure_recording(void);
+
 		// camera communication vars
 		rs2::config m_camera_cfg;
 		rs2::pipeline m_camera_pipe;
 
+		// playback vars
+		bool m_playback_real_time = true;
+		std::string m_playback_file_str = "";
+
+		// throughput stats vars
+		long long m_n_received_frames = 0;
+		std::chrono::high_resolution_clock::time_point m_stream_start_time;
+
 		// streaming vars
 		bool m_collect_data = false;
 		std::thread m_collection_thread;
 
+		// processing vars (redis output)
+		bool m_process_data = false;
+		std::thread m_processing_thread;
+		int m_processing_rate_div = 1;
+		long long m_n_processed_frames = 0;
+		long long m_n_handed_frames = 0;
+		std::string m_redis_color_entry;
+		std::string m_redis_depth_entry;
+		rs2::frame_queue m_processing_queue = rs2::frame_queue(1, true);
+		rs2::decimation_filter m_decimation_filter;
+		rs2::disparity_transform m_depth_to_disparity = rs2::disparity_transform(true);
+		rs2::disparity_transform m_disparity_to_depth = rs2::disparity_transform(false);
+		rs2::spatial_filter m_spatial_filter;
+		rs2::temporal_filter m_temporal_filter;
+		rs2::align m_depth_to_color = rs2::align(RS2_STREAM_COLOR);
+
+		// point cloud vars
+		bool m_pointcloud_active = false;
+		int m_pointcloud_rate_div = 1;
+		float m_pointcloud_voxel_size = 0;
+		std::string m_redis_pointcloud_entry;
+		std::vector<float> m_pointcloud_xyz;
+		PointCloudGenerator m_pointcloud_generator;
+		long long m_n_pointclouds = 0;
+		long long m_n_pointcloud_points = 0;
+		long long m_pointcloud_time_us = 0;
+
+		// compressed recording vars
+		int m_encoder_threads = 0;
+		int m_jpeg_quality = RGBD_DEFAULT_JPEG_QUALITY;
+		bool m_compressed_recording = false;
+		RGBDRecorder m_compressed_recorder;
+
 		// output file vars
 		bool m_output_file_loaded = false;
-		std::ofstream m_output_index_file;
+		RGBDFrameIndex m_output_index;
 		std::string m_output_file_str = "";
+		std::string m_compressed_output_file_str = "";
 		std::string m_output_index_file_str = "";
 
 	signals:
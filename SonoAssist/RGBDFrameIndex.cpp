@@ -0,0 +1,107 @@
+#include "RGBDFrameIndex.h"
+
+/*******************************************************************************
+* FILE HANDLING
+******************************************************************************/
+
+bool RGBDFrameIndex::create(const std::string& index_file_path) {
+
+	if (m_index_file.is_open()) m_index_file.close();
+
+	RGBDIndexHeader header;
+	std::memcpy(header.magic, RGBD_INDEX_MAGIC, sizeof(header.magic));
+	header.version = RGBD_INDEX_VERSION;
+	header.record_size = sizeof(RGBDIndexRecord);
+
+	m_index_file.open(index_file_path, std::fstream::binary | std::fstream::trunc);
+	m_index_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	bool created = m_index_file.good();
+	m_index_file.close();
+
+	return created;
+
+}
+
+bool RGBDFrameIndex::open(const std::string& index_file_path) {
+
+	if (m_index_file.is_open()) m_index_file.close();
+
+	m_index_file.open(index_file_path, std::fstream::binary | std::fstream::app);
+	return m_index_file.is_open();
+
+}
+
+void RGBDFrameIndex::close(void) {
+	if (m_index_file.is_open()) m_index_file.close();
+}
+
+bool RGBDFrameIndex::is_open(void) const {
+	return m_index_file.is_open();
+}
+
+/*******************************************************************************
+* FRAME INDEXING & DROP ACCOUNTING
+******************************************************************************/
+
+void RGBDFrameIndex::reset_drop_accounting(void) {
+
+	for (StreamTracker* tracker : {&m_color_tracker, &m_depth_tracker}) {
+		tracker->started = false;
+		tracker->last_frame_number = 0;
+		tracker->dropped_frames = 0;
+	}
+
+}
+
+void RGBDFrameIndex::add_frames(const rs2::frameset& frames, int64_t host_time_us) {
+
+	RGBDIndexRecord record = {};
+	record.host_time_us = host_time_us;
+	record.color_hw_timestamp_us = -1;
+	record.depth_hw_timestamp_us = -1;
+
+	process_frame(frames.get_color_frame(), m_color_tracker, record.color_frame_number, record.color_timestamp_ms,
+		record.color_hw_timestamp_us, record.color_timestamp_domain, record.color_dropped_frames);
+	process_frame(frames.get_depth_frame(), m_depth_tracker, record.depth_frame_number, record.depth_timestamp_ms,
+		record.depth_hw_timestamp_us, record.depth_timestamp_domain, record.depth_dropped_frames);
+
+	if (m_index_file.is_open()) {
+		m_index_file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+	}
+
+}
+
+void RGBDFrameIndex::process_frame(const rs2::frame& frame, StreamTracker& tracker, uint64_t& frame_number,
+	double& timestamp_ms, int64_t& hw_timestamp_us, uint32_t& timestamp_domain, uint32_t& dropped_frames) {
+
+	if (frame) {
+
+		frame_number = frame.get_frame_number();
+		timestamp_ms = frame.get_timestamp();
+		timestamp_domain = static_cast<uint32_t>(frame.get_frame_timestamp_domain());
+		if (frame.supports_frame_metadata(RS2_FRAME_METADATA_FRAME_TIMESTAMP)) {
+			hw_timestamp_us = frame.get_frame_metadata(RS2_FRAME_METADATA_FRAME_TIMESTAMP);
+		}
+
+		// gaps in the frame numbers are counted as dropped frames
+		if (tracker.started && (frame_number > tracker.last_frame_number + 1)) {
+			tracker.dropped_frames += static_cast<uint32_t>(frame_number - tracker.last_frame_number - 1);
+		}
+		if (!tracker.started || frame_number > tracker.last_frame_number) {
+			tracker.last_frame_number = frame_number;
+		}
+		tracker.started = true;
+
+	}
+
+	dropped_frames = tracker.dropped_frames;
+
+}
+
+uint32_t RGBDFrameIndex::get_dropped_color_frames(void) const {
+	return m_color_tracker.dropped_frames;
+}
+
+uint32_t RGBDFrameIndex::get_dropped_depth_frames(void) const {
+	return m_depth_tracker.dropped_frames;
+}
\ No newline at end of file
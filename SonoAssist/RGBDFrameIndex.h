@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+#include <librealsense2/rs.hpp>
+
+#define RGBD_INDEX_MAGIC "SARGBDIX"
+#define RGBD_INDEX_VERSION 1
+
+/**
+* Header of the binary RGBD frame index file (16 bytes, little endian)
+*/
+struct RGBDIndexHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t record_size;
+};
+
+/**
+* Record of the binary RGBD frame index file (72 bytes, little endian), one per received frameset.
+* Frame numbers link the record to the frames stored in the .bag recording.
+* Hardware timestamps are set to -1 when the frame metadata is not available.
+* Dropped frame counts are cumulative since the start of the acquisition.
+*/
+struct RGBDIndexRecord {
+	int64_t host_time_us;
+	uint64_t color_frame_number;
+	uint64_t depth_frame_number;
+	double color_timestamp_ms;
+	double depth_timestamp_ms;
+	int64_t color_hw_timestamp_us;
+	int64_t depth_hw_timestamp_us;
+	uint32_t color_timestamp_domain;
+	uint32_t depth_timestamp_domain;
+	uint32_t color_dropped_frames;
+	uint32_t depth_dropped_frames;
+};
+
+static_assert(sizeof(RGBDIndexHeader) == 16, "unexpected RGBD index header size");
+static_assert(sizeof(RGBDIndexRecord) == 72, "unexpected RGBD index record size");
+
+/**
+* Class writing the binary (memory mappable) RGBD frame index and keeping track of dropped frames.
+*
+* The index file is made of a (RGBDIndexHeader) followed by fixed size (RGBDIndexRecord) entries.
+* Dropped frames are detected per stream, from gaps in the frame numbers.
+*/
+class RGBDFrameIndex {
+
+	public:
+
+		RGBDFrameIndex() {}
+
+		/**
+		* Creates (or truncates) the index file and writes its header.
+		*
+		* \param index_file_path The path to the index file.
+		* \return (true) if the file was created.
+		*/
+		bool create(const std::string& index_file_path);
+
+		/**
+		* Opens a previously created index file for the writing of records (append mode).
+		*/
+		bool open(const std::string& index_file_path);
+
+		void close(void);
+		bool is_open(void) const;
+
+		/**
+		* Resets the frame number tracking and the dropped frame counts (start of an acquisition).
+		*/
+		void reset_drop_accounting(void);
+
+		/**
+		* Updates the dropped frame counts with the provided frameset and, when the index file is open, writes its record.
+		*
+		* \param frames The received frameset.
+		* \param host_time_us The OS reception time of the frameset.
+		*/
+		void add_frames(const rs2::frameset& frames, int64_t host_time_us);
+
+		uint32_t get_dropped_color_frames(void) const;
+		uint32_t get_dropped_depth_frames(void) const;
+
+	private:
+
+		/**
+		* Per stream frame number tracking
+		*/
+		struct StreamTracker {
+			bool started = false;
+			uint64_t last_frame_number = 0;
+			std::atomic<uint32_t> dropped_frames = 0;
+		};
+
+		/**
+		* Fills the record fields of a single stream and updates its dropped frame count.
+		*/
+		static void process_frame(const rs2::frame& frame, StreamTracker& tracker, uint64_t& frame_number,
+			double& timestamp_ms, int64_t& hw_timestamp_us, uint32_t& timestamp_domain, uint32_t& dropped_frames);
+
+		std::ofstream m_index_file;
+
+		StreamTracker m_color_tracker;
+		StreamTracker m_depth_tracker;
+
+};
\ No newline at end of file
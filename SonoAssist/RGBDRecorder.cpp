@@ -0,0 +1,221 @@
+#include "RGBDRecorder.h"
+
+/*******************************************************************************
+* CONSTRUCTOR & DESTRUCTOR
+******************************************************************************/
+
+RGBDRecorder::~RGBDRecorder() {
+	stop();
+}
+
+/*******************************************************************************
+* RECORDING CONTROL
+******************************************************************************/
+
+bool RGBDRecorder::start(const std::string& recording_file_path, int n_threads, int jpeg_quality) {
+
+	if (m_recording) return false;
+
+	// creating the recording file
+	m_recording_file.open(recording_file_path, std::fstream::binary | std::fstream::trunc);
+	if (!m_recording_file.is_open()) return false;
+
+	RGBDRecordingHeader header;
+	std::memcpy(header.magic, RGBD_RECORDING_MAGIC, sizeof(header.magic));
+	header.version = RGBD_RECORDING_VERSION;
+	header.reserved = 0;
+	m_recording_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	// resetting the ordering and stats vars
+	m_jpeg_quality = jpeg_quality;
+	m_next_dequeue_sequence = 0;
+	m_next_write_sequence = 0;
+	m_pending_framesets.clear();
+	m_chunk_index.clear();
+	m_n_enqueued = 0;
+	m_n_written = 0;
+	m_n_raw_bytes = 0;
+	m_n_written_bytes = sizeof(header);
+
+	// launching the encoders
+	if (n_threads < 1) n_threads = std::thread::hardware_concurrency();
+	if (n_threads < 1) n_threads = 1;
+	m_recording = true;
+	for (auto i = 0; i < n_threads; i++) {
+		m_encoder_threads.emplace_back(&RGBDRecorder::encode_framesets, this);
+	}
+
+	return true;
+
+}
+
+void RGBDRecorder::stop(void) {
+
+	if (!m_recording) return;
+
+	// the encoders empty the queue before returning
+	m_recording = false;
+	for (auto& encoder_thread : m_encoder_threads) encoder_thread.join();
+	m_encoder_threads.clear();
+
+	// writing the frame index and the footer
+	RGBDRecordingFooter footer;
+	footer.index_offset = m_n_written_bytes;
+	footer.n_entries = m_chunk_index.size();
+	std::memcpy(footer.magic, RGBD_RECORDING_FOOTER_MAGIC, sizeof(footer.magic));
+
+	m_recording_file.write(reinterpret_cast<const char*>(m_chunk_index.data()), m_chunk_index.size() * sizeof(RGBDChunkIndexEntry));
+	m_recording_file.write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+	m_n_written_bytes += m_chunk_index.size() * sizeof(RGBDChunkIndexEntry) + sizeof(footer);
+	m_recording_file.close();
+
+}
+
+void RGBDRecorder::enqueue(const rs2::frameset& frames) {
+
+	if (m_recording) {
+
+		// the frames are held longer than the librealsense frame pool allows (up to the queue size)
+		rs2::frameset kept_frames = frames;
+		kept_frames.keep();
+
+		m_frame_queue.enqueue(kept_frames);
+		m_n_enqueued++;
+
+	}
+
+}
+
+/*******************************************************************************
+* GETTERS
+******************************************************************************/
+
+bool RGBDRecorder::is_recording(void) const {
+	return m_recording;
+}
+
+uint64_t RGBDRecorder::get_n_written_framesets(void) const {
+	return m_n_written;
+}
+
+uint64_t RGBDRecorder::get_n_dropped_framesets(void) const {
+	// only exact once the recording is stopped (no frameset left in the queue)
+	return m_n_enqueued - m_n_written;
+}
+
+uint64_t RGBDRecorder::get_n_raw_bytes(void) const {
+	return m_n_raw_bytes;
+}
+
+uint64_t RGBDRecorder::get_n_written_bytes(void) const {
+	return m_n_written_bytes;
+}
+
+/*******************************************************************************
+* ENCODING & WRITING
+******************************************************************************/
+
+void RGBDRecorder::encode_framesets(void) {
+
+	while (true) {
+
+		// pulling and numbering the next frameset
+		rs2::frame frame;
+		uint64_t sequence = 0;
+		bool frame_received = false;
+		{
+			std::lock_guard<std::mutex> dequeue_guard(m_dequeue_mtx);
+			frame_received = m_frame_queue.try_wait_for_frame(&frame, RGBD_RECORDER_WAIT_MS);
+			if (frame_received) sequence = m_next_dequeue_sequence++;
+		}
+
+		if (!frame_received) {
+			if (!m_recording) break;
+			continue;
+		}
+
+		// compressing the frameset (in parallel with the other encoders)
+		EncodedFrameset encoded;
+		try {
+			encode_frameset(rs2::frameset(frame), encoded);
+		} catch (...) {
+			encoded = EncodedFrameset();
+		}
+
+		// writing the framesets in arrival order
+		std::lock_guard<std::mutex> write_guard(m_write_mtx);
+		m_pending_framesets[sequence] = std::move(encoded);
+		write_pending_framesets();
+
+	}
+
+}
+
+void RGBDRecorder::write_pending_framesets(void) {
+
+	auto pending_it = m_pending_framesets.find(m_next_write_sequence);
+
+	while (pending_it != m_pending_framesets.end()) {
+
+		EncodedFrameset& encoded = pending_it->second;
+
+		// failed encodings are skipped (counted as dropped)
+		if (encoded.color_data.size() + encoded.depth_data.size() > 0) {
+
+			m_chunk_index.push_back({m_n_written_bytes, encoded.header.color_frame_number});
+
+			m_recording_file.write(reinterpret_cast<const char*>(&encoded.header), sizeof(encoded.header));
+			m_recording_file.write(reinterpret_cast<const char*>(encoded.color_data.data()), encoded.color_data.size());
+			m_recording_file.write(reinterpret_cast<const char*>(encoded.depth_data.data()), encoded.depth_data.size());
+
+			m_n_written_bytes += sizeof(encoded.header) + encoded.color_data.size() + encoded.depth_data.size();
+			m_n_written++;
+
+		}
+
+		m_pending_framesets.erase(pending_it);
+		pending_it = m_pending_framesets.find(++m_next_write_sequence);
+
+	}
+
+}
+
+void RGBDRecorder::encode_frameset(const rs2::frameset& frames, EncodedFrameset& encoded) {
+
+	RGBDChunkHeader& header = encoded.header;
+	header = {};
+
+	// color frame -> JPEG
+	rs2::video_frame color_frame = frames.get_color_frame();
+	if (color_frame && color_frame.get_bytes_per_pixel() == 3) {
+
+		cv::Mat color_mat(cv::Size(color_frame.get_width(), color_frame.get_height()), CV_8UC3,
+			(void*)color_frame.get_data(), color_frame.get_stride_in_bytes());
+		cv::imencode(".jpg", color_mat, encoded.color_data, {cv::IMWRITE_JPEG_QUALITY, m_jpeg_quality});
+
+		header.color_frame_number = color_frame.get_frame_number();
+		header.color_timestamp_ms = color_frame.get_timestamp();
+		header.color_width = static_cast<uint16_t>(color_frame.get_width());
+		header.color_height = static_cast<uint16_t>(color_frame.get_height());
+		header.color_size = static_cast<uint32_t>(encoded.color_data.size());
+		m_n_raw_bytes += color_frame.get_data_size();
+
+	}
+
+	// depth frame -> RVL (the pixel rows are contiguous for Z16 frames)
+	rs2::depth_frame depth_frame = frames.get_depth_frame();
+	if (depth_frame) {
+
+		size_t n_pixels = static_cast<size_t>(depth_frame.get_width()) * depth_frame.get_height();
+		rvl::compress(static_cast<const uint16_t*>(depth_frame.get_data()), n_pixels, encoded.depth_data);
+
+		header.depth_frame_number = depth_frame.get_frame_number();
+		header.depth_timestamp_ms = depth_frame.get_timestamp();
+		header.depth_width = static_cast<uint16_t>(depth_frame.get_width());
+		header.depth_height = static_cast<uint16_t>(depth_frame.get_height());
+		header.depth_size = static_cast<uint32_t>(encoded.depth_data.size());
+		m_n_raw_bytes += depth_frame.get_data_size();
+
+	}
+
+}
\ No newline at end of file
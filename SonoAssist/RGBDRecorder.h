@@ -0,0 +1,161 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <fstream>
+
+#include <opencv2/opencv.hpp>
+#include <librealsense2/rs.hpp>
+
+#include "RVLCodec.h"
+
+#define RGBD_RECORDING_MAGIC "SARGBDRC"
+#define RGBD_RECORDING_FOOTER_MAGIC "SARGBDFT"
+#define RGBD_RECORDING_VERSION 1
+
+#define RGBD_RECORDER_QUEUE_SIZE 60
+#define RGBD_RECORDER_WAIT_MS 50
+#define RGBD_DEFAULT_JPEG_QUALITY 90
+
+/**
+* Header of the compressed RGBD recording file (16 bytes, little endian)
+*/
+struct RGBDRecordingHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t reserved;
+};
+
+/**
+* Header of a frameset chunk (48 bytes, little endian), followed by the JPEG color data and the RVL depth data.
+* Missing streams have a size of 0.
+*/
+struct RGBDChunkHeader {
+	uint64_t color_frame_number;
+	uint64_t depth_frame_number;
+	double color_timestamp_ms;
+	double depth_timestamp_ms;
+	uint16_t color_width;
+	uint16_t color_height;
+	uint16_t depth_width;
+	uint16_t depth_height;
+	uint32_t color_size;
+	uint32_t depth_size;
+};
+
+/**
+* Entry of the frame index written at the end of the recording (16 bytes per frameset)
+*/
+struct RGBDChunkIndexEntry {
+	uint64_t chunk_offset;
+	uint64_t color_frame_number;
+};
+
+/**
+* Footer of the compressed RGBD recording file (24 bytes), gives the position of the frame index
+*/
+struct RGBDRecordingFooter {
+	uint64_t index_offset;
+	uint64_t n_entries;
+	char magic[8];
+};
+
+static_assert(sizeof(RGBDRecordingHeader) == 16, "unexpected RGBD recording header size");
+static_assert(sizeof(RGBDChunkHeader) == 48, "unexpected RGBD chunk header size");
+static_assert(sizeof(RGBDChunkIndexEntry) == 16, "unexpected RGBD index entry size");
+static_assert(sizeof(RGBDRecordingFooter) == 24, "unexpected RGBD recording footer size");
+
+/**
+* Compressed recording sink for the RGBD camera, alternative to the librealsense .bag recording.
+*
+* Framesets are pushed into an (rs2::frame_queue) and pulled by encoder threads which compress the color frame (JPEG)
+* and the depth frame (lossless RVL) in parallel. Chunks are written in arrival order and, when the recording stops,
+* a frame index (chunk offsets) and a footer are appended so that readers can seek to any frameset.
+* Framesets are dropped (and counted) when the encoders can not keep up, the caller is never blocked.
+*/
+class RGBDRecorder {
+
+	public:
+
+		RGBDRecorder() {}
+		~RGBDRecorder();
+
+		/**
+		* Creates the recording file and launches the encoder threads.
+		*
+		* \param recording_file_path The path to the recording file.
+		* \param n_threads The number of encoder threads (values below 1 select the number of hardware threads).
+		* \param jpeg_quality The JPEG quality of the color frames (0 - 100).
+		* \return (true) if the recording was started.
+		*/
+		bool start(const std::string& recording_file_path, int n_threads, int jpeg_quality = RGBD_DEFAULT_JPEG_QUALITY);
+
+		/**
+		* Encodes the framesets remaining in the queue, writes the frame index and closes the recording file.
+		*/
+		void stop(void);
+
+		/**
+		* Pushes a frameset in the encoding queue (non-blocking, the oldest frameset is dropped when the queue is full).
+		*/
+		void enqueue(const rs2::frameset& frames);
+
+		bool is_recording(void) const;
+		uint64_t get_n_written_framesets(void) const;
+		uint64_t get_n_dropped_framesets(void) const;
+		uint64_t get_n_raw_bytes(void) const;
+		uint64_t get_n_written_bytes(void) const;
+
+	private:
+
+		/**
+		* Compressed frameset, waiting to be written
+		*/
+		struct EncodedFrameset {
+			RGBDChunkHeader header;
+			std::vector<uint8_t> color_data;
+			std::vector<uint8_t> depth_data;
+		};
+
+		/**
+		* Pulls framesets from the queue and encodes them until the recording stops and the queue is empty.
+		* This method is meant to run in seperate threads.
+		*/
+		void encode_framesets(void);
+
+		/**
+		* Writes the encoded framesets that are next in the arrival order (called with m_write_mtx locked).
+		*/
+		void write_pending_framesets(void);
+
+		void encode_frameset(const rs2::frameset& frames, EncodedFrameset& encoded);
+
+		// encoding vars
+		int m_jpeg_quality = RGBD_DEFAULT_JPEG_QUALITY;
+		std::atomic<bool> m_recording = false;
+		std::vector<std::thread> m_encoder_threads;
+		rs2::frame_queue m_frame_queue = rs2::frame_queue(RGBD_RECORDER_QUEUE_SIZE, true);
+
+		// ordering vars (framesets are numbered when they are pulled from the queue)
+		std::mutex m_dequeue_mtx;
+		uint64_t m_next_dequeue_sequence = 0;
+
+		// writing vars
+		std::mutex m_write_mtx;
+		std::ofstream m_recording_file;
+		uint64_t m_next_write_sequence = 0;
+		std::map<uint64_t, EncodedFrameset> m_pending_framesets;
+		std::vector<RGBDChunkIndexEntry> m_chunk_index;
+
+		// stats vars
+		std::atomic<uint64_t> m_n_enqueued = 0;
+		std::atomic<uint64_t> m_n_written = 0;
+		std::atomic<uint64_t> m_n_raw_bytes = 0;
+		std::atomic<uint64_t> m_n_written_bytes = 0;
+
+};
\ No newline at end of file
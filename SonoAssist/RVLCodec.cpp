@@ -0,0 +1,165 @@
+#include "RVLCodec.h"
+
+#include <cstring>
+
+namespace rvl {
+
+	/*******************************************************************************
+	* NIBBLE WRITING & READING
+	******************************************************************************/
+
+	/**
+	* Packs variable length integers into 32 bit words
+	*/
+	class NibbleWriter {
+
+		public:
+
+			NibbleWriter(uint32_t* output_p) : m_output_p(output_p), m_start_p(output_p) {}
+
+			void write_vle(uint32_t value) {
+				do {
+					uint32_t nibble = value & 0x7;
+					value >>= 3;
+					if (value) nibble |= 0x8;
+					m_word = (m_word << 4) | nibble;
+					if (++m_n_nibbles == 8) {
+						*m_output_p++ = m_word;
+						m_n_nibbles = 0;
+						m_word = 0;
+					}
+				} while (value);
+			}
+
+			size_t flush(void) {
+				if (m_n_nibbles) {
+					*m_output_p++ = m_word << (4 * (8 - m_n_nibbles));
+					m_n_nibbles = 0;
+					m_word = 0;
+				}
+				return (m_output_p - m_start_p) * sizeof(uint32_t);
+			}
+
+		private:
+
+			uint32_t* m_output_p;
+			uint32_t* m_start_p;
+			uint32_t m_word = 0;
+			int m_n_nibbles = 0;
+
+	};
+
+	/**
+	* Reads variable length integers from 32 bit words
+	*/
+	class NibbleReader {
+
+		public:
+
+			NibbleReader(const uint8_t* input_p, size_t input_size) : m_input_p(input_p), m_n_words(input_size / sizeof(uint32_t)) {}
+
+			bool read_vle(uint32_t& value) {
+				value = 0;
+				int shift = 0;
+				uint32_t nibble;
+				do {
+					if (!m_n_nibbles) {
+						if (m_word_index == m_n_words) return false;
+						std::memcpy(&m_word, m_input_p + (m_word_index++ * sizeof(uint32_t)), sizeof(uint32_t));
+						m_n_nibbles = 8;
+					}
+					nibble = m_word >> 28;
+					value |= (nibble & 0x7) << shift;
+					m_word <<= 4;
+					m_n_nibbles--;
+					shift += 3;
+				} while ((nibble & 0x8) && (shift < 32));
+				return true;
+			}
+
+		private:
+
+			const uint8_t* m_input_p;
+			size_t m_n_words;
+			size_t m_word_index = 0;
+			uint32_t m_word = 0;
+			int m_n_nibbles = 0;
+
+	};
+
+	/*******************************************************************************
+	* CODEC
+	******************************************************************************/
+
+	size_t max_compressed_size(size_t n_pixels) {
+		// worst case : alternating valid / invalid pixels (2 run length nibbles + 6 value nibbles per valid pixel)
+		return (n_pixels * 4) + (2 * sizeof(uint32_t));
+	}
+
+	void compress(const uint16_t* input, size_t n_pixels, std::vector<uint8_t>& output) {
+
+		output.resize(max_compressed_size(n_pixels));
+		NibbleWriter writer(reinterpret_cast<uint32_t*>(output.data()));
+
+		const uint16_t* end_p = input + n_pixels;
+		int32_t previous = 0;
+
+		while (input != end_p) {
+
+			// run of invalid pixels
+			uint32_t n_zeros = 0;
+			for (; (input != end_p) && !*input; input++) n_zeros++;
+			writer.write_vle(n_zeros);
+
+			// run of valid pixels (zigzag mapped deltas)
+			uint32_t n_nonzeros = 0;
+			for (const uint16_t* p = input; (p != end_p) && *p; p++) n_nonzeros++;
+			writer.write_vle(n_nonzeros);
+
+			for (uint32_t i = 0; i < n_nonzeros; i++) {
+				int32_t current = *input++;
+				int32_t delta = current - previous;
+				writer.write_vle((static_cast<uint32_t>(delta) << 1) ^ static_cast<uint32_t>(delta >> 31));
+				previous = current;
+			}
+
+		}
+
+		output.resize(writer.flush());
+
+	}
+
+	bool decompress(const uint8_t* input, size_t input_size, uint16_t* output, size_t n_pixels) {
+
+		NibbleReader reader(input, input_size);
+		int32_t previous = 0;
+
+		while (n_pixels) {
+
+			// run of invalid pixels
+			uint32_t n_zeros = 0;
+			if (!reader.read_vle(n_zeros) || n_zeros > n_pixels) return false;
+			std::memset(output, 0, n_zeros * sizeof(uint16_t));
+			output += n_zeros;
+			n_pixels -= n_zeros;
+
+			// run of valid pixels
+			uint32_t n_nonzeros = 0;
+			if (!reader.read_vle(n_nonzeros) || n_nonzeros > n_pixels) return false;
+			n_pixels -= n_nonzeros;
+
+			for (uint32_t i = 0; i < n_nonzeros; i++) {
+				uint32_t positive = 0;
+				if (!reader.read_vle(positive)) return false;
+				int32_t delta = static_cast<int32_t>(positive >> 1) ^ -static_cast<int32_t>(positive & 1);
+				previous += delta;
+				*output++ = static_cast<uint16_t>(previous);
+			}
+
+		}
+
+		return true;
+
+	}
+
+}
\ No newline at end of file
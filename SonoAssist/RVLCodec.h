@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/**
+* Lossless compression of 16 bit depth images with the RVL (Run length / Variable Length) codec.
+* Reference : A. D. Wilson, "Fast Lossless Depth Image Compression", ISS 2017.
+*
+* Runs of zero (invalid) pixels are run length encoded. Valid pixels are delta coded against the previous valid pixel,
+* zigzag mapped and written as variable length integers (3 data bits + 1 continuation bit per nibble).
+* Nibbles are packed into 32 bit words, most significant nibble first.
+*/
+namespace rvl {
+
+	/**
+	* \return The maximum compressed size (bytes) of an image with (n_pixels) pixels.
+	*/
+	size_t max_compressed_size(size_t n_pixels);
+
+	/**
+	* Compresses the provided depth image.
+	*
+	* \param input The depth pixels.
+	* \param n_pixels The number of pixels in the image.
+	* \param output The compressed data, resized to the compressed size.
+	*/
+	void compress(const uint16_t* input, size_t n_pixels, std::vector<uint8_t>& output);
+
+	/**
+	* Decompresses an image compressed with (compress).
+	*
+	* \param input The compressed data.
+	* \param input_size The size (bytes) of the compressed data.
+	* \param output The destination of the depth pixels (n_pixels elements).
+	* \param n_pixels The number of pixels in the image.
+	* \return (false) if the compressed data is truncated.
+	*/
+	bool decompress(const uint8_t* input, size_t input_size, uint16_t* output, size_t n_pixels);
+
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+#define SPSC_CACHE_LINE_SIZE 64
+
+/**
+* Lock-free ring buffer for a single producer thread and a single consumer thread.
+*
+* Elements are copied in and out of a fixed array (no allocation after construction), which makes the
+* producer side safe to use in time critical callbacks. Pushing into a full buffer fails (the element is dropped).
+*
+* \tparam T The element type (trivially copyable).
+* \tparam Capacity The number of slots, a power of 2 (one slot is kept free to tell a full buffer from an empty one).
+*/
+template <typename T, size_t Capacity>
+class SPSCRingBuffer {
+
+	static_assert(std::is_trivially_copyable<T>::value, "SPSCRingBuffer elements must be trivially copyable");
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SPSCRingBuffer capacity must be a power of 2");
+
+	public:
+
+		SPSCRingBuffer() {}
+
+		SPSCRingBuffer(const SPSCRingBuffer&) = delete;
+		SPSCRingBuffer& operator=(const SPSCRingBuffer&) = delete;
+
+		/**
+		* Copies the element in the buffer (producer thread only).
+		*
+		* \return (false) if the buffer is full.
+		*/
+		bool try_push(const T& element) {
+
+			size_t head = m_head.load(std::memory_order_relaxed);
+			size_t next_head = (head + 1) & (Capacity - 1);
+			if (next_head == m_tail.load(std::memory_order_acquire)) return false;
+
+			m_elements[head] = element;
+			m_head.store(next_head, std::memory_order_release);
+			return true;
+
+		}
+
+		/**
+		* Copies up to (max_elements) of the oldest elements out of the buffer (consumer thread only).
+		*
+		* \return The number of elements copied into (elements).
+		*/
+		size_t pop_batch(T* elements, size_t max_elements) {
+
+			size_t tail = m_tail.load(std::memory_order_relaxed);
+			size_t head = m_head.load(std::memory_order_acquire);
+
+			size_t n_elements = 0;
+			while (tail != head && n_elements < max_elements) {
+				elements[n_elements++] = m_elements[tail];
+				tail = (tail + 1) & (Capacity - 1);
+			}
+
+			m_tail.store(tail, std::memory_order_release);
+			return n_elements;
+
+		}
+
+		/**
+		* \return (true) if the buffer holds no element (exact when called from the consumer thread).
+		*/
+		bool empty(void) const {
+			return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+		}
+
+	private:
+
+		// the indices are kept on seperate cache lines (no false sharing between the producer and the consumer)
+		alignas(SPSC_CACHE_LINE_SIZE) std::atomic<size_t> m_head = 0;
+		alignas(SPSC_CACHE_LINE_SIZE) std::atomic<size_t> m_tail = 0;
+		alignas(SPSC_CACHE_LINE_SIZE) T m_elements[Capacity];
+
+};
\ No newline at end of file
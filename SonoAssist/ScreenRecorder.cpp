@@ -8,6 +8,7 @@ ScreenRecorder::ScreenRecorder(int device_id, const std::string& device_descript
     const std::string& redis_state_entry, const std::string& log_file_path):
     SensorDevice(device_id, device_description, redis_state_entry, log_file_path) {
 
+    m_frame_pyramid_p = std::make_shared<FramePyramid>();
     initialize_capture();
 
 }
@@ -15,6 +16,7 @@ ScreenRecorder::ScreenRecorder(int device_id, const std::string& device_descript
 ScreenRecorder::~ScreenRecorder() {
 
     // releasing the window capture resources
+    release_preview_capture();
     DeleteObject(m_hbwindow);
     DeleteDC(m_hwindowCompatibleDC);
     ReleaseDC(m_window_handle, m_hwindowDC);
@@ -46,6 +48,9 @@ void ScreenRecorder::start_stream() {
 
     if (m_device_connected && !m_device_streaming && m_output_file_loaded) {
 
+        // preparing the capture at the preview dimensions
+        if (m_stream_preview) initialize_preview_capture();
+
         // opening output files
         m_output_index_file.open(m_output_index_file_str, std::fstream::app);
         m_video = cv::VideoWriter(m_output_video_file_str, CV_FOURCC('M', 'J', 'P', 'G'),
@@ -57,6 +62,15 @@ void ScreenRecorder::start_stream() {
             m_redis_rate_div = std::atoi((*m_config_ptr)["sc_redis_rate_div"].c_str());
             connect_to_redis({m_redis_img_entry});
         }
+
+        // creating the conversion thread pool (a value of 0 uses all hardware threads)
+        int n_threads = 0;
+        try {
+            n_threads = std::stoi((*m_config_ptr)["sc_n_threads"]);
+        } catch (...) {}
+        m_worker_pool_p = std::make_unique<WorkerPool>(n_threads);
+        m_conversion_time_us = 0;
+        m_n_conversions = 0;
         
         // launching the acquisition thread
         m_collect_data = true;
@@ -81,6 +95,18 @@ void ScreenRecorder::stop_stream() {
         m_output_index_file.close();
         disconnect_from_redis();
 
+        // releasing the latest capture
+        m_frame_pyramid_p->clear();
+        release_preview_capture();
+
+        // reporting the conversion performance and releasing the thread pool
+        if (m_n_conversions > 0) {
+            write_debug_output("ScreenRecorder - average conversion time (us) : " + QString::number(m_conversion_time_us / m_n_conversions)
+                + " with " + QString::number(m_worker_pool_p->get_n_threads()) + " thread(s) for "
+                + QString::number(m_window_rc.right) + "x" + QString::number(m_window_rc.bottom) + " captures");
+        }
+        m_worker_pool_p.reset();
+
     }
 
 }
@@ -151,38 +177,61 @@ void ScreenRecorder::initialize_capture(void) {
     // use the previously created device context with the bitmap
     SelectObject(m_hwindowCompatibleDC, m_hbwindow);
 
-    // defining the display dimensions
-    int preview_img_width = m_window_rc.right / SR_PREVIEW_RESIZE_FACTOR;
-    int preview_img_height = m_window_rc.bottom / SR_PREVIEW_RESIZE_FACTOR;
-
     // defining the redis img dimensions
     int redis_img_width = m_window_rc.right / REDIS_RESIZE_FACTOR;
     int redis_img_height = m_window_rc.bottom / REDIS_RESIZE_FACTOR;
 
     // initializing image handling containers
     m_capture_mat = cv::Mat(m_window_rc.bottom, m_window_rc.right, CV_8UC4);
-    m_capture_cvt_mat = cv::Mat(m_window_rc.bottom, m_window_rc.right, CV_8UC3);
-    m_preview_img = QImage(preview_img_width, preview_img_height, QImage::Format_RGB888);
-    m_preview_img_mat = cv::Mat(preview_img_height, preview_img_width,
-        CV_8UC3, m_preview_img.bits(), m_preview_img.bytesPerLine());
-    m_redis_img_mat = cv::Mat(redis_img_height, redis_img_width, CV_8UC3);
+    m_redis_img_size = cv::Size(redis_img_width, redis_img_height);
 
 }
 
-cv::Mat ScreenRecorder::get_lastest_acquisition(cv::Rect aoi) {
+void ScreenRecorder::initialize_preview_capture(void) {
 
-    cv::Mat latest_capture;
+    release_preview_capture();
+
+    // defining the preview dimensions (aspect ratio of the screen)
+    cv::Size preview_size = get_preview_display_size(m_window_rc.right, m_window_rc.bottom);
+
+    // create a bitmap (and its device context) to hold the downscaled window content
+    m_hpreviewCompatibleDC = CreateCompatibleDC(m_hwindowDC);
+    SetStretchBltMode(m_hpreviewCompatibleDC, HALFTONE);
+    SetBrushOrgEx(m_hpreviewCompatibleDC, 0, 0, NULL);
+    m_hbpreview = CreateCompatibleBitmap(m_hwindowDC, preview_size.width, preview_size.height);
+    SelectObject(m_hpreviewCompatibleDC, m_hbpreview);
+
+    m_preview_bi = m_bi;
+    m_preview_bi.biWidth = preview_size.width;
+    m_preview_bi.biHeight = -preview_size.height;
+
+    // initializing the preview containers
+    m_preview_capture_mat = cv::Mat(preview_size, CV_8UC4);
+    m_preview_img = QImage(preview_size.width, preview_size.height, QImage::Format_RGB888);
+    m_preview_img_mat = cv::Mat(preview_size, CV_8UC3, m_preview_img.bits(), m_preview_img.bytesPerLine());
+
+}
 
-    m_capture_mtx.lock();
-    if (aoi.width == 0) {
-        latest_capture = m_capture_cvt_mat.clone();
-    } else {
-        latest_capture = m_capture_cvt_mat(aoi).clone();
+void ScreenRecorder::release_preview_capture(void) {
+
+    if (m_hbpreview != NULL) {
+        DeleteObject(m_hbpreview);
+        m_hbpreview = NULL;
+    }
+
+    if (m_hpreviewCompatibleDC != NULL) {
+        DeleteDC(m_hpreviewCompatibleDC);
+        m_hpreviewCompatibleDC = NULL;
     }
-    m_capture_mtx.unlock();
 
-    return latest_capture;
+}
+
+cv::Mat ScreenRecorder::get_lastest_acquisition(cv::Rect aoi) {
+    return m_frame_pyramid_p->get_source(aoi).clone();
+}
 
+std::shared_ptr<FramePyramid> ScreenRecorder::get_frame_pyramid(void) const {
+    return m_frame_pyramid_p;
 }
 
 void ScreenRecorder::get_screen_dimensions(int& screen_width, int& screen_height) const {
@@ -190,42 +239,83 @@ void ScreenRecorder::get_screen_dimensions(int& screen_width, int& screen_height
     screen_height = m_window_rc.bottom;
 }
 
+void ScreenRecorder::convert_capture(cv::Mat& cvt_mat, cv::Mat* resized_mat, int resize_factor) {
+
+    auto conversion_start = std::chrono::high_resolution_clock::now();
+
+    convert_bgra_tiles(*m_worker_pool_p, m_capture_mat, cvt_mat, resized_mat, resize_factor);
+
+    auto conversion_end = std::chrono::high_resolution_clock::now();
+    m_conversion_time_us += std::chrono::duration_cast<std::chrono::microseconds>(conversion_end - conversion_start).count();
+    m_n_conversions++;
+
+}
+
 void ScreenRecorder::collect_window_captures(void) {
   
+    auto preview_period = std::chrono::milliseconds(1000 / m_preview_fps);
+
 	while (m_collect_data) {
+
+        // in preview mode, capturing the window at the preview dimensions and sending the image to UI
+        if (m_stream_preview) {
+
+            auto preview_start = std::chrono::steady_clock::now();
+
+            StretchBlt(m_hpreviewCompatibleDC, 0, 0, m_preview_capture_mat.cols, m_preview_capture_mat.rows, 
+                m_hwindowDC, 0, 0, m_window_rc.right, m_window_rc.bottom, SRCCOPY);
+            GetDIBits(m_hpreviewCompatibleDC, m_hbpreview, 0, m_preview_capture_mat.rows, m_preview_capture_mat.data, (BITMAPINFO*)&m_preview_bi, DIB_RGB_COLORS);
+
+            // handing the capture over to the frame pyramid consumers (new buffer), then filling the display image
+            cv::Mat preview_cvt_mat;
+            cv::cvtColor(m_preview_capture_mat, preview_cvt_mat, CV_BGRA2BGR);
+            m_frame_pyramid_p->set_source(preview_cvt_mat);
+            cv::cvtColor(preview_cvt_mat, m_preview_img_mat, CV_BGR2RGB);
+
+            emit new_window_capture(m_preview_img.copy());
+            std::this_thread::sleep_until(preview_start + preview_period);
+            continue;
+
+        }
 	
         // performing the window capture: copy from the window device context to the bitmap device context
         // Source: https://stackoverflow.com/questions/14148758/how-to-capture-the-desktop-in-opencv-ie-turn-a-bitmap-into-a-mat/14167433#14167433
         StretchBlt(m_hwindowCompatibleDC, 0, 0, m_window_rc.right, m_window_rc.bottom, m_hwindowDC, 0, 0, m_window_rc.right, m_window_rc.bottom, SRCCOPY);
         GetDIBits(m_hwindowCompatibleDC, m_hbwindow, 0, m_window_rc.bottom, m_capture_mat.data, (BITMAPINFO*)&m_bi, DIB_RGB_COLORS);
         
-        // color conversion -> filling (m_capture_cvt_mat) the screen capture's final form
-        m_capture_mtx.lock();
-        cv::cvtColor(m_capture_mat, m_capture_cvt_mat, CV_BGRA2BGR);
-        m_capture_mtx.unlock();
-
-        // in preview mode, resizing an sending the image to UI (low resolution display)
-        if (m_stream_preview) {
-            cv::resize(m_capture_cvt_mat, m_preview_img_mat, m_preview_img_mat.size(), 0, 0, cv::INTER_AREA);
-            emit new_window_capture(m_preview_img.copy());
-            std::this_thread::sleep_for(std::chrono::milliseconds(CAPTURE_DISPLAY_THREAD_DELAY_MS));
-        }
-        
-        // in normal mode, write to video and index file + redis
-        else {
-
+        // color conversion -> the screen capture's final form, handed over to the frame pyramid
+        // (new buffers are used for every capture since the consumers may still hold the previous ones)
+        // the downscaled image required by redis is produced in the same tiled pass
+        cv::Mat capture_cvt_mat(m_capture_mat.size(), CV_8UC3);
+        cv::Mat redis_img_mat;
+        try {
             if (m_redis_state) {
-                cv::resize(m_capture_cvt_mat, m_redis_img_mat, m_redis_img_mat.size(), 0, 0, cv::INTER_AREA);
-                cv::cvtColor(m_redis_img_mat, m_redis_img_mat, CV_BGRA2GRAY);
-                write_img_to_redis(m_redis_img_entry, m_redis_img_mat);
+                redis_img_mat = cv::Mat(m_redis_img_size, CV_8UC1);
+                convert_capture(capture_cvt_mat, &redis_img_mat, REDIS_RESIZE_FACTOR);
+            } else {
+                convert_capture(capture_cvt_mat, nullptr, 1);
             }
+        } catch (const std::exception& e) {
+            // a failed tile leaves the capture incomplete, it is dropped
+            write_debug_output("ScreenRecorder - failed to convert the capture : " + QString::fromStdString(e.what()));
+            continue;
+        } catch (...) {
+            write_debug_output("ScreenRecorder - failed to convert the capture");
+            continue;
+        }
+
+        m_frame_pyramid_p->set_source(capture_cvt_mat);
+        if (!redis_img_mat.empty()) m_frame_pyramid_p->set_variant(m_redis_img_size, CV_8UC1, redis_img_mat);
+
+        // in normal mode, write to video and index file + redis
+        if (m_redis_state) {
+            write_img_to_redis(m_redis_img_entry, m_frame_pyramid_p->get_variant(m_redis_img_size, CV_8UC1));
+        }
            
-            // write to file
-            if (!m_pass_through) {
-                m_video.write(m_capture_cvt_mat);
-                m_output_index_file << get_micro_timestamp() << "\n";
-            }
-            
+        // write to file
+        if (!m_pass_through) {
+            m_video.write(capture_cvt_mat);
+            m_output_index_file << get_micro_timestamp() << "\n";
         }
 
 	}
@@ -1,8 +1,12 @@
 #pragma once
 
 #include "SensorDevice.h"
+#include "FramePyramid.h"
+#include "WorkerPool.h"
+#include "TiledConversion.h"
 
 #include <string>
+#include <memory>
 #include <thread>
 #include <chrono>
 #include <fstream>
@@ -11,13 +15,17 @@
 #include <QImage>
 #include <opencv2/opencv.hpp>
 
-// resize factor to fit a target display of (360 x 640) px
-#define SR_PREVIEW_RESIZE_FACTOR 3
 #define REDIS_RESIZE_FACTOR 2
 
 #define SCREEN_CAPTURE_FPS 20
-#define CAPTURE_DISPLAY_THREAD_DELAY_MS 150
 
+/**
+* Class capturing the content of the screen (desktop window)
+*
+* In preview mode, the screen is captured directly at the preview dimensions (the downscaling is done by GDI during the copy)
+* and at the preview rate, the full resolution capture and its conversions are only performed when streaming.
+* The preview captures are still handed over to the frame pyramid (at the preview dimensions).
+*/
 class ScreenRecorder : public SensorDevice {
 
 	Q_OBJECT
@@ -37,6 +45,11 @@ class ScreenRecorder : public SensorDevice {
 		cv::Mat get_lastest_acquisition(cv::Rect aoi=cv::Rect(0, 0, 0, 0));
 		void get_screen_dimensions(int&, int&) const;
 
+		/**
+		* \return The frame pyramid holding the latest screen capture (BGR) and its resized / converted variants.
+		*/
+		std::shared_ptr<FramePyramid> get_frame_pyramid(void) const;
+
 	private:
 
 		/**
@@ -47,24 +60,50 @@ class ScreenRecorder : public SensorDevice {
 
 		void initialize_capture(void);
 
+		/**
+		* Creates the capture bitmap sized according to the preview profile (see SensorDevice).
+		*/
+		void initialize_preview_capture(void);
+		void release_preview_capture(void);
+
+		/**
+		* Converts the latest capture (BGRA) to BGR and (optionally) downscales it, in row tiles executed by the worker pool
+		* (see convert_bgra_tiles).
+		*
+		* \param cvt_mat Destination of the BGR conversion, with the capture dimensions.
+		* \param resized_mat Destination of the downscaled capture (BGR or gray scale), nullptr to skip the downscaling.
+		* \param resize_factor The integer downscaling factor between the capture and (resized_mat).
+		*/
+		void convert_capture(cv::Mat& cvt_mat, cv::Mat* resized_mat, int resize_factor);
+
 		// window capture vars
 		RECT m_window_rc;
 		HWND m_window_handle;
 		HBITMAP m_hbwindow;
 		BITMAPINFOHEADER m_bi;
 		HDC m_hwindowDC, m_hwindowCompatibleDC;
+
+		// preview capture vars
+		HBITMAP m_hbpreview = NULL;
+		BITMAPINFOHEADER m_preview_bi;
+		HDC m_hpreviewCompatibleDC = NULL;
 		
 		// image handling containers
 		QImage m_preview_img;
 		cv::Mat m_preview_img_mat;
+		cv::Mat m_preview_capture_mat;
 		cv::Mat m_capture_mat;
-		cv::Mat m_capture_cvt_mat;
-		cv::Mat m_redis_img_mat;
+		cv::Size m_redis_img_size;
+		std::shared_ptr<FramePyramid> m_frame_pyramid_p;
 
 		// thread vars
 		bool m_collect_data = false;
 		std::thread m_collection_thread;
-		std::mutex m_capture_mtx;
+
+		// conversion thread pool + timing stats
+		std::unique_ptr<WorkerPool> m_worker_pool_p;
+		long long m_conversion_time_us = 0;
+		long long m_n_conversions = 0;
 
 		// output file vars
 		bool m_output_file_loaded = false;
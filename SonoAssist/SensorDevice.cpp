@@ -92,6 +92,12 @@ void SensorDevice::set_configuration(std::shared_ptr<config_map> config_ptr) {
 
 }
 
+void SensorDevice::set_preview_profile(int width, int height, int fps) {
+	m_preview_width = std::max(1, width);
+	m_preview_height = std::max(1, height);
+	m_preview_fps = std::max(1, fps);
+}
+
 /*******************************************************************************
 * REDIS METHODS
 ******************************************************************************/
@@ -146,13 +152,49 @@ void SensorDevice::write_str_to_redis(const std::string& redis_entry, std::strin
 
 }
 
-void SensorDevice::write_img_to_redis(const std::string& redis_entry, const cv::Mat& img) {
+void SensorDevice::write_strs_to_redis(const std::string& redis_entry, const std::vector<std::string>& data_strs, bool rate_divided) {
+
+	if (m_redis_state && m_redis_client_p != nullptr) {
+
+		try {
+
+			if (!rate_divided) {
+				if (!data_strs.empty()) m_redis_client_p->rpush(redis_entry, data_strs.begin(), data_strs.end());
+				return;
+			}
+
+			std::vector<std::string> selected_strs;
+			for (const std::string& data_str : data_strs) {
+				if ((m_redis_data_count % m_redis_rate_div) == 0) {
+					selected_strs.push_back(data_str);
+					m_redis_data_count = 1;
+				} else {
+					m_redis_data_count++;
+				}
+			}
+
+			if (!selected_strs.empty()) {
+				m_redis_client_p->rpush(redis_entry, selected_strs.begin(), selected_strs.end());
+			}
+
+		} catch (...) {
+			m_redis_state = false;
+			write_debug_output("Failed to write (strings) to redis");
+		}
+
+	}
+
+}
+
+void SensorDevice::write_img_to_redis(const std::string& redis_entry, const cv::Mat& img, bool rate_divided) {
 
 	if (m_redis_state && m_redis_client_p != nullptr) {
 
 		try {
 		
-			if ((m_redis_data_count % m_redis_rate_div) == 0) {
+			if (!rate_divided) {
+				m_redis_client_p->set(redis_entry, std::string((char*)img.data, img.step[0] * img.rows));
+			} else if ((m_redis_data_count % m_redis_rate_div) == 0) {
 				size_t mat_byte_size = img.step[0] * img.rows;
 				m_redis_client_p->set(redis_entry, std::string((char*)img.data, mat_byte_size));
 				m_redis_data_count = 1;
@@ -173,12 +215,51 @@ void SensorDevice::write_img_to_redis(const std::string& redis_entry, const cv::
 * HELPERS
 ******************************************************************************/
 
+int SensorDevice::select_preview_mode(const std::vector<SensorMode>& modes, int width, int height, int fps) {
+
+	int covering_index = -1, fps_index = -1, largest_index = -1;
+
+	for (auto i = 0; i < modes.size(); i++) {
+
+		const SensorMode& mode = modes[i];
+		long long area = static_cast<long long>(mode.width) * mode.height;
+		auto is_smaller = [&](int index) {
+			long long index_area = static_cast<long long>(modes[index].width) * modes[index].height;
+			return (area < index_area) || (area == index_area && mode.fps < modes[index].fps);
+		};
+
+		// lowest mode covering the profile
+		if (mode.width >= width && mode.height >= height && mode.fps >= fps) {
+			if (covering_index == -1 || is_smaller(covering_index)) covering_index = i;
+		}
+
+		// fallbacks : largest mode reaching the frame rate, largest mode
+		if (mode.fps >= fps && (fps_index == -1 || !is_smaller(fps_index))) fps_index = i;
+		if (largest_index == -1 || !is_smaller(largest_index)) largest_index = i;
+
+	}
+
+	if (covering_index != -1) return covering_index;
+	if (fps_index != -1) return fps_index;
+	return largest_index;
+
+}
+
 std::string SensorDevice::get_micro_timestamp(void) {
+	return std::to_string(get_micro_timestamp_count());
+}
 
-	auto time_stamp = std::chrono::duration_cast<std::chrono::microseconds>(
+long long SensorDevice::get_micro_timestamp_count(void) {
+	return std::chrono::duration_cast<std::chrono::microseconds>(
 		std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+}
+
+cv::Size SensorDevice::get_preview_display_size(int frame_width, int frame_height) const {
+
+	if (frame_width <= 0 || frame_height <= 0) return cv::Size(m_preview_width, m_preview_height);
 
-	return std::to_string(time_stamp);
+	double scale = std::min(static_cast<double>(m_preview_width) / frame_width, static_cast<double>(m_preview_height) / frame_height);
+	return cv::Size(std::max(1, static_cast<int>(frame_width * scale)), std::max(1, static_cast<int>(frame_height * scale)));
 
 }
 
@@ -2,9 +2,11 @@
 
 #include <map>
 #include <string>
+#include <vector>
 #include <memory>
 #include <chrono>
 #include <fstream>
+#include <algorithm>
 
 #include <QDebug>
 #include <QObject>
@@ -16,8 +18,22 @@
 #define REDIS_PORT 6379
 #define REDIS_ADDRESS "127.0.0.1"
 
+// default preview profile (dimensions of a preview pane)
+#define DEFAULT_PREVIEW_WIDTH 640
+#define DEFAULT_PREVIEW_HEIGHT 360
+#define DEFAULT_PREVIEW_FPS 6
+
 using config_map = std::map<std::string, std::string>;
 
+/**
+* Native acquisition mode of a sensor (used for the preview profile negotiation)
+*/
+struct SensorMode {
+	int width;
+	int height;
+	int fps;
+};
+
 /**
 * Abstract class for the implementation of custom sensor devices.
 *
@@ -54,6 +70,16 @@ class SensorDevice : public QObject {
 		void set_stream_preview_status(bool state);
 		void set_configuration(std::shared_ptr<config_map> config_ptr);
 
+		/**
+		* Defines the preview profile (the pane where the preview images are displayed and the preview refresh rate).
+		* In preview mode, devices open their sensors with the lowest native mode satisfying this profile.
+		*
+		* \param width The width (px) of the preview pane.
+		* \param height The height (px) of the preview pane.
+		* \param fps The preview refresh rate.
+		*/
+		void set_preview_profile(int width, int height, int fps);
+
 		/*******************************************************************************
 		* REDIS METHODS
 		******************************************************************************/
@@ -79,19 +105,41 @@ class SensorDevice : public QObject {
 		* \param data_str The string to append.
 		*/
 		virtual void write_str_to_redis(const std::string& redis_entry, std::string data_str);
+
+		/**
+		* Batch version of (write_str_to_redis), the selected strings (once every (m_redis_rate_div)) are appended with a single request.
+		* 
+		* \param redis_entry The identifier for the Redis list to which the provided strings will be appended.
+		* \param data_strs The strings to append.
+		* \param rate_divided When false, all of the strings are appended (event like data).
+		*/
+		virtual void write_strs_to_redis(const std::string& redis_entry, const std::vector<std::string>& data_strs, bool rate_divided = true);
 		
 		/**
 		* Once every (m_redis_rate_div) function call, the provided image overwrites the specified redis entry.
 		* 
 		* \param redis_entry The identifier to the Redis variable to overwrite with the provided image data.
 		* \param img The image data.
+		* \param rate_divided When false, the image is always written.
 		*/
-		virtual void write_img_to_redis(const std::string& redis_entry, const cv::Mat& img);
+		virtual void write_img_to_redis(const std::string& redis_entry, const cv::Mat& img, bool rate_divided = true);
 
 		/*******************************************************************************
 		* HELPERS
 		******************************************************************************/
 
+		/**
+		* Selects the lowest native mode (pixel count, then frame rate) covering the provided preview profile.
+		* When no mode covers the profile, the largest mode reaching the frame rate (or the largest mode) is selected.
+		*
+		* \param modes The native modes of the sensor.
+		* \param width The minimum width (px).
+		* \param height The minimum height (px).
+		* \param fps The minimum frame rate.
+		* \returns The index of the selected mode, -1 when (modes) is empty.
+		*/
+		static int select_preview_mode(const std::vector<SensorMode>& modes, int width, int height, int fps);
+
 		/**
 		* Generates a micro second precision timestamp
 		*
@@ -99,6 +147,13 @@ class SensorDevice : public QObject {
 		*/
 		static std::string get_micro_timestamp(void);
 
+		/**
+		* Generates a micro second precision timestamp
+		*
+		* \returns micro second count since epoch
+		*/
+		static long long get_micro_timestamp_count(void);
+
 		/*******************************************************************************
 		* PURE VIRTUAL METHODS
 		* When implemented, all of the following methods must be non-bloking
@@ -143,6 +198,11 @@ class SensorDevice : public QObject {
 		*/
 		void write_debug_output(const QString&);
 
+		/**
+		* \returns The largest size fitting in the preview pane with the aspect ratio of the provided frame size.
+		*/
+		cv::Size get_preview_display_size(int frame_width, int frame_height) const;
+
 		// device identification vars
 		int m_device_id;
 		std::string m_device_description;
@@ -154,6 +214,11 @@ class SensorDevice : public QObject {
 		bool m_device_connected = false;
 		bool m_device_streaming = false;
 
+		// preview profile vars
+		int m_preview_width = DEFAULT_PREVIEW_WIDTH;
+		int m_preview_height = DEFAULT_PREVIEW_HEIGHT;
+		int m_preview_fps = DEFAULT_PREVIEW_FPS;
+
 		// configs vars
 		bool m_config_loaded = false;
 		std::shared_ptr<config_map> m_config_ptr;
@@ -11,15 +11,27 @@ SonoAssist::SonoAssist(QWidget *parent) : QMainWindow(parent){
     *m_app_params = {
         {"test_list", ""},
         {"ext_imu_ble_address", ""}, {"ext_imu_to_redis", ""}, {"ext_imu_redis_entry", ""}, {"ext_imu_redis_rate_div", ""},
-        {"eye_tracker_to_redis", ""}, {"eye_tracker_redis_entry", ""}, {"eye_tracker_redis_rate_div", ""},
-        {"sc_to_redis", ""}, {"sc_img_redis_entry", ""}, {"sc_redis_rate_div", ""},
+        {"ext_imu_raw_mode", ""}, {"ext_imu_raw_rate", ""}, {"ext_imu_log_mode", ""}, {"ext_imu_log_preview_period", ""},
+        {"ext_imu_transport_url", ""}, {"os_key_actions", ""}, {"os_key_input_device", ""},
+        {"eye_tracker_to_redis", ""}, {"eye_tracker_device_url", ""}, {"eye_tracker_redis_entry", ""}, {"eye_tracker_redis_rate_div", ""},
+        {"eye_tracker_processing", ""}, {"eye_tracker_filtered_redis_entry", ""}, {"eye_tracker_events_redis_entry", ""},
+        {"eye_tracker_phys_screen_width", ""}, {"eye_tracker_phys_screen_height", ""}, {"eye_tracker_max_gaze_speed", ""},
+        {"eye_tracker_default_head_position", ""}, {"eye_tracker_x_offset", ""}, {"eye_tracker_y_offset", ""}, {"eye_tracker_min_fixation_ms", ""},
+        {"eye_tracker_saliency", ""}, {"eye_tracker_saliency_redis_entry", ""}, {"eye_tracker_saliency_width", ""}, {"eye_tracker_saliency_window_ms", ""},
+        {"us_probe_gaze_mapping", ""}, {"us_probe_us_template", ""},
+        {"sc_to_redis", ""}, {"sc_img_redis_entry", ""}, {"sc_redis_rate_div", ""}, {"sc_n_threads", ""},
         {"us_probe_ip_address", ""}, {"us_probe_to_redis", ""}, {"us_probe_imu_redis_entry", ""}, {"us_probe_img_redis_entry", ""} , {"us_probe_redis_rate_div", ""},
+        {"rgbd_playback_file", ""}, {"rgbd_playback_real_time", ""},
+        {"rgbd_compressed_recording", ""}, {"rgbd_encoder_threads", ""}, {"rgbd_jpeg_quality", ""},
+        {"rgbd_to_redis", ""}, {"rgbd_redis_rate_div", ""}, {"rgbd_color_redis_entry", ""}, {"rgbd_depth_redis_entry", ""}, {"rgbd_decimation_magnitude", ""},
+        {"rgbd_pointcloud_active", ""}, {"rgbd_pointcloud_redis_entry", ""}, {"rgbd_pointcloud_rate_div", ""}, {"rgbd_pointcloud_voxel_size", ""},
         {"redis_server_path", ""},
         {"eye_tracker_crosshairs_path", ""}, {"eye_tracker_target_path", ""},
         {"us_image_main_display_height", ""}, {"us_image_main_display_width", ""},
         {"cugn_active", ""}, {"cugn_model_path", ""}, {"cugn_to_redis", ""}, {"cugn_redis_entry", ""},
         {"cugn_sample_frequency", ""}, {"cugn_sequence_lenght", ""},  {"cugn_n_gru_cells", ""}, {"cugn_n_gru_neurons", ""}, {"cugn_pixel_mean", ""}, {"cugn_pixel_std_div", ""},
-        {"cugn_us_template", ""}, {"cugn_input_h", "" }, {"cugn_input_w", ""}
+        {"cugn_us_template", ""}, {"cugn_input_h", "" }, {"cugn_input_w", ""}, {"cugn_preprocess_benchmark", ""}, {"cugn_input_source", ""},
+        {"ml_intra_op_threads", ""}, {"ml_inter_op_threads", ""}, {"ml_warmup_passes", ""}
     };
 
     std::string log_file_path = create_log_folder();
@@ -34,11 +46,13 @@ SonoAssist::SonoAssist(QWidget *parent) : QMainWindow(parent){
     connect(m_gaze_tracker_client_p.get(), &GazeTracker::new_gaze_point, this, &SonoAssist::on_new_gaze_point);
     m_sensor_devices.push_back(m_gaze_tracker_client_p);
     
-    m_camera_client_p = std::make_shared<RGBDCameraClient>(m_sensor_devices.size(), "RGBD Camera", "", log_file_path);
+    m_camera_client_p = std::make_shared<RGBDCameraClient>(m_sensor_devices.size(), "RGBD Camera", "rgbd_to_redis", log_file_path);
     connect(m_camera_client_p.get(), &RGBDCameraClient::new_video_frame, this, &SonoAssist::update_left_preview_display);
+    m_camera_client_p->set_preview_profile(PREVIEW_LEFT_DISPLAY_WIDTH, PREVIEW_LEFT_DISPLAY_HEIGHT, PREVIEW_DISPLAY_FPS);
     m_sensor_devices.push_back(m_camera_client_p);
     
     m_metawear_client_p = std::make_shared<MetaWearBluetoothClient>(m_sensor_devices.size(), "External IMU", "ext_imu_to_redis", log_file_path);
+    connect(m_metawear_client_p.get(), &MetaWearBluetoothClient::log_download_progress, this, &SonoAssist::on_ext_imu_log_download_progress);
     m_sensor_devices.push_back(m_metawear_client_p);
     
     m_us_probe_client_p = std::make_shared<ClariusProbeClient>(m_sensor_devices.size(), "Clarius Probe", "us_probe_to_redis", log_file_path);
@@ -49,6 +63,7 @@ SonoAssist::SonoAssist(QWidget *parent) : QMainWindow(parent){
     
     m_screen_recorder_client_p = std::make_shared<ScreenRecorder>(m_sensor_devices.size(), "Screen Recorder", "sc_to_redis", log_file_path);
     connect(m_screen_recorder_client_p.get(), &ScreenRecorder::new_window_capture, this, &SonoAssist::update_right_preview_display);
+    m_screen_recorder_client_p->set_preview_profile(PREVIEW_RIGHT_DISPLAY_WIDTH, PREVIEW_RIGHT_DISPLAY_HEIGHT, PREVIEW_DISPLAY_FPS);
     m_sensor_devices.push_back(m_screen_recorder_client_p);
 
     m_key_detector_client_p = std::make_shared<OSKeyDetector>(m_sensor_devices.size(), "OS key detector", "", log_file_path);
@@ -74,7 +89,7 @@ SonoAssist::SonoAssist(QWidget *parent) : QMainWindow(parent){
     m_ml_models = std::vector<std::shared_ptr<MLModel>>();
 
     m_ml_models.emplace_back(std::make_shared<CUGNModel>(m_ml_models.size(),
-        "CUGN Model", "cugn_active", "cugn_to_redis", "cugn_model_path", log_file_path, m_screen_recorder_client_p));
+        "CUGN Model", "cugn_active", "cugn_to_redis", "cugn_model_path", log_file_path, m_screen_recorder_client_p, m_us_probe_client_p));
     connect(m_ml_models[m_ml_models.size() - 1].get(), &CUGNModel::new_us_img_detection, this, &SonoAssist::update_main_display);
     
     // connecting to the models (debug output) signal
@@ -232,10 +247,18 @@ void SonoAssist::on_new_clarius_image(QImage new_image){
 
             update_main_display(new_image);
 
-            // writing the output data
+            // writing the output data (with the gaze point mapped on the image)
+            long long gaze_time_os = 0;
+            float gaze_x = 0, gaze_y = 0;
+            if (m_gaze_tracker_client_p->get_latest_gaze_point(gaze_time_os, gaze_x, gaze_y)) {
+                m_us_probe_client_p->set_gaze_point(gaze_time_os, gaze_x, gaze_y);
+            }
             m_us_probe_client_p->m_display_time = m_us_probe_client_p->get_micro_timestamp();
             m_us_probe_client_p->write_output_data();
 
+            // publishing the gaze saliency map associated with the displayed image
+            m_gaze_tracker_client_p->request_saliency_map(SensorDevice::get_micro_timestamp_count());
+
             m_us_probe_client_p->m_handler_locked = false;
 
         }
@@ -661,6 +684,15 @@ void SonoAssist::set_device_status(int device_id, bool device_status) {
 
 }
 
+void SonoAssist::on_ext_imu_log_download_progress(int n_downloaded_entries, int n_total_entries) {
+
+    // showing the download progress of the external IMU log in the status bar
+    int percentage = (n_total_entries > 0) ? (100 * n_downloaded_entries) / n_total_entries : 100;
+    if (percentage < 100) ui.statusBar->showMessage("External IMU log download : " + QString::number(percentage) + " %");
+    else ui.statusBar->showMessage("External IMU log download completed", STATUS_MESSAGE_TIMEOUT);
+
+}
+
 void SonoAssist::add_debug_text(const QString& debug_str) {
     ui.debug_text_edit->setText(ui.debug_text_edit->toPlainText() + "\n" + debug_str);
 }
@@ -669,16 +701,24 @@ void SonoAssist::add_debug_text(const QString& debug_str) {
 * TIME MARKER HANDLING
 ******************************************************************************/
 
-void SonoAssist::on_new_os_key_detected(int key) {
+void SonoAssist::on_new_os_key_detected(int action, long long os_time) {
 
-    if (m_stream_is_active) {
+    // starting / stopping the acquisition (as with the buttons)
+    if (action == OS_ACTION_START_ACQUISITION) {
+        if (!m_stream_is_active && ui.start_acquisition_button->isEnabled()) on_start_acquisition_button_clicked();
+    }
+    else if (action == OS_ACTION_STOP_ACQUISITION) {
+        if (m_stream_is_active) on_stop_acquisition_button_clicked();
+    }
+
+    else if (m_stream_is_active) {
 
-        // adding a time marker
-        if (key == OS_A_KEY) {
+        // adding a time marker (time of the key press)
+        if (action == OS_ACTION_ADD_MARKER) {
 
             // adding the marker to the display list + json time marker list
             QString marker_str = "Time marker #" + QString::number(ui.time_marker_list->count()) +
-                " - " + QString(SensorDevice::get_micro_timestamp().c_str());
+                " - " + QString::number(os_time);
             ui.time_marker_list->addItem(new QListWidgetItem(marker_str));
             m_time_markers_json.push_back(QJsonValue(marker_str));
             
@@ -688,7 +728,7 @@ void SonoAssist::on_new_os_key_detected(int key) {
         }
 
         // removing a time marker
-        else if (key == OS_D_KEY) {
+        else if (action == OS_ACTION_REMOVE_MARKER) {
 
             // removing the latest time marker
             if (ui.time_marker_list->count() > 0) {
@@ -831,6 +871,14 @@ void SonoAssist::generate_main_display(void) {
     m_output_params["display_width"] = m_main_us_img_width;
     m_output_params["display_height"] = m_main_us_img_height;
 
+    // the online gaze processing filters gaze points according to the display position
+    int screen_width = 0, screen_height = 0;
+    m_screen_recorder_client_p->get_screen_dimensions(screen_width, screen_height);
+    m_gaze_tracker_client_p->set_display_geometry(screen_width, screen_height, 
+        screen_point.x(), screen_point.y(), m_main_us_img_width, m_main_us_img_height);
+    m_us_probe_client_p->set_display_geometry(screen_width, screen_height, 
+        screen_point.x(), screen_point.y(), m_main_us_img_width, m_main_us_img_height);
+
 }
 
 void SonoAssist::remove_main_display(void) {
@@ -38,6 +38,7 @@
 #define IMG_PLACE_HOLDER_COLOR "#000000"
 #define ACTIVE_SENSOR_FIELD_COLOR "#D3D3D3"
 #define INACTIVE_SENSOR_FIELD_COLOR "#ffffff"
+#define STATUS_MESSAGE_TIMEOUT 5000
 
 // main display constants
 #define MAIN_DISPLAY_DEFAULT_WIDTH 1260
@@ -55,6 +56,9 @@
 #define PREVIEW_LEFT_DISPLAY_X_OFFSET 0
 #define PREVIEW_LEFT_DISPLAY_Y_OFFSET 0
 
+// refresh rate of the preview displays (devices negotiate their preview modes with it)
+#define PREVIEW_DISPLAY_FPS 6
+
 // Eyetracker crosshairs dimensions constants
 #define EYETRACKER_N_ACC_TARGETS 4
 #define EYETRACKER_ACC_TARGET_WIDTH 20
@@ -101,18 +105,20 @@ class SonoAssist : public QMainWindow {
 
 		void add_debug_text(const QString&);
 		void set_device_status(int device_id, bool device_status);
+		void on_ext_imu_log_download_progress(int n_downloaded_entries, int n_total_entries);
 
 		/*******************************************************************************
 		* TIME MARKER HANDLING SLOTS
 		******************************************************************************/
 
 		/*
-		* This method captures the key press codes emited by the (OSKeyDetector) SensorDevice instance
-		* and creates (A) / deletes (D) time markers based on the presses.
+		* This method captures the key actions emited by the (OSKeyDetector) SensorDevice instance
+		* and creates / deletes time markers or starts / stops the acquisition based on the presses.
 		*
-		* \param key The key code emitedby the (OSKeyDetector).
+		* \param action The key action (OS_ACTION_...) emited by the (OSKeyDetector).
+		* \param os_time The OS time (us) of the key press.
 		*/
-		void on_new_os_key_detected(int key);
+		void on_new_os_key_detected(int action, long long os_time);
 
 	private slots:
 
@@ -0,0 +1,43 @@
+#include "TiledConversion.h"
+
+#include <algorithm>
+
+void convert_bgra_tiles(WorkerPool& worker_pool, const cv::Mat& capture_mat, cv::Mat& cvt_mat, cv::Mat* resized_mat, int resize_factor) {
+
+	// defining the row tiles
+	int n_rows = capture_mat.rows;
+	int n_tiles = worker_pool.get_n_threads() * SC_TILES_PER_THREAD;
+	int tile_rows = (n_rows + n_tiles - 1) / n_tiles;
+	tile_rows = ((tile_rows + resize_factor - 1) / resize_factor) * resize_factor;
+	n_tiles = (n_rows + tile_rows - 1) / tile_rows;
+
+	worker_pool.run(n_tiles, [&](int tile_index) {
+
+		// color conversion of the tile
+		int row_start = tile_index * tile_rows;
+		int row_end = std::min(row_start + tile_rows, n_rows);
+		cv::Mat cvt_tile = cvt_mat.rowRange(row_start, row_end);
+		cv::cvtColor(capture_mat.rowRange(row_start, row_end), cvt_tile, CV_BGRA2BGR);
+
+		// downscaling of the tile (the last tile covers the remaining output rows)
+		if (resized_mat != nullptr) {
+
+			int out_row_start = row_start / resize_factor;
+			int out_row_end = (row_end == n_rows) ? resized_mat->rows : (row_end / resize_factor);
+
+			if (out_row_end > out_row_start) {
+				cv::Mat resized_tile = resized_mat->rowRange(out_row_start, out_row_end);
+				if (resized_mat->channels() == 1) {
+					cv::Mat resized_bgr_tile;
+					cv::resize(cvt_tile, resized_bgr_tile, resized_tile.size(), 0, 0, cv::INTER_AREA);
+					cv::cvtColor(resized_bgr_tile, resized_tile, CV_BGR2GRAY);
+				} else {
+					cv::resize(cvt_tile, resized_tile, resized_tile.size(), 0, 0, cv::INTER_AREA);
+				}
+			}
+
+		}
+
+	});
+
+}
\ No newline at end of file
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "WorkerPool.h"
+
+#include <opencv2/opencv.hpp>
+
+// number of row tiles per conversion thread (load balancing)
+#define SC_TILES_PER_THREAD 2
+
+/**
+* Converts a BGRA capture to BGR and (optionally) downscales it, in row tiles executed by the worker pool.
+* Tile heights are multiples of the resize factor, so that every tile maps to whole output rows.
+*
+* \param worker_pool The pool executing the tiles.
+* \param capture_mat The BGRA capture.
+* \param cvt_mat Destination of the BGR conversion, with the capture dimensions.
+* \param resized_mat Destination of the downscaled capture (BGR or gray scale), nullptr to skip the downscaling.
+* \param resize_factor The integer downscaling factor between the capture and (resized_mat).
+*/
+void convert_bgra_tiles(WorkerPool& worker_pool, const cv::Mat& capture_mat, cv::Mat& cvt_mat, cv::Mat* resized_mat, int resize_factor);
\ No newline at end of file
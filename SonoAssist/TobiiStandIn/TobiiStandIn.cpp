@@ -0,0 +1,456 @@
+#include <tobii/tobii.h>
+#include <tobii/tobii_streams.h>
+
+#include <map>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+/*
+* Tobii Stream Engine stand-in, the device is selected with its url :
+*
+*	tobii-stand-in://synthetic?gaze_hz=90&head_hz=30
+*		Synthesized data : fixations (with some jitter) on random screen positions, seperated by saccades (instantaneous jumps),
+*		and a head swaying around 600 mm from the screen. Rates up to 1 kHz (or more) can be used for load testing.
+*
+*	tobii-stand-in://replay?folder=C:/acquisition_folder&speed=1&loop=1
+*		Replay of the (eye_tracker_gaze.csv) and (eye_tracker_head.csv) files written by SonoAssist, paced by the onboard
+*		timestamps (divided by the speed factor). With loop=1, the recording is replayed until the device is destroyed.
+*
+* The streams start with the first (tobii_wait_for_callbacks) or (tobii_device_process_callbacks) call on the device. Samples
+* are timestamped with their scheduled emission time in the system clock domain (tobii_system_clock). (tobii_wait_for_callbacks)
+* sleeps until the next sample is due and (tobii_device_process_callbacks) emits all due samples.
+*/
+
+#define STAND_IN_URL_PREFIX "tobii-stand-in://"
+#define STAND_IN_DEFAULT_URL "tobii-stand-in://synthetic?gaze_hz=90&head_hz=30"
+#define STAND_IN_MAX_WAIT_US 100000
+
+// synthetic data params
+#define STAND_IN_MIN_FIXATION_US 200000
+#define STAND_IN_MAX_FIXATION_US 600000
+#define STAND_IN_GAZE_JITTER 0.002f
+#define STAND_IN_HEAD_DISTANCE_MM 600.f
+
+struct tobii_api_t {
+	int n_devices = 0;
+};
+
+/**
+* Recorded sample (time relative to the start of the recording)
+*/
+struct StandInSample {
+	int64_t time_us;
+	float position[3];
+};
+
+struct tobii_device_t {
+
+	tobii_api_t* api = nullptr;
+	bool synthetic = true;
+
+	// subscriptions
+	tobii_gaze_point_callback_t gaze_callback = nullptr;
+	void* gaze_user_data = nullptr;
+	tobii_head_pose_callback_t head_callback = nullptr;
+	void* head_user_data = nullptr;
+
+	// emission schedule (system clock)
+	bool started = false;
+	int64_t start_time_us = 0;
+	int64_t next_gaze_time_us = 0;
+	int64_t next_head_time_us = 0;
+
+	// synthetic data
+	double gaze_period_us = 0;
+	double head_period_us = 0;
+	uint64_t n_gaze_samples = 0;
+	uint64_t n_head_samples = 0;
+	uint32_t rng_state = 12345;
+	float fixation_x = 0.5f;
+	float fixation_y = 0.5f;
+	int64_t fixation_end_us = 0;
+
+	// replayed data
+	std::vector<StandInSample> gaze_samples;
+	std::vector<StandInSample> head_samples;
+	size_t gaze_index = 0;
+	size_t head_index = 0;
+	double speed = 1;
+	bool loop = false;
+	int64_t replay_duration_us = 0;
+
+};
+
+/*******************************************************************************
+* HELPER FUNCTIONS
+******************************************************************************/
+
+static int64_t stand_in_clock_us(void) {
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static float stand_in_random(tobii_device_t* device) {
+	// xorshift32, uniform in [0, 1)
+	device->rng_state ^= device->rng_state << 13;
+	device->rng_state ^= device->rng_state >> 17;
+	device->rng_state ^= device->rng_state << 5;
+	return (device->rng_state >> 8) / 16777216.f;
+}
+
+/**
+* Splits the url parameters (key=value&key=value)
+*/
+static std::map<std::string, std::string> parse_url_params(const std::string& params_str) {
+
+	std::map<std::string, std::string> params;
+	std::stringstream params_stream(params_str);
+	std::string param;
+
+	while (std::getline(params_stream, param, '&')) {
+		size_t separator = param.find('=');
+		if (separator != std::string::npos) params[param.substr(0, separator)] = param.substr(separator + 1);
+	}
+
+	return params;
+
+}
+
+/**
+* Loads a SonoAssist eye tracker file (onboard time in the 3rd column, followed by the coordinates)
+*/
+static bool load_recorded_samples(const std::string& file_path, int n_coords, std::vector<StandInSample>& samples) {
+
+	std::ifstream input_file(file_path);
+	if (!input_file.is_open()) return false;
+
+	std::string line;
+	std::getline(input_file, line);
+
+	while (std::getline(input_file, line)) {
+
+		std::vector<std::string> fields;
+		std::stringstream line_stream(line);
+		std::string field;
+		while (std::getline(line_stream, field, ',')) fields.push_back(field);
+		if (fields.size() < static_cast<size_t>(3 + n_coords)) continue;
+
+		try {
+			StandInSample sample = {std::stoll(fields[2]), {0, 0, 0}};
+			for (int i = 0; i < n_coords; i++) sample.position[i] = std::stof(fields[3 + i]);
+			samples.push_back(sample);
+		} catch (...) {}
+
+	}
+
+	return true;
+
+}
+
+/**
+* Computes the emission time of the next gaze / head sample (INT64_MAX when the stream is over or not subscribed)
+*/
+static int64_t next_gaze_time(const tobii_device_t* device) {
+	if (device->gaze_callback == nullptr) return INT64_MAX;
+	if (!device->synthetic && device->gaze_index >= device->gaze_samples.size()) return INT64_MAX;
+	return device->next_gaze_time_us;
+}
+
+static int64_t next_head_time(const tobii_device_t* device) {
+	if (device->head_callback == nullptr) return INT64_MAX;
+	if (!device->synthetic && device->head_index >= device->head_samples.size()) return INT64_MAX;
+	return device->next_head_time_us;
+}
+
+static int64_t replay_time(const tobii_device_t* device, int64_t recording_time_us) {
+	return device->start_time_us + static_cast<int64_t>(recording_time_us / device->speed);
+}
+
+/**
+* Restarts the replay once both streams are over (loop mode)
+*/
+static void restart_replay(tobii_device_t* device) {
+
+	if (!device->loop || device->gaze_index < device->gaze_samples.size() || device->head_index < device->head_samples.size()) return;
+
+	device->start_time_us += static_cast<int64_t>(device->replay_duration_us / device->speed);
+	device->gaze_index = 0;
+	device->head_index = 0;
+	if (!device->gaze_samples.empty()) device->next_gaze_time_us = replay_time(device, device->gaze_samples[0].time_us);
+	if (!device->head_samples.empty()) device->next_head_time_us = replay_time(device, device->head_samples[0].time_us);
+
+}
+
+/**
+* Starts the emission schedule of the streams (first call only)
+*/
+static void start_streams(tobii_device_t* device) {
+
+	if (device->started) return;
+	device->started = true;
+
+	device->start_time_us = stand_in_clock_us();
+	device->next_gaze_time_us = device->start_time_us;
+	device->next_head_time_us = device->start_time_us;
+	device->fixation_end_us = device->start_time_us;
+
+	if (!device->synthetic) {
+		if (!device->gaze_samples.empty()) device->next_gaze_time_us = replay_time(device, device->gaze_samples[0].time_us);
+		if (!device->head_samples.empty()) device->next_head_time_us = replay_time(device, device->head_samples[0].time_us);
+	}
+
+}
+
+static void emit_gaze_sample(tobii_device_t* device) {
+
+	tobii_gaze_point_t gaze_point = {device->next_gaze_time_us, TOBII_VALIDITY_VALID, {0, 0}};
+
+	if (device->synthetic) {
+
+		// moving to a new fixation (saccade) once the current one is over
+		if (device->next_gaze_time_us >= device->fixation_end_us) {
+			device->fixation_x = 0.1f + 0.8f * stand_in_random(device);
+			device->fixation_y = 0.1f + 0.8f * stand_in_random(device);
+			device->fixation_end_us = device->next_gaze_time_us + STAND_IN_MIN_FIXATION_US +
+				static_cast<int64_t>((STAND_IN_MAX_FIXATION_US - STAND_IN_MIN_FIXATION_US) * stand_in_random(device));
+		}
+
+		gaze_point.position_xy[0] = device->fixation_x + STAND_IN_GAZE_JITTER * (stand_in_random(device) - 0.5f);
+		gaze_point.position_xy[1] = device->fixation_y + STAND_IN_GAZE_JITTER * (stand_in_random(device) - 0.5f);
+		device->next_gaze_time_us = device->start_time_us + static_cast<int64_t>(++device->n_gaze_samples * device->gaze_period_us);
+
+	} else {
+
+		const StandInSample& sample = device->gaze_samples[device->gaze_index++];
+		gaze_point.position_xy[0] = sample.position[0];
+		gaze_point.position_xy[1] = sample.position[1];
+		if (device->gaze_index < device->gaze_samples.size()) {
+			device->next_gaze_time_us = replay_time(device, device->gaze_samples[device->gaze_index].time_us);
+		}
+
+	}
+
+	device->gaze_callback(&gaze_point, device->gaze_user_data);
+
+}
+
+static void emit_head_sample(tobii_device_t* device) {
+
+	tobii_head_pose_t head_pose = {device->next_head_time_us, TOBII_VALIDITY_VALID, {0, 0, 0},
+		{TOBII_VALIDITY_INVALID, TOBII_VALIDITY_INVALID, TOBII_VALIDITY_INVALID}, {0, 0, 0}};
+
+	if (device->synthetic) {
+
+		// slow sway around the default head position
+		double time_s = (device->next_head_time_us - device->start_time_us) / 1000000.0;
+		head_pose.position_xyz[0] = static_cast<float>(20 * std::sin(0.3 * time_s));
+		head_pose.position_xyz[1] = static_cast<float>(10 * std::sin(0.2 * time_s));
+		head_pose.position_xyz[2] = static_cast<float>(STAND_IN_HEAD_DISTANCE_MM + 30 * std::sin(0.1 * time_s));
+		device->next_head_time_us = device->start_time_us + static_cast<int64_t>(++device->n_head_samples * device->head_period_us);
+
+	} else {
+
+		const StandInSample& sample = device->head_samples[device->head_index++];
+		std::copy(sample.position, sample.position + 3, head_pose.position_xyz);
+		if (device->head_index < device->head_samples.size()) {
+			device->next_head_time_us = replay_time(device, device->head_samples[device->head_index].time_us);
+		}
+
+	}
+
+	device->head_callback(&head_pose, device->head_user_data);
+
+}
+
+/*******************************************************************************
+* API & DEVICE
+******************************************************************************/
+
+tobii_error_t tobii_api_create(tobii_api_t** api, tobii_custom_alloc_t const* custom_alloc, tobii_custom_log_t const* custom_log) {
+	if (api == nullptr || custom_alloc != nullptr || custom_log != nullptr) return TOBII_ERROR_INVALID_PARAMETER;
+	*api = new tobii_api_t();
+	return TOBII_ERROR_NO_ERROR;
+}
+
+tobii_error_t tobii_api_destroy(tobii_api_t* api) {
+	if (api == nullptr) return TOBII_ERROR_INVALID_PARAMETER;
+	delete api;
+	return TOBII_ERROR_NO_ERROR;
+}
+
+tobii_error_t tobii_system_clock(tobii_api_t* api, int64_t* timestamp_us) {
+	if (api == nullptr || timestamp_us == nullptr) return TOBII_ERROR_INVALID_PARAMETER;
+	*timestamp_us = stand_in_clock_us();
+	return TOBII_ERROR_NO_ERROR;
+}
+
+tobii_error_t tobii_enumerate_local_device_urls(tobii_api_t* api, tobii_device_url_receiver_t receiver, void* user_data) {
+	if (api == nullptr || receiver == nullptr) return TOBII_ERROR_INVALID_PARAMETER;
+	receiver(STAND_IN_DEFAULT_URL, user_data);
+	return TOBII_ERROR_NO_ERROR;
+}
+
+tobii_error_t tobii_device_create(tobii_api_t* api, char const* url, tobii_field_of_use_t field_of_use, tobii_device_t** device) {
+
+	(void)field_of_use;
+	if (api == nullptr || url == nullptr || device == nullptr) return TOBII_ERROR_INVALID_PARAMETER;
+
+	// parsing the url (mode and params)
+	std::string url_str(url);
+	if (url_str.rfind(STAND_IN_URL_PREFIX, 0) != 0) return TOBII_ERROR_CONNECTION_FAILED;
+	url_str = url_str.substr(std::string(STAND_IN_URL_PREFIX).size());
+	size_t params_start = url_str.find('?');
+	std::string mode = url_str.substr(0, params_start);
+	std::map<std::string, std::string> params = parse_url_params((params_start == std::string::npos) ? "" : url_str.substr(params_start + 1));
+
+	tobii_device_t* new_device = new tobii_device_t();
+	new_device->api = api;
+
+	try {
+
+		if (mode == "synthetic") {
+
+			double gaze_hz = params.count("gaze_hz") ? std::stod(params["gaze_hz"]) : 90;
+			double head_hz = params.count("head_hz") ? std::stod(params["head_hz"]) : 30;
+			if (gaze_hz <= 0 || head_hz <= 0) throw std::invalid_argument("invalid rate");
+			new_device->gaze_period_us = 1000000.0 / gaze_hz;
+			new_device->head_period_us = 1000000.0 / head_hz;
+
+		} else if (mode == "replay") {
+
+			new_device->synthetic = false;
+			new_device->speed = params.count("speed") ? std::stod(params["speed"]) : 1;
+			new_device->loop = params.count("loop") && params["loop"] == "1";
+			if (new_device->speed <= 0) throw std::invalid_argument("invalid speed");
+
+			std::string folder = params["folder"];
+			if (!load_recorded_samples(folder + "/eye_tracker_gaze.csv", 2, new_device->gaze_samples) ||
+				!load_recorded_samples(folder + "/eye_tracker_head.csv", 3, new_device->head_samples)) {
+				throw std::invalid_argument("missing files");
+			}
+
+			// recording times relative to the first sample of both streams
+			int64_t first_time = INT64_MAX, last_time = INT64_MIN;
+			for (const std::vector<StandInSample>* samples : {&new_device->gaze_samples, &new_device->head_samples}) {
+				if (samples->empty()) continue;
+				first_time = std::min(first_time, samples->front().time_us);
+				last_time = std::max(last_time, samples->back().time_us);
+			}
+			if (first_time == INT64_MAX) throw std::invalid_argument("empty recording");
+
+			for (std::vector<StandInSample>* samples : {&new_device->gaze_samples, &new_device->head_samples}) {
+				for (StandInSample& sample : *samples) sample.time_us -= first_time;
+			}
+			new_device->replay_duration_us = last_time - first_time + 1;
+
+		} else {
+			throw std::invalid_argument("unknown mode");
+		}
+
+	} catch (...) {
+		delete new_device;
+		return TOBII_ERROR_CONNECTION_FAILED;
+	}
+
+	api->n_devices++;
+	*device = new_device;
+	return TOBII_ERROR_NO_ERROR;
+
+}
+
+tobii_error_t tobii_device_destroy(tobii_device_t* device) {
+	if (device == nullptr) return TOBII_ERROR_INVALID_PARAMETER;
+	device->api->n_devices--;
+	delete device;
+	return TOBII_ERROR_NO_ERROR;
+}
+
+/*******************************************************************************
+* CALLBACKS
+******************************************************************************/
+
+tobii_error_t tobii_wait_for_callbacks(int device_count, tobii_device_t* const* devices) {
+
+	if (device_count <= 0 || devices == nullptr) return TOBII_ERROR_INVALID_PARAMETER;
+
+	// waiting for the earliest sample of all devices (at most STAND_IN_MAX_WAIT_US)
+	int64_t now_us = stand_in_clock_us();
+	int64_t wake_up_us = now_us + STAND_IN_MAX_WAIT_US;
+	for (int i = 0; i < device_count; i++) {
+		if (devices[i] == nullptr) return TOBII_ERROR_INVALID_PARAMETER;
+		start_streams(devices[i]);
+		wake_up_us = std::min(wake_up_us, std::min(next_gaze_time(devices[i]), next_head_time(devices[i])));
+	}
+
+	bool timed_out = wake_up_us == now_us + STAND_IN_MAX_WAIT_US;
+	if (wake_up_us > now_us) std::this_thread::sleep_for(std::chrono::microseconds(wake_up_us - now_us));
+
+	return timed_out ? TOBII_ERROR_TIMED_OUT : TOBII_ERROR_NO_ERROR;
+
+}
+
+tobii_error_t tobii_device_process_callbacks(tobii_device_t* device) {
+
+	if (device == nullptr) return TOBII_ERROR_INVALID_PARAMETER;
+
+	// emitting the due samples in order
+	start_streams(device);
+	int64_t now_us = stand_in_clock_us();
+	while (true) {
+
+		if (!device->synthetic) restart_replay(device);
+
+		int64_t gaze_time = next_gaze_time(device);
+		int64_t head_time = next_head_time(device);
+		if (std::min(gaze_time, head_time) > now_us) break;
+
+		if (gaze_time <= head_time) emit_gaze_sample(device);
+		else emit_head_sample(device);
+
+	}
+
+	return TOBII_ERROR_NO_ERROR;
+
+}
+
+/*******************************************************************************
+* STREAMS
+******************************************************************************/
+
+tobii_error_t tobii_gaze_point_subscribe(tobii_device_t* device, tobii_gaze_point_callback_t callback, void* user_data) {
+	if (device == nullptr || callback == nullptr) return TOBII_ERROR_INVALID_PARAMETER;
+	if (device->gaze_callback != nullptr) return TOBII_ERROR_ALREADY_SUBSCRIBED;
+	device->gaze_callback = callback;
+	device->gaze_user_data = user_data;
+	return TOBII_ERROR_NO_ERROR;
+}
+
+tobii_error_t tobii_gaze_point_unsubscribe(tobii_device_t* device) {
+	if (device == nullptr) return TOBII_ERROR_INVALID_PARAMETER;
+	if (device->gaze_callback == nullptr) return TOBII_ERROR_NOT_SUBSCRIBED;
+	device->gaze_callback = nullptr;
+	device->gaze_user_data = nullptr;
+	return TOBII_ERROR_NO_ERROR;
+}
+
+tobii_error_t tobii_head_pose_subscribe(tobii_device_t* device, tobii_head_pose_callback_t callback, void* user_data) {
+	if (device == nullptr || callback == nullptr) return TOBII_ERROR_INVALID_PARAMETER;
+	if (device->head_callback != nullptr) return TOBII_ERROR_ALREADY_SUBSCRIBED;
+	device->head_callback = callback;
+	device->head_user_data = user_data;
+	return TOBII_ERROR_NO_ERROR;
+}
+
+tobii_error_t tobii_head_pose_unsubscribe(tobii_device_t* device) {
+	if (device == nullptr) return TOBII_ERROR_INVALID_PARAMETER;
+	if (device->head_callback == nullptr) return TOBII_ERROR_NOT_SUBSCRIBED;
+	device->head_callback = nullptr;
+	device->head_user_data = nullptr;
+	return TOBII_ERROR_NO_ERROR;
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+/*
+* Tobii Stream Engine stand-in (subset of the 4.x API used by SonoAssist, same declarations as the original tobii.h)
+*
+* The stand-in device replays recorded eye tracker data or synthesizes it, see TobiiStandIn.cpp for the supported device urls.
+*/
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct tobii_api_t tobii_api_t;
+typedef struct tobii_device_t tobii_device_t;
+
+// custom allocation / logging are not supported by the stand-in (NULL is expected)
+typedef struct tobii_custom_alloc_t tobii_custom_alloc_t;
+typedef struct tobii_custom_log_t tobii_custom_log_t;
+
+typedef enum tobii_error_t {
+	TOBII_ERROR_NO_ERROR,
+	TOBII_ERROR_INTERNAL,
+	TOBII_ERROR_INSUFFICIENT_LICENSE,
+	TOBII_ERROR_NOT_SUPPORTED,
+	TOBII_ERROR_NOT_AVAILABLE,
+	TOBII_ERROR_CONNECTION_FAILED,
+	TOBII_ERROR_TIMED_OUT,
+	TOBII_ERROR_ALLOCATION_FAILED,
+	TOBII_ERROR_INVALID_PARAMETER,
+	TOBII_ERROR_CALIBRATION_ALREADY_STARTED,
+	TOBII_ERROR_CALIBRATION_NOT_STARTED,
+	TOBII_ERROR_ALREADY_SUBSCRIBED,
+	TOBII_ERROR_NOT_SUBSCRIBED,
+	TOBII_ERROR_OPERATION_FAILED,
+	TOBII_ERROR_CONFLICTING_API_INSTANCES,
+	TOBII_ERROR_CALIBRATION_BUSY,
+	TOBII_ERROR_CALLBACK_IN_PROGRESS,
+	TOBII_ERROR_TOO_MANY_SUBSCRIBERS,
+	TOBII_ERROR_CONNECTION_FAILED_DRIVER,
+	TOBII_ERROR_UNAUTHORIZED
+} tobii_error_t;
+
+typedef enum tobii_validity_t {
+	TOBII_VALIDITY_INVALID = 0,
+	TOBII_VALIDITY_VALID = 1
+} tobii_validity_t;
+
+typedef enum tobii_field_of_use_t {
+	TOBII_FIELD_OF_USE_INTERACTIVE = 1,
+	TOBII_FIELD_OF_USE_ANALYTICAL = 2
+} tobii_field_of_use_t;
+
+typedef void (*tobii_device_url_receiver_t)(char const* url, void* user_data);
+
+tobii_error_t tobii_api_create(tobii_api_t** api, tobii_custom_alloc_t const* custom_alloc, tobii_custom_log_t const* custom_log);
+tobii_error_t tobii_api_destroy(tobii_api_t* api);
+tobii_error_t tobii_system_clock(tobii_api_t* api, int64_t* timestamp_us);
+
+tobii_error_t tobii_enumerate_local_device_urls(tobii_api_t* api, tobii_device_url_receiver_t receiver, void* user_data);
+tobii_error_t tobii_device_create(tobii_api_t* api, char const* url, tobii_field_of_use_t field_of_use, tobii_device_t** device);
+tobii_error_t tobii_device_destroy(tobii_device_t* device);
+
+tobii_error_t tobii_wait_for_callbacks(int device_count, tobii_device_t* const* devices);
+tobii_error_t tobii_device_process_callbacks(tobii_device_t* device);
+
+#ifdef __cplusplus
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+/*
+* Tobii Stream Engine stand-in (gaze point and head pose streams, same declarations as the original tobii_streams.h)
+*/
+
+#include "tobii.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct tobii_gaze_point_t {
+	int64_t timestamp_us;
+	tobii_validity_t validity;
+	float position_xy[2];
+} tobii_gaze_point_t;
+
+typedef void (*tobii_gaze_point_callback_t)(tobii_gaze_point_t const* gaze_point, void* user_data);
+
+tobii_error_t tobii_gaze_point_subscribe(tobii_device_t* device, tobii_gaze_point_callback_t callback, void* user_data);
+tobii_error_t tobii_gaze_point_unsubscribe(tobii_device_t* device);
+
+typedef struct tobii_head_pose_t {
+	int64_t timestamp_us;
+	tobii_validity_t position_validity;
+	float position_xyz[3];
+	tobii_validity_t rotation_validity_xyz[3];
+	float rotation_xyz[3];
+} tobii_head_pose_t;
+
+typedef void (*tobii_head_pose_callback_t)(tobii_head_pose_t const* head_pose, void* user_data);
+
+tobii_error_t tobii_head_pose_subscribe(tobii_device_t* device, tobii_head_pose_callback_t callback, void* user_data);
+tobii_error_t tobii_head_pose_unsubscribe(tobii_device_t* device);
+
+#ifdef __cplusplus
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+/**
+* Structure to encapsulates US image detection return data
+*/
+struct ImgDetectData {
+	bool detected;
+	float score;
+	cv::Mat mask;
+	cv::Rect bounding_box;
+};
+
+
+/**
+* Class for the implementation of automatic ultrasound shell shape detection 
+*/
+class USImgDetector {
+
+	public:
+
+		USImgDetector() {}
+
+		/*
+		* \param template_path The path to the template for Ultrasound shell shapes (image file)
+		*/
+		USImgDetector(const std::string& template_path);
+		
+		/*
+		* Attempts to detect a ultrasound shell shape contour inside of the provided image.
+		* Part of the detection process use the template provided in the constructor.
+		* 
+		* \param img The image for which to perform the detection
+		* \return The detection data (ImgDetectData)
+		*/
+		ImgDetectData detect(const cv::Mat& img);
+
+	private:
+
+		void find_large_contours(cv::Mat& img, std::vector<std::vector<cv::Point>>& contours);
+
+		int m_min_contour_size = 500;
+		float m_detection_tresh = 0.002;
+
+		cv::Mat m_template_img;
+		cv::Mat m_morph_kernel, m_horizontal_kernel;
+
+};
\ No newline at end of file
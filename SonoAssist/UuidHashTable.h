@@ -0,0 +1,114 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// initial number of slots (power of 2)
+#define UUID_TABLE_MIN_CAPACITY 16
+
+/**
+* 128 bit UUID, as two 64 bit words (no allocation, trivially comparable)
+*/
+struct Uuid128 {
+
+	uint64_t high = 0;
+	uint64_t low = 0;
+
+	bool operator==(const Uuid128& other) const {
+		return high == other.high && low == other.low;
+	}
+
+	/**
+	* \param bytes The 16 bytes of the UUID (big endian, as in quint128).
+	*/
+	static Uuid128 from_bytes(const uint8_t* bytes) {
+		Uuid128 uuid;
+		for (int i = 0; i < 8; i++) uuid.high = (uuid.high << 8) | bytes[i];
+		for (int i = 8; i < 16; i++) uuid.low = (uuid.low << 8) | bytes[i];
+		return uuid;
+	}
+
+};
+
+/**
+* Open addressing (linear probing) hash table keyed by 128 bit UUIDs.
+*
+* Entries are stored in a single flat array, lookups hash the key and scan a few contiguous slots without allocating.
+* Meant for small tables (a few BLE characteristics) that are read far more often than they are modified.
+*
+* \tparam T The value type.
+*/
+template <typename T>
+class UuidHashTable {
+
+	public:
+
+		UuidHashTable() {
+			m_slots.resize(UUID_TABLE_MIN_CAPACITY);
+		}
+
+		/**
+		* Inserts or replaces the value associated with the key.
+		*/
+		void insert(const Uuid128& key, const T& value) {
+
+			// keeping the load factor under 1/2 (short probe sequences)
+			if (2 * (m_size + 1) > m_slots.size()) rehash(2 * m_slots.size());
+
+			Slot& slot = m_slots[probe(key)];
+			if (!slot.used) m_size++;
+			slot = {true, key, value};
+
+		}
+
+		/**
+		* \return A pointer to the value associated with the key, nullptr if the key is not in the table.
+		*/
+		const T* find(const Uuid128& key) const {
+			const Slot& slot = m_slots[probe(key)];
+			return slot.used ? &slot.value : nullptr;
+		}
+
+		void clear(void) {
+			m_slots.assign(UUID_TABLE_MIN_CAPACITY, Slot());
+			m_size = 0;
+		}
+
+		size_t size(void) const { return m_size; }
+
+	private:
+
+		struct Slot {
+			bool used = false;
+			Uuid128 key;
+			T value = T();
+		};
+
+		static size_t hash(const Uuid128& key) {
+			uint64_t hash = (key.high ^ (key.low * 0x9E3779B97F4A7C15ULL)) * 0xBF58476D1CE4E5B9ULL;
+			return static_cast<size_t>(hash ^ (hash >> 31));
+		}
+
+		/**
+		* \return The index of the slot holding the key, or of the empty slot ending its probe sequence.
+		*/
+		size_t probe(const Uuid128& key) const {
+			size_t mask = m_slots.size() - 1;
+			size_t index = hash(key) & mask;
+			while (m_slots[index].used && !(m_slots[index].key == key)) index = (index + 1) & mask;
+			return index;
+		}
+
+		void rehash(size_t capacity) {
+			std::vector<Slot> old_slots(capacity);
+			old_slots.swap(m_slots);
+			for (const Slot& slot : old_slots) {
+				if (slot.used) m_slots[probe(slot.key)] = slot;
+			}
+		}
+
+		size_t m_size = 0;
+		std::vector<Slot> m_slots;
+
+};
\ No newline at end of file
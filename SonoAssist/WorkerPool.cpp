@@ -0,0 +1,104 @@
+#include "WorkerPool.h"
+
+/*******************************************************************************
+* CONSTRUCTOR & DESTRUCTOR
+******************************************************************************/
+
+WorkerPool::WorkerPool(int n_threads) {
+
+	if (n_threads < 1) n_threads = std::thread::hardware_concurrency();
+	m_n_threads = (n_threads < 1) ? 1 : n_threads;
+
+	// the calling thread is the first executor
+	for (auto i = 1; i < m_n_threads; i++) {
+		m_workers.emplace_back(&WorkerPool::worker_loop, this);
+	}
+
+}
+
+WorkerPool::~WorkerPool() {
+
+	{
+		std::lock_guard<std::mutex> pool_guard(m_pool_mtx);
+		m_stop = true;
+	}
+	m_task_cv.notify_all();
+
+	for (auto& worker : m_workers) worker.join();
+
+}
+
+int WorkerPool::get_n_threads(void) const {
+	return m_n_threads;
+}
+
+/*******************************************************************************
+* TASK EXECUTION
+******************************************************************************/
+
+void WorkerPool::run(int n_tasks, const std::function<void(int)>& task) {
+
+	if (n_tasks <= 0) return;
+
+	std::unique_lock<std::mutex> pool_lock(m_pool_mtx);
+
+	// publishing the tasks to the workers
+	m_task_p = &task;
+	m_n_tasks = n_tasks;
+	m_next_task = 0;
+	m_n_done_tasks = 0;
+	m_task_exception = nullptr;
+	m_task_cv.notify_all();
+
+	// executing tasks from the calling thread as well
+	while (m_next_task < m_n_tasks) {
+		execute_task(pool_lock, task, m_next_task++);
+	}
+
+	// waiting for the tasks still executed by the workers
+	m_done_cv.wait(pool_lock, [this] { return m_n_done_tasks == m_n_tasks; });
+
+	m_task_p = nullptr;
+	m_n_tasks = 0;
+	m_next_task = 0;
+
+	// reporting the failure of the run to the caller
+	std::exception_ptr task_exception = m_task_exception;
+	m_task_exception = nullptr;
+	if (task_exception) std::rethrow_exception(task_exception);
+
+}
+
+void WorkerPool::worker_loop(void) {
+
+	std::unique_lock<std::mutex> pool_lock(m_pool_mtx);
+
+	while (true) {
+
+		m_task_cv.wait(pool_lock, [this] { return m_stop || (m_next_task < m_n_tasks); });
+		if (m_stop) break;
+
+		// the task pointer is read under lock, it stays valid until all tasks of the run are done
+		execute_task(pool_lock, *m_task_p, m_next_task++);
+		if (m_n_done_tasks == m_n_tasks) m_done_cv.notify_all();
+
+	}
+
+}
+
+void WorkerPool::execute_task(std::unique_lock<std::mutex>& pool_lock, const std::function<void(int)>& task, int task_index) {
+
+	std::exception_ptr task_exception;
+
+	pool_lock.unlock();
+	try {
+		task(task_index);
+	} catch (...) {
+		task_exception = std::current_exception();
+	}
+	pool_lock.lock();
+
+	if (task_exception && !m_task_exception) m_task_exception = task_exception;
+	m_n_done_tasks++;
+
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+/**
+* Persistent pool of worker threads for the parallel execution of short, independent tasks (e.g. image tiles).
+*
+* The threads are created once (in the constructor) and wait for work between calls to (run).
+* The calling thread takes part in the execution, so a pool of (n_threads) creates (n_threads - 1) workers.
+*/
+class WorkerPool {
+
+	public:
+
+		/**
+		* \param n_threads The total number of threads executing the tasks (calling thread included).
+		*		 Values below 1 select the number of hardware threads.
+		*/
+		WorkerPool(int n_threads = 0);
+		~WorkerPool();
+
+		WorkerPool(const WorkerPool&) = delete;
+		WorkerPool& operator=(const WorkerPool&) = delete;
+
+		int get_n_threads(void) const;
+
+		/**
+		* Executes (task(i)) for every i in [0, n_tasks) and returns once all of the tasks are completed.
+		* The remaining tasks still run when a task throws, the first exception is then rethrown (once all tasks are completed).
+		*
+		* \param n_tasks The number of tasks to execute.
+		* \param task The function executing a single task, given its index.
+		*/
+		void run(int n_tasks, const std::function<void(int)>& task);
+
+	private:
+
+		/**
+		* Waits for tasks and executes them until the pool is destroyed.
+		*/
+		void worker_loop(void);
+
+		/**
+		* Executes a single task and marks it as done, the first exception of the run is kept in (m_task_exception).
+		* Must be called with (pool_lock) locked, which is released during the task.
+		*/
+		void execute_task(std::unique_lock<std::mutex>& pool_lock, const std::function<void(int)>& task, int task_index);
+
+		int m_n_threads = 1;
+		std::vector<std::thread> m_workers;
+
+		// task distribution vars (protected by m_pool_mtx)
+		bool m_stop = false;
+		int m_n_tasks = 0;
+		int m_next_task = 0;
+		int m_n_done_tasks = 0;
+		const std::function<void(int)>* m_task_p = nullptr;
+		std::exception_ptr m_task_exception;
+
+		std::mutex m_pool_mtx;
+		std::condition_variable m_task_cv;
+		std::condition_variable m_done_cv;
+
+};
\ No newline at end of file
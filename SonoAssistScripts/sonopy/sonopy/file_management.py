@@ -2,6 +2,7 @@ import os
 import json
 import copy
 import os.path
+import numpy as np
 import pandas as pd
 
 
@@ -18,12 +19,29 @@ class SonoFolderManager:
         "eyetracker_gaze" : "eye_tracker_gaze.csv",
         "eyetracker_head" : "eye_tracker_head.csv",
         "rgbd_video" : "RGBD_camera_data.bag",
-        "rgbd_index" : "RGBD_camera_index.csv",
+        "rgbd_index" : "RGBD_camera_index.bin",
         "screen_rec_data" : "screen_recorder_data.csv",
         "screen_rec_video" : "screen_recorder_images.avi",
         "output_params" : "sono_assist_output_params.json"
     }
 
+    # defining the record format of the binary RGBD index (after a 16 bytes header)
+    rgbd_index_header_size = 16
+    rgbd_index_magic = b"SARGBDIX"
+    rgbd_index_dtype = np.dtype([
+        ("Time (us)", "<i8"),
+        ("Color frame number", "<u8"),
+        ("Depth frame number", "<u8"),
+        ("Color timestamp (ms)", "<f8"),
+        ("Depth timestamp (ms)", "<f8"),
+        ("Color hardware timestamp (us)", "<i8"),
+        ("Depth hardware timestamp (us)", "<i8"),
+        ("Color timestamp domain", "<u4"),
+        ("Depth timestamp domain", "<u4"),
+        ("Color dropped frames", "<u4"),
+        ("Depth dropped frames", "<u4")
+    ])
+
     
     def __init__(self, acq_folder_path):
 
@@ -100,7 +118,25 @@ class SonoFolderManager:
 
         camera_data = None
         try:
-            camera_data = self.check_loaded_data(pd.read_csv(self.folder_file_paths["rgbd_index"]))
+            
+            # checking the index header
+            with open(self.folder_file_paths["rgbd_index"], "rb") as index_file:
+                header = index_file.read(self.rgbd_index_header_size)
+            valid_magic = header[:8] == self.rgbd_index_magic
+            valid_record_size = int.from_bytes(header[12:16], "little") == self.rgbd_index_dtype.itemsize
+            
+            # mapping the complete records (no copy) and wrapping them in a data frame
+            # a header-only index (no recorded frame) cannot be mapped, it gives an empty data frame
+            if valid_magic and valid_record_size:
+                index_size = os.path.getsize(self.folder_file_paths["rgbd_index"])
+                n_records = (index_size - self.rgbd_index_header_size) // self.rgbd_index_dtype.itemsize
+                if n_records > 0:
+                    records = np.memmap(self.folder_file_paths["rgbd_index"], dtype=self.rgbd_index_dtype,
+                        mode="r", offset=self.rgbd_index_header_size, shape=(n_records,))
+                    camera_data = self.check_loaded_data(pd.DataFrame(records))
+                else:
+                    camera_data = pd.DataFrame(np.empty(0, dtype=self.rgbd_index_dtype))
+
         except: pass
 
         return camera_data